@@ -39,6 +39,8 @@
 #include "core/UBSetting.h"
 #include "core/UBPersistenceManager.h"
 
+#include "adaptors/UBExportSceneLoader.h"
+
 #include "domain/UBGraphicsScene.h"
 #include "domain/UBGraphicsSvgItem.h"
 #include "domain/UBGraphicsPDFItem.h"
@@ -105,9 +107,31 @@ void UBExportFullPDF::saveOverlayPdf(std::shared_ptr<UBDocumentProxy> pDocumentP
 
         QPainter* pdfPainter = 0;
 
-        for(int pageIndex = 0 ; pageIndex < pDocumentProxy->pageCount(); pageIndex++)
+        UBExportSceneLoader sceneLoader(pDocumentProxy);
+        const int existingPageCount = sceneLoader.pageCount();
+
+        for(int pageIndex = 0 ; pageIndex < existingPageCount; pageIndex++)
         {
-            std::shared_ptr<UBGraphicsScene> scene = UBPersistenceManager::persistenceManager()->loadDocumentScene(pDocumentProxy, pageIndex);
+            std::shared_ptr<UBGraphicsScene> scene = sceneLoader.scene(pageIndex);
+            UBApplication::showMessage(tr("Exporting page %1 of %2").arg(pageIndex + 1).arg(existingPageCount));
+
+            if (!scene)
+            {
+                // keep the overlay pages matching the document pages
+                qWarning() << "could not read page" << pageIndex << "for PDF export";
+
+                PageMergeInfo mergeInfo = {QString(), 0, QRectF(), QRectF(), QSizeF(pDocumentProxy->defaultDocumentSize()) * mScaleFactor};
+                mPageMergeInfo << mergeInfo;
+
+                pdfPrinter.setPageSize(QPageSize(mergeInfo.pageSize, QPageSize::Point));
+
+                if (!pdfPainter) pdfPainter = new QPainter(&pdfPrinter);
+
+                if (pageIndex != 0) pdfPrinter.newPage();
+
+                continue;
+            }
+
             // set background according to PDF export settings
             bool isDark = scene->isDarkBackground();
             UBPageBackground pageBackground = scene->pageBackground();
@@ -131,10 +155,19 @@ void UBExportFullPDF::saveOverlayPdf(std::shared_ptr<UBDocumentProxy> pDocumentP
                 mHasPDFBackgrounds = true;
                 sceneHasPDFBackground = true;
                 pageSize = pdfItem->pageSize();     // original PDF document page size
+
+                QString pdfName = UBPersistenceManager::objectDirectory + "/" + pdfItem->fileUuid().toString() + ".pdf";
+
+                PageMergeInfo mergeInfo = {pDocumentProxy->persistencePath() + "/" + pdfName, pdfItem->pageNumber(),
+                                           pdfItem->sceneBoundingRect(), scene->normalizedSceneRect(), pageSize};
+                mPageMergeInfo << mergeInfo;
             }
             else
             {
                 sceneHasPDFBackground = false;
+
+                PageMergeInfo mergeInfo = {QString(), 0, QRectF(), QRectF(), scene->nominalSize() * mScaleFactor};
+                mPageMergeInfo << mergeInfo;
             }
 
             QPageSize size(pageSize, QPageSize::Point);
@@ -169,6 +202,9 @@ void UBExportFullPDF::saveOverlayPdf(std::shared_ptr<UBDocumentProxy> pDocumentP
             //restore background state
             scene->setDrawingMode(false);
             scene->setBackground(isDark, pageBackground);
+
+            // keep the board painted
+            QCoreApplication::processEvents(QEventLoop::ExcludeUserInputEvents);
         }
 
         if (pdfPainter) delete pdfPainter;
@@ -199,6 +235,7 @@ bool UBExportFullPDF::persistsDocument(std::shared_ptr<UBDocumentProxy> pDocumen
         previousOverlay.remove();
 
     mHasPDFBackgrounds = false;
+    mPageMergeInfo.clear();
 
     saveOverlayPdf(pDocumentProxy, overlayName);
 
@@ -219,21 +256,18 @@ bool UBExportFullPDF::persistsDocument(std::shared_ptr<UBDocumentProxy> pDocumen
             // factor between scene coordinates and PDF coordinates
             double dpiScale = 72. / pDocumentProxy->pageDpi();
 
-            int existingPageCount = pDocumentProxy->pageCount();
-
-            for(int pageIndex = 0 ; pageIndex < existingPageCount; pageIndex++)
+            // the pages were read while rendering the overlay, they are not loaded again
+            for(int pageIndex = 0 ; pageIndex < mPageMergeInfo.size(); pageIndex++)
             {
-                std::shared_ptr<UBGraphicsScene> scene = UBPersistenceManager::persistenceManager()->loadDocumentScene(pDocumentProxy, pageIndex);
-                UBGraphicsPDFItem *pdfItem = qgraphicsitem_cast<UBGraphicsPDFItem*>(scene->backgroundObject());
+                const PageMergeInfo& pageInfo = mPageMergeInfo.at(pageIndex);
 
-                if (pdfItem)
+                if (!pageInfo.backgroundPath.isEmpty())
                 {
-                    QString pdfName = UBPersistenceManager::objectDirectory + "/" + pdfItem->fileUuid().toString() + ".pdf";
-                    QString backgroundPath = pDocumentProxy->persistencePath() + "/" + pdfName;
+                    QString backgroundPath = pageInfo.backgroundPath;
 
                     // Original data in scene coordinates, annotationsRect always contains pdfSceneRect
-                    QRectF pdfSceneRect = pdfItem->sceneBoundingRect();
-                    QRectF annotationsRect = scene->normalizedSceneRect();
+                    QRectF pdfSceneRect = pageInfo.pdfSceneRect;
+                    QRectF annotationsRect = pageInfo.annotationsRect;
 
                     double xAnnotation = annotationsRect.x();
                     double yAnnotation = annotationsRect.y();
@@ -253,7 +287,7 @@ bool UBExportFullPDF::persistsDocument(std::shared_ptr<UBDocumentProxy> pDocumen
                     // Compute scaling of PDF on the scene
                     // If the PDF was scaled when added to the scene (e.g if it was loaded from a document with a different DPI
                     // than the current one), it should also be scaled here.
-                    QSizeF pageSize = pdfItem->pageSize();
+                    QSizeF pageSize = pageInfo.pageSize;
                     double pdfScale = pdfSceneRect.width() / pageSize.width() * dpiScale;
 
                     // Offsets are calculated in the PDF coordinate system.
@@ -271,7 +305,7 @@ bool UBExportFullPDF::persistsDocument(std::shared_ptr<UBDocumentProxy> pDocumen
 
                     MergePageDescription pageDescription(pageSize.width(),
                                                          pageSize.height(),
-                                                         pdfItem->pageNumber(),
+                                                         pageInfo.backgroundPageNumber,
                                                          QFile::encodeName(backgroundPath).constData(),
                                                          pdfTransform,
                                                          pageIndex + 1,
@@ -284,7 +318,7 @@ bool UBExportFullPDF::persistsDocument(std::shared_ptr<UBDocumentProxy> pDocumen
                 }
                 else
                 {
-                    QSizeF pageSize = scene->nominalSize() * mScaleFactor;
+                    QSizeF pageSize = pageInfo.pageSize;
 
                     MergePageDescription pageDescription(pageSize.width(),
                              pageSize.height(),
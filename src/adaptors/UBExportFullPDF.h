@@ -55,8 +55,19 @@ class UBExportFullPDF : public UBExportAdaptor
         void saveOverlayPdf(std::shared_ptr<UBDocumentProxy> pDocumentProxy, const QString& filename);
 
     private:
+        // what the merge needs to know of a page, taken while rendering the overlay
+        struct PageMergeInfo
+        {
+            QString backgroundPath;     // empty if the page has no PDF background
+            int backgroundPageNumber;
+            QRectF pdfSceneRect;
+            QRectF annotationsRect;
+            QSizeF pageSize;
+        };
+
         float mScaleFactor;
         bool mHasPDFBackgrounds;
+        QList<PageMergeInfo> mPageMergeInfo;
 
         UBExportPDF * mSimpleExporter;
 };
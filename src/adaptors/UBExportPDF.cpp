@@ -40,6 +40,8 @@
 #include "core/UBSetting.h"
 #include "core/UBPersistenceManager.h"
 
+#include "adaptors/UBExportSceneLoader.h"
+
 #include "domain/UBGraphicsScene.h"
 #include "domain/UBGraphicsSvgItem.h"
 #include "domain/UBGraphicsPDFItem.h"
@@ -97,13 +99,20 @@ bool UBExportPDF::persistsDocument(std::shared_ptr<UBDocumentProxy> pDocumentPro
     QPainter pdfPainter;
     bool painterNeedsBegin = true;
 
-    int existingPageCount = pDocumentProxy->pageCount();
+    UBExportSceneLoader sceneLoader(pDocumentProxy);
+    int existingPageCount = sceneLoader.pageCount();
 
     for(int pageIndex = 0 ; pageIndex < existingPageCount; pageIndex++) {
 
-        std::shared_ptr<UBGraphicsScene> scene = UBPersistenceManager::persistenceManager()->loadDocumentScene(pDocumentProxy, pageIndex);
+        std::shared_ptr<UBGraphicsScene> scene = sceneLoader.scene(pageIndex);
         UBApplication::showMessage(tr("Exporting page %1 of %2").arg(pageIndex + 1).arg(existingPageCount));
 
+        if (!scene)
+        {
+            qWarning() << "could not read page" << pageIndex << "for PDF export";
+            continue;
+        }
+
         // set background to white, no crossing for PDF output
         bool isDark = scene->isDarkBackground();
         UBPageBackground pageBackground = scene->pageBackground();
@@ -147,6 +156,9 @@ bool UBExportPDF::persistsDocument(std::shared_ptr<UBDocumentProxy> pDocumentPro
 
         // Restore background state
         scene->setBackground(isDark, pageBackground);
+
+        // keep the board painted
+        QCoreApplication::processEvents(QEventLoop::ExcludeUserInputEvents);
     }
 
     if(!painterNeedsBegin)
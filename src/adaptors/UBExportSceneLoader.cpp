@@ -0,0 +1,147 @@
+/*
+ * Copyright (C) 2015-2022 Département de l'Instruction Publique (DIP-SEM)
+ *
+ * Copyright (C) 2013 Open Education Foundation
+ *
+ * Copyright (C) 2010-2013 Groupement d'Intérêt Public pour
+ * l'Education Numérique en Afrique (GIP ENA)
+ *
+ * This file is part of OpenBoard.
+ *
+ * OpenBoard is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3 of the License,
+ * with a specific linking exception for the OpenSSL project's
+ * "OpenSSL" library (or with modified versions of it that use the
+ * same license as the "OpenSSL" library).
+ *
+ * OpenBoard is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with OpenBoard. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+
+
+
+
+
+#include "UBExportSceneLoader.h"
+
+#include <QtConcurrent>
+
+#include "core/UBPersistenceManager.h"
+
+#include "document/UBDocumentProxy.h"
+
+#include "domain/UBGraphicsScene.h"
+
+#include "core/memcheck.h"
+
+UBExportSceneLoader::UBExportSceneLoader(std::shared_ptr<UBDocumentProxy> document)
+    : mDocument(document)
+    , mPageCount(document ? document->pageCount() : 0)
+    , mNextPreload(0)
+{
+    // the export waits for the pages, use all cores
+    mThreadPool.setMaxThreadCount(QThread::idealThreadCount());
+}
+
+UBExportSceneLoader::~UBExportSceneLoader()
+{
+    foreach (QFutureWatcher<UBSvgSubsetAdaptor::UBSvgPreloadedData>* watcher, mPreloads)
+    {
+        watcher->waitForFinished();
+        delete watcher;
+    }
+}
+
+std::shared_ptr<UBGraphicsScene> UBExportSceneLoader::scene(int pageIndex)
+{
+    if (pageIndex < 0 || pageIndex >= mPageCount)
+    {
+        return nullptr;
+    }
+
+    preloadAhead(pageIndex);
+
+    QFutureWatcher<UBSvgSubsetAdaptor::UBSvgPreloadedData>* watcher = mPreloads.take(pageIndex);
+
+    if (UBPersistenceManager::persistenceManager()->isSceneInCached(mDocument, pageIndex))
+    {
+        // the cached scene may have changes not persisted yet
+        if (watcher)
+        {
+            watcher->waitForFinished();
+            delete watcher;
+        }
+
+        return UBPersistenceManager::persistenceManager()->loadDocumentScene(mDocument, pageIndex, false);
+    }
+
+    UBSvgSubsetAdaptor::UBSvgPreloadedData data;
+
+    if (watcher)
+    {
+        if (!watcher->isFinished())
+        {
+            QEventLoop loop;
+            QObject::connect(watcher, &QFutureWatcher<UBSvgSubsetAdaptor::UBSvgPreloadedData>::finished, &loop, &QEventLoop::quit);
+
+            if (!watcher->isFinished())
+                loop.exec(QEventLoop::ExcludeUserInputEvents);
+        }
+
+        data = watcher->result();
+        delete watcher;
+    }
+    else
+    {
+        // the page was evicted from the cache after the read ahead
+        data = UBSvgSubsetAdaptor::preloadScene(mDocument->persistencePath(), pageIndex);
+    }
+
+    if (data.tokens.isEmpty())
+    {
+        return nullptr;
+    }
+
+    UBSvgSubsetAdaptor::UBSvgReaderContext context(mDocument, data);
+
+    while (!context.isFinished())
+    {
+        context.step();
+    }
+
+    return context.scene();
+}
+
+void UBExportSceneLoader::preloadAhead(int pageIndex)
+{
+    // decoded pages are kept in memory until exported, read ahead only as far as there are threads
+    const int lastPage = qMin(mPageCount, pageIndex + 1 + mThreadPool.maxThreadCount());
+
+    mNextPreload = qMax(mNextPreload, pageIndex);
+
+    for (; mNextPreload < lastPage; ++mNextPreload)
+    {
+        if (UBPersistenceManager::persistenceManager()->isSceneInCached(mDocument, mNextPreload))
+        {
+            continue;
+        }
+
+        const QString documentPath = mDocument->persistencePath();
+        const int preloadIndex = mNextPreload;
+
+        QFutureWatcher<UBSvgSubsetAdaptor::UBSvgPreloadedData>* watcher = new QFutureWatcher<UBSvgSubsetAdaptor::UBSvgPreloadedData>;
+        watcher->setFuture(QtConcurrent::run(&mThreadPool, [documentPath, preloadIndex](){
+            return UBSvgSubsetAdaptor::preloadScene(documentPath, preloadIndex);
+        }));
+
+        mPreloads.insert(preloadIndex, watcher);
+    }
+}
@@ -0,0 +1,78 @@
+/*
+ * Copyright (C) 2015-2022 Département de l'Instruction Publique (DIP-SEM)
+ *
+ * Copyright (C) 2013 Open Education Foundation
+ *
+ * Copyright (C) 2010-2013 Groupement d'Intérêt Public pour
+ * l'Education Numérique en Afrique (GIP ENA)
+ *
+ * This file is part of OpenBoard.
+ *
+ * OpenBoard is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3 of the License,
+ * with a specific linking exception for the OpenSSL project's
+ * "OpenSSL" library (or with modified versions of it that use the
+ * same license as the "OpenSSL" library).
+ *
+ * OpenBoard is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with OpenBoard. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+
+
+
+
+
+#ifndef UBEXPORTSCENELOADER_H
+#define UBEXPORTSCENELOADER_H
+
+#include <QFutureWatcher>
+#include <QMap>
+#include <QThreadPool>
+
+#include <memory>
+
+#include "adaptors/UBSvgSubsetAdaptor.h"
+
+class UBDocumentProxy;
+class UBGraphicsScene;
+
+/**
+ * Provides the pages of a document to an exporter, in order.
+ *
+ * Pages in the scene cache are taken from there. The other pages are read, parsed and their
+ * images decoded on a thread pool ahead of the page being exported, then attached on
+ * the GUI thread without being inserted into the cache, so that exporting a long
+ * document neither evicts the pages being worked on nor leaves the exported ones behind.
+ *
+ * Events are processed while waiting for a page, so the board keeps being painted.
+ */
+class UBExportSceneLoader
+{
+    public:
+        UBExportSceneLoader(std::shared_ptr<UBDocumentProxy> document);
+        ~UBExportSceneLoader();
+
+        int pageCount() const { return mPageCount; }
+
+        // pages are expected in increasing order, returns null if the page cannot be read
+        std::shared_ptr<UBGraphicsScene> scene(int pageIndex);
+
+    private:
+        void preloadAhead(int pageIndex);
+
+        std::shared_ptr<UBDocumentProxy> mDocument;
+        int mPageCount;
+        int mNextPreload;
+        QMap<int, QFutureWatcher<UBSvgSubsetAdaptor::UBSvgPreloadedData>*> mPreloads;
+        QThreadPool mThreadPool;
+};
+
+#endif // UBEXPORTSCENELOADER_H
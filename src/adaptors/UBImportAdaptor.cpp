@@ -54,6 +54,15 @@ UBPageBasedImportAdaptor::UBPageBasedImportAdaptor(QObject *parent)
     // NOOP
 }
 
+UBPageImporter* UBPageBasedImportAdaptor::createPageImporter(std::shared_ptr<UBDocumentProxy> document, const QUuid& uuid, const QString& filePath)
+{
+    Q_UNUSED(document);
+    Q_UNUSED(uuid);
+    Q_UNUSED(filePath);
+
+    return nullptr;
+}
+
 UBDocumentBasedImportAdaptor::UBDocumentBasedImportAdaptor(QObject *parent)
     :UBImportAdaptor(true, parent)
 {
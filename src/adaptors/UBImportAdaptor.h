@@ -35,6 +35,7 @@
 class UBGraphicsItem;
 class UBGraphicsScene;
 class UBDocumentProxy;
+class UBPageImporter;
 
 class UBImportAdaptor : public QObject
 {
@@ -64,6 +65,10 @@ public:
         virtual QList<UBGraphicsItem*> import(const QUuid& uuid, const QString& filePath) = 0;
         virtual void placeImportedItemToScene(std::shared_ptr<UBGraphicsScene> scene, UBGraphicsItem* item) = 0;
         virtual const QString& folderToCopy() = 0;
+
+        // adaptors creating their pages one at a time import them in the background,
+        // returns nullptr to create all pages with import()
+        virtual UBPageImporter* createPageImporter(std::shared_ptr<UBDocumentProxy> document, const QUuid& uuid, const QString& filePath);
 };
 
 class UBDocumentBasedImportAdaptor : public UBImportAdaptor
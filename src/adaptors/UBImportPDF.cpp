@@ -32,6 +32,7 @@
 #include "document/UBDocumentProxy.h"
 
 #include "core/UBApplication.h"
+#include "core/UBPageImporter.h"
 #include "core/UBPersistenceManager.h"
 
 #include "domain/UBGraphicsPDFItem.h"
@@ -40,6 +41,48 @@
 
 #include "core/memcheck.h"
 
+namespace
+{
+    class UBPDFPageImporter : public UBPageImporter
+    {
+        public:
+            UBPDFPageImporter(std::shared_ptr<UBDocumentProxy> document, UBImportPDF* adaptor, PDFRenderer* renderer)
+                : UBPageImporter(document, renderer->pageCount())
+                , mAdaptor(adaptor)
+                , mRenderer(renderer)
+            {
+                // kept alive until the thumbnails are rendered, even if the scenes are gone
+                mRenderer->attach();
+            }
+
+            virtual ~UBPDFPageImporter()
+            {
+                waitForThumbnails();
+                mRenderer->detach();
+            }
+
+        protected:
+            virtual UBGraphicsItem* createPageItem(int pageIndex) override
+            {
+                return new UBGraphicsPDFItem(mRenderer, pageIndex + 1); // deleted by the scene
+            }
+
+            virtual void placePageItem(std::shared_ptr<UBGraphicsScene> scene, UBGraphicsItem* item) override
+            {
+                mAdaptor->placeImportedItemToScene(scene, item);
+            }
+
+            virtual QImage renderThumbnail(int pageIndex, int width) override
+            {
+                return mRenderer->renderThumbnail(pageIndex + 1, width);
+            }
+
+        private:
+            UBImportPDF* mAdaptor;
+            PDFRenderer* mRenderer;
+    };
+}
+
 UBImportPDF::UBImportPDF(QObject *parent)
     : UBPageBasedImportAdaptor(parent)
 {
@@ -98,6 +141,19 @@ void UBImportPDF::placeImportedItemToScene(std::shared_ptr<UBGraphicsScene> scen
     scene->setNominalSize(pdfItem->boundingRect().width(), pdfItem->boundingRect().height());
 }
 
+UBPageImporter* UBImportPDF::createPageImporter(std::shared_ptr<UBDocumentProxy> document, const QUuid& uuid, const QString& filePath)
+{
+    PDFRenderer *pdfRenderer = PDFRenderer::rendererForUuid(uuid, filePath, true); // renderer is automatically deleted when not used anymore
+
+    if (!pdfRenderer->isValid() || pdfRenderer->pageCount() == 0)
+    {
+        // reported by import()
+        return nullptr;
+    }
+
+    return new UBPDFPageImporter(document, this, pdfRenderer);
+}
+
 const QString& UBImportPDF::folderToCopy()
 {
     return UBPersistenceManager::objectDirectory;
@@ -49,6 +49,7 @@ class UBImportPDF : public UBPageBasedImportAdaptor
         virtual QList<UBGraphicsItem*> import(const QUuid& uuid, const QString& filePath);
         virtual void placeImportedItemToScene(std::shared_ptr<UBGraphicsScene> scene, UBGraphicsItem* item);
         virtual const QString& folderToCopy();
+        virtual UBPageImporter* createPageImporter(std::shared_ptr<UBDocumentProxy> document, const QUuid& uuid, const QString& filePath);
 };
 
 #endif /* UBIMPORTPDF_H_ */
@@ -39,6 +39,10 @@
 
 #include "document/UBDocumentProxy.h"
 
+#include "frameworks/UBAtomicFileBatch.h"
+
+#include "UBThumbnailPack.h"
+
 #include "core/memcheck.h"
 
 const QString UBMetadataDcSubsetAdaptor::nsRdf = "http://www.w3.org/1999/02/22-rdf-syntax-ns#";
@@ -89,15 +93,10 @@ void UBMetadataDcSubsetAdaptor::persist(std::shared_ptr<UBDocumentProxy> proxy)
     }
     QString fileName = proxy->persistencePath() + "/" + metadataFilename;
     qInfo() << "Persisting document metadata; path is" << fileName;
-    QFile file(fileName);
-    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate))
-    {
-        qCritical() << "cannot open " << fileName << " for writing ...";
-        qCritical() << "error : "  << file.errorString();
-        return;
-    }
+    QBuffer buffer;
+    buffer.open(QBuffer::WriteOnly);
 
-    QXmlStreamWriter xmlWriter(&file);
+    QXmlStreamWriter xmlWriter(&buffer);
     xmlWriter.setAutoFormatting(true);
 
     xmlWriter.writeStartDocument();
@@ -130,8 +129,17 @@ void UBMetadataDcSubsetAdaptor::persist(std::shared_ptr<UBDocumentProxy> proxy)
 
     xmlWriter.writeEndDocument();
 
-    file.flush();
-    file.close();
+    // the thumbnail pack is stamped with the metadata file, it stays valid when this version rewrites it
+    const bool packIsCurrent = UBThumbnailPack::isCurrent(proxy->persistencePath());
+
+    if (!UBAtomicFileBatch::writeFile(fileName, buffer.data()))
+    {
+        qCritical() << "cannot write " << fileName;
+    }
+    else if (packIsCurrent)
+    {
+        UBThumbnailPack::restamp(proxy->persistencePath());
+    }
 }
 
 
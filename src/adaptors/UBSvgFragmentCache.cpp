@@ -0,0 +1,90 @@
+/*
+ * Copyright (C) 2015-2022 Département de l'Instruction Publique (DIP-SEM)
+ *
+ * Copyright (C) 2013 Open Education Foundation
+ *
+ * Copyright (C) 2010-2013 Groupement d'Intérêt Public pour
+ * l'Education Numérique en Afrique (GIP ENA)
+ *
+ * This file is part of OpenBoard.
+ *
+ * OpenBoard is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3 of the License,
+ * with a specific linking exception for the OpenSSL project's
+ * "OpenSSL" library (or with modified versions of it that use the
+ * same license as the "OpenSSL" library).
+ *
+ * OpenBoard is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with OpenBoard. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+
+
+
+
+#include "UBSvgFragmentCache.h"
+
+#include <QCryptographicHash>
+
+#include "domain/UBGraphicsStrokesGroup.h"
+
+#include "core/UB.h"
+
+#include "core/memcheck.h"
+
+namespace
+{
+    template<typename T>
+    void addValue(QCryptographicHash& hash, const T& value)
+    {
+        hash.addData(QByteArray::fromRawData(reinterpret_cast<const char*>(&value), sizeof(value)));
+    }
+
+    void addTransform(QCryptographicHash& hash, const QTransform& transform)
+    {
+        addValue(hash, transform.m11());
+        addValue(hash, transform.m12());
+        addValue(hash, transform.m13());
+        addValue(hash, transform.m21());
+        addValue(hash, transform.m22());
+        addValue(hash, transform.m23());
+        addValue(hash, transform.m31());
+        addValue(hash, transform.m32());
+        addValue(hash, transform.m33());
+    }
+}
+
+QByteArray UBSvgFragmentCache::fingerprint(UBGraphicsStrokesGroup* strokesGroup)
+{
+    // the group attributes the writer puts into the group element, the strokes are covered
+    // by the revision of the group, so that the points are not visited at each save
+    QCryptographicHash hash(QCryptographicHash::Md5);
+
+    addTransform(hash, strokesGroup->sceneTransform());
+    addValue(hash, strokesGroup->zValue());
+    addValue(hash, strokesGroup->data(UBGraphicsItemData::ItemLocked).toBool());
+    addValue(hash, strokesGroup->data(UBGraphicsItemData::ItemIsHiddenOnDisplay).toBool());
+    addValue(hash, strokesGroup->data(UBGraphicsItemData::ItemLayerType).toInt());
+    addValue(hash, strokesGroup->revision());
+
+    return hash.result();
+}
+
+UBSvgFragmentCache::Fragment UBSvgFragmentCache::fragment(const QUuid& uuid) const
+{
+    QMutexLocker locker(&mMutex);
+    return mFragments.value(uuid);
+}
+
+void UBSvgFragmentCache::setFragments(const QHash<QUuid, Fragment>& fragments)
+{
+    QMutexLocker locker(&mMutex);
+    mFragments = fragments;
+}
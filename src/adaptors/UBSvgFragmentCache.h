@@ -0,0 +1,81 @@
+/*
+ * Copyright (C) 2015-2022 Département de l'Instruction Publique (DIP-SEM)
+ *
+ * Copyright (C) 2013 Open Education Foundation
+ *
+ * Copyright (C) 2010-2013 Groupement d'Intérêt Public pour
+ * l'Education Numérique en Afrique (GIP ENA)
+ *
+ * This file is part of OpenBoard.
+ *
+ * OpenBoard is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3 of the License,
+ * with a specific linking exception for the OpenSSL project's
+ * "OpenSSL" library (or with modified versions of it that use the
+ * same license as the "OpenSSL" library).
+ *
+ * OpenBoard is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with OpenBoard. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+
+
+
+
+
+#ifndef UBSVGFRAGMENTCACHE_H
+#define UBSVGFRAGMENTCACHE_H
+
+#include <QByteArray>
+#include <QHash>
+#include <QMutex>
+#include <QUuid>
+
+class UBGraphicsStrokesGroup;
+
+/**
+ * Keeps the SVG written for each strokes group of a page at the last save.
+ *
+ * A strokes group whose fingerprint did not change since then is not copied for
+ * the persistence worker, its fragment is written instead. The fingerprint covers
+ * the attributes of the group and its revision, which changes whenever one of its
+ * strokes is modified, so that it takes the same time for any number of points. The cache is shared by
+ * a scene and its persistence copies and is filled by the persistence worker.
+ */
+class UBSvgFragmentCache
+{
+    public:
+        struct Fragment
+        {
+            QByteArray fingerprint;
+            QByteArray xml;
+        };
+
+        // strokes group which was not copied for saving
+        struct ReusedFragment
+        {
+            QUuid uuid;
+            qreal zValue;
+            Fragment fragment;
+        };
+
+        static QByteArray fingerprint(UBGraphicsStrokesGroup* strokesGroup);
+
+        Fragment fragment(const QUuid& uuid) const;
+
+        // replaces the cached fragments, dropping those of deleted strokes
+        void setFragments(const QHash<QUuid, Fragment>& fragments);
+
+    private:
+        mutable QMutex mMutex;
+        QHash<QUuid, Fragment> mFragments;
+};
+
+#endif // UBSVGFRAGMENTCACHE_H
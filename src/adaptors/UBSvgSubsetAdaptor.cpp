@@ -46,6 +46,7 @@
 #include "domain/UBGraphicsTextItem.h"
 #include "domain/UBGraphicsTextItemDelegate.h"
 #include "domain/UBGraphicsStroke.h"
+#include "domain/UBGraphicsStrokeItem.h"
 #include "domain/UBGraphicsStrokesGroup.h"
 #include "domain/UBGraphicsGroupContainerItem.h"
 #include "domain/UBGraphicsGroupContainerItemDelegate.h"
@@ -67,6 +68,7 @@
 #include "board/UBBoardPaletteManager.h"
 
 #include "frameworks/UBFileSystemUtils.h"
+#include "frameworks/UBAtomicFileBatch.h"
 #include "frameworks/UBStringUtils.h"
 #include "frameworks/UBFileSystemUtils.h"
 
@@ -145,6 +147,177 @@ static bool itemZIndexComp(const QGraphicsItem* item1,
 }
 
 
+static inline bool isSvgWhitespace(const QChar c)
+{
+    return c == QLatin1Char(' ') || c == QLatin1Char('\t') || c == QLatin1Char('\n') || c == QLatin1Char('\r');
+}
+
+
+/**
+ * Decode one coordinate. Plain decimals ([sign]digits[.digits], as written by
+ * UBSvgSubsetWriter) are accumulated directly from the UTF-16 buffer; anything
+ * else (exponents, very long mantissas) falls back to QString::toDouble() on a
+ * non-owning QString. As with QString::toFloat(), invalid input yields 0.
+ */
+static qreal coordinateFromSvg(const QChar* begin, const QChar* end)
+{
+    static const double powersOf10[] = {1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7,
+                                        1e8, 1e9, 1e10, 1e11, 1e12, 1e13, 1e14, 1e15};
+
+    const QChar* p = begin;
+    const bool negative = p < end && *p == QLatin1Char('-');
+
+    if (p < end && (*p == QLatin1Char('-') || *p == QLatin1Char('+')))
+        ++p;
+
+    quint64 mantissa = 0;
+    int digits = 0;
+    int fractionDigits = 0;
+
+    for (; p < end; ++p)
+    {
+        const unsigned digit = unsigned(p->unicode()) - unsigned('0');
+
+        if (digit > 9)
+            break;
+
+        mantissa = mantissa * 10 + digit;
+        ++digits;
+    }
+
+    if (p < end && *p == QLatin1Char('.'))
+    {
+        for (++p; p < end; ++p)
+        {
+            const unsigned digit = unsigned(p->unicode()) - unsigned('0');
+
+            if (digit > 9)
+                break;
+
+            mantissa = mantissa * 10 + digit;
+            ++digits;
+            ++fractionDigits;
+        }
+    }
+
+    // up to 15 digits the mantissa and the power of ten are exact doubles,
+    // so a single division gives the correctly rounded result
+    if (p == end && digits > 0 && digits <= 15)
+    {
+        const double value = double(mantissa) / powersOf10[fractionDigits];
+        return negative ? -value : value;
+    }
+
+    return QString::fromRawData(begin, int(end - begin)).toDouble();
+}
+
+
+/**
+ * Decode a whitespace separated list of numbers, as written in ub:widths.
+ */
+static void widthsFromSvg(QStringView svgWidths, QVector<qreal>& widths)
+{
+    const QChar* p = svgWidths.data();
+    const QChar* const end = p + svgWidths.size();
+
+    while (p < end)
+    {
+        while (p < end && isSvgWhitespace(*p))
+            ++p;
+
+        if (p == end)
+            break;
+
+        const QChar* const begin = p;
+
+        while (p < end && !isSvgWhitespace(*p))
+            ++p;
+
+        widths.append(coordinateFromSvg(begin, p));
+    }
+}
+
+
+/**
+ * Decode an SVG 'points' attribute ("x,y x,y ...") into points, without
+ * building intermediate strings. Points are separated by whitespace and their
+ * coordinates by a comma; a point made of four comma separated parts comes from
+ * a system where the "," was used as decimal separator.
+ */
+static void pointsFromSvg(QStringView svgPoints, QVector<QPointF>& points)
+{
+    const QChar* const begin = svgPoints.data();
+    const QChar* const end = begin + svgPoints.size();
+
+    int commas = 0;
+
+    for (const QChar* p = begin; p < end; ++p)
+    {
+        if (*p == QLatin1Char(','))
+            ++commas;
+    }
+
+    points.reserve(points.size() + commas);
+
+    const QChar* p = begin;
+
+    while (p < end)
+    {
+        while (p < end && isSvgWhitespace(*p))
+            ++p;
+
+        if (p == end)
+            break;
+
+        const QChar* const pointBegin = p;
+
+        // comma separated parts of the point, empty parts are skipped
+        const QChar* partBegin[4];
+        const QChar* partEnd[4];
+        int parts = 0;
+
+        while (p < end && !isSvgWhitespace(*p))
+        {
+            if (*p == QLatin1Char(','))
+            {
+                ++p;
+                continue;
+            }
+
+            const QChar* const b = p;
+
+            while (p < end && *p != QLatin1Char(',') && !isSvgWhitespace(*p))
+                ++p;
+
+            if (parts < 4)
+            {
+                partBegin[parts] = b;
+                partEnd[parts] = p;
+            }
+
+            ++parts;
+        }
+
+        if (parts == 2)
+        {
+            points.append(QPointF(coordinateFromSvg(partBegin[0], partEnd[0]),
+                                  coordinateFromSvg(partBegin[1], partEnd[1])));
+        }
+        else if (parts == 4)
+        {
+            //This is the case on system were the "," is used to seperate decimal
+            const QString x = QString(partBegin[0], int(partEnd[0] - partBegin[0])) + "." + QString(partBegin[1], int(partEnd[1] - partBegin[1]));
+            const QString y = QString(partBegin[2], int(partEnd[2] - partBegin[2])) + "." + QString(partBegin[3], int(partEnd[3] - partBegin[3]));
+            points.append(QPointF(x.toDouble(), y.toDouble()));
+        }
+        else
+        {
+            qWarning() << "cannot make sense of a 'point' value" << QString(pointBegin, int(p - pointBegin));
+        }
+    }
+}
+
+
 void UBSvgSubsetAdaptor::upgradeScene(std::shared_ptr<UBDocumentProxy> proxy, const int pageIndex)
 {
     //4.2
@@ -224,13 +397,7 @@ void UBSvgSubsetAdaptor::setSceneUuid(std::shared_ptr<UBDocumentProxy> proxy, co
     newXmlContent.append(UBStringUtils::toCanonicalUuid(pUuid));
     newXmlContent.append(xmlContent.right(xmlContent.length() - quoteEndIndex));
 
-    if (file.open(QIODevice::WriteOnly | QIODevice::Truncate))
-    {
-        QTextStream textWriteStream(&file);
-        textWriteStream << newXmlContent;
-        file.close();
-    }
-    else
+    if (!UBAtomicFileBatch::writeFile(fileName, newXmlContent.toUtf8()))
     {
         qWarning() << "Cannot open file" << fileName  << "to write UUID";
     }
@@ -340,7 +507,7 @@ QUuid UBSvgSubsetAdaptor::sceneUuid(std::shared_ptr<UBDocumentProxy> proxy, cons
 
 std::shared_ptr<UBGraphicsScene> UBSvgSubsetAdaptor::loadScene(std::shared_ptr<UBDocumentProxy> proxy, const QByteArray& pArray)
 {
-    UBSvgSubsetReader reader(proxy, UBTextTools::cleanHtmlCData(QString(pArray)).toUtf8());
+    UBSvgSubsetReader reader(proxy, tokenize(UBTextTools::cleanHtmlCData(QString(pArray)).toUtf8()));
     return reader.loadScene(proxy);
 }
 
@@ -351,8 +518,159 @@ std::shared_ptr<UBSvgSubsetAdaptor::UBSvgReaderContext> UBSvgSubsetAdaptor::prep
     return context;
 }
 
-UBSvgSubsetAdaptor::UBSvgSubsetReader::UBSvgSubsetReader(std::shared_ptr<UBDocumentProxy> pProxy, const QByteArray& pXmlData)
-    : mXmlReader(pXmlData)
+UBSvgSubsetAdaptor::UBSvgPreloadedData UBSvgSubsetAdaptor::preloadScene(const QString& documentPath, const int pageIndex)
+{
+    // only uses thread safe classes, so that it can run on a worker thread
+    UBSvgPreloadedData data;
+
+    QFile file(documentPath + UBFileSystemUtils::digitFileFormat("/page%1.svg", pageIndex));
+
+    if (!file.open(QIODevice::ReadOnly))
+    {
+        qWarning() << "Cannot open file " << file.fileName() << " for reading ...";
+        return data;
+    }
+
+    const QByteArray xmlData = UBTextTools::cleanHtmlCData(QString(file.readAll())).toUtf8();
+    file.close();
+
+    if (xmlData.isEmpty())
+    {
+        return data;
+    }
+
+    // parse here, only the items are created on the GUI thread
+    data.tokens = tokenize(xmlData);
+
+    // decode bitmap images now, this is the most expensive part of building the scene
+    for (const UBSvgToken& token : std::as_const(data.tokens))
+    {
+        if (token.type == QXmlStreamReader::StartElement && token.name == QLatin1String("image"))
+        {
+            QString href = token.attributes.value(nsXLink, "href").toString();
+
+            if (!href.isEmpty() && !href.endsWith(".svg") && !data.images.contains(href))
+            {
+                QImageReader rdr(documentPath + "/" + UBFileSystemUtils::normalizeFilePath(href));
+                rdr.setAutoTransform(true);
+                data.images.insert(href, rdr.read());
+            }
+        }
+    }
+
+    return data;
+}
+
+QVector<UBSvgSubsetAdaptor::UBSvgToken> UBSvgSubsetAdaptor::tokenize(const QByteArray& pXmlData)
+{
+    // only uses thread safe classes, so that it can run on a worker thread
+    QVector<UBSvgToken> tokens;
+    QXmlStreamReader xml(pXmlData);
+
+    while (!xml.atEnd())
+    {
+        UBSvgToken token;
+        token.type = xml.readNext();
+
+        if (xml.isStartElement())
+        {
+            token.name = xml.name().toString();
+            token.attributes = xml.attributes();
+
+            if (token.name == QLatin1String("polygon") || token.name == QLatin1String("polyline"))
+            {
+                auto svgPoints = token.attributes.value("points");
+
+                if (!svgPoints.isNull())
+                    pointsFromSvg(svgPoints, token.points);
+
+                // the namespace depends on the file version, which is only known to the reader
+                for (const QXmlStreamAttribute& attribute : std::as_const(token.attributes))
+                {
+                    if (attribute.name() == QLatin1String("widths") && !attribute.namespaceUri().isEmpty())
+                        widthsFromSvg(attribute.value(), token.widths);
+                }
+            }
+        }
+        else if (xml.isEndElement())
+        {
+            token.name = xml.name().toString();
+        }
+        else if (xml.isCharacters() || xml.isEntityReference())
+        {
+            token.text = xml.text().toString();
+        }
+        else if (xml.hasError())
+        {
+            token.text = xml.errorString();
+        }
+
+        tokens.append(token);
+    }
+
+    return tokens;
+}
+
+UBSvgSubsetAdaptor::UBSvgTokenReader::UBSvgTokenReader(const QVector<UBSvgToken>& pTokens)
+    : mTokens(pTokens)
+    , mIndex(-1)
+{
+    // NOOP
+}
+
+QXmlStreamReader::TokenType UBSvgSubsetAdaptor::UBSvgTokenReader::readNext()
+{
+    // like QXmlStreamReader, stay on the last token once the end is reached
+    if (mIndex < mTokens.size() - 1)
+        ++mIndex;
+
+    return tokenType();
+}
+
+bool UBSvgSubsetAdaptor::UBSvgTokenReader::atEnd() const
+{
+    return mTokens.isEmpty() || tokenType() == QXmlStreamReader::EndDocument || hasError();
+}
+
+QString UBSvgSubsetAdaptor::UBSvgTokenReader::readElementText()
+{
+    QString text;
+
+    while (readNext() != QXmlStreamReader::EndElement && !atEnd())
+    {
+        if (isStartElement())
+            break;
+
+        text += current().text;
+    }
+
+    return text;
+}
+
+void UBSvgSubsetAdaptor::UBSvgTokenReader::skipCurrentElement()
+{
+    int depth = 1;
+
+    while (depth > 0 && !atEnd())
+    {
+        readNext();
+
+        if (isStartElement())
+            ++depth;
+        else if (isEndElement())
+            --depth;
+    }
+}
+
+const UBSvgSubsetAdaptor::UBSvgToken& UBSvgSubsetAdaptor::UBSvgTokenReader::current() const
+{
+    static const UBSvgToken noToken;
+
+    return mIndex >= 0 ? mTokens.at(mIndex) : noToken;
+}
+
+UBSvgSubsetAdaptor::UBSvgSubsetReader::UBSvgSubsetReader(std::shared_ptr<UBDocumentProxy> pProxy, const QVector<UBSvgToken>& pTokens)
+    : mXmlReader(pTokens)
     , mProxy(pProxy)
     , mDocumentPath(pProxy->persistencePath())
     , mGroupHasInfo(false)
@@ -388,6 +706,11 @@ void UBSvgSubsetAdaptor::UBSvgSubsetReader::start()
     mFileVersion = 40100; // default to 4.1.0
 }
 
+void UBSvgSubsetAdaptor::UBSvgSubsetReader::setPreloadedImages(const QHash<QString, QImage>& images)
+{
+    mPreloadedImages = images;
+}
+
 bool UBSvgSubsetAdaptor::UBSvgSubsetReader::isFinished()
 {
     return mXmlReader.atEnd();
@@ -607,6 +930,8 @@ void UBSvgSubsetAdaptor::UBSvgSubsetReader::processElement()
         }
         else if (name == "polygon" || name == "line")
         {
+            // strokes saved as outlines have no centreline and are not converted to
+            // stroke items, they stay one polygon item per segment until redrawn
             UBGraphicsPolygonItem* polygonItem = 0;
 
             QString parentId = mXmlReader.attributes().value(mNamespaceUri, "parent").toString();
@@ -1177,10 +1502,10 @@ QGraphicsItem *UBSvgSubsetAdaptor::UBSvgSubsetReader::readElementFromGroup()
     return result;
 }
 
-void UBSvgSubsetAdaptor::persistScene(std::shared_ptr<UBDocumentProxy> proxy, std::shared_ptr<UBGraphicsScene> pScene, const int pageIndex)
+void UBSvgSubsetAdaptor::persistScene(std::shared_ptr<UBDocumentProxy> proxy, std::shared_ptr<UBGraphicsScene> pScene, const int pageIndex, UBAtomicFileBatch* batch)
 {
     UBSvgSubsetWriter writer(proxy, pScene, pageIndex);
-    writer.persistScene(proxy, pageIndex);
+    writer.persistScene(proxy, pageIndex, batch);
 }
 
 
@@ -1188,12 +1513,175 @@ UBSvgSubsetAdaptor::UBSvgSubsetWriter::UBSvgSubsetWriter(std::shared_ptr<UBDocum
     : mScene(pScene)
     , mDocumentPath(proxy->persistencePath())
     , mPageIndex(pageIndex)
-
+    , mCoordinatePrecision(qBound(-1, UBSettings::settings()->svgCoordinatePrecision->get().toInt(), 9))
 {
     // NOOP
 }
 
 
+/**
+ * Format one coordinate into out, which must hold at least 24 characters, and
+ * return the number of characters written. With decimals < 0 the value keeps six
+ * significant digits, as QString::arg(double) wrote it before; otherwise it is
+ * rounded to that many decimals. Trailing zeros are dropped and no locale is
+ * involved.
+ */
+static int coordinateToSvg(qreal value, int decimals, char* out)
+{
+    static const qint64 powersOf10[] = {1LL, 10LL, 100LL, 1000LL, 10000LL, 100000LL,
+                                        1000000LL, 10000000LL, 100000000LL, 1000000000LL};
+
+    if (!qIsFinite(value))
+        value = 0;
+
+    const double magnitude = qAbs(value);
+
+    if (magnitude >= 1e9)
+    {
+        // far outside any page, not worth a fast path
+        const QByteArray number = QByteArray::number(value, 'g', 9);
+        memcpy(out, number.constData(), number.size());
+        return number.size();
+    }
+
+    qint64 scaled;
+
+    if (decimals >= 0)
+    {
+        scaled = qRound64(magnitude * powersOf10[decimals]);
+    }
+    else
+    {
+        if (magnitude >= 1)
+        {
+            int integerDigits = 1;
+
+            while (integerDigits < 9 && magnitude >= powersOf10[integerDigits])
+                ++integerDigits;
+
+            decimals = qMax(0, 6 - integerDigits);
+        }
+        else
+        {
+            // leading zeros of the fraction are not significant
+            decimals = 6;
+
+            for (double shifted = magnitude * 10; shifted > 0 && shifted < 1 && decimals < 9; shifted *= 10)
+                ++decimals;
+        }
+
+        scaled = qRound64(magnitude * powersOf10[decimals]);
+    }
+
+    while (decimals > 0 && scaled % 10 == 0)
+    {
+        scaled /= 10;
+        --decimals;
+    }
+
+    char* p = out;
+
+    if (value < 0 && scaled != 0)
+        *p++ = '-';
+
+    char digits[20];
+    int count = 0;
+    qint64 integerPart = scaled / powersOf10[decimals];
+
+    do
+    {
+        digits[count++] = char('0' + integerPart % 10);
+        integerPart /= 10;
+    } while (integerPart > 0);
+
+    while (count > 0)
+        *p++ = digits[--count];
+
+    if (decimals > 0)
+    {
+        qint64 fraction = scaled % powersOf10[decimals];
+
+        *p++ = '.';
+
+        for (int i = decimals - 1; i >= 0; --i)
+        {
+            p[i] = char('0' + fraction % 10);
+            fraction /= 10;
+        }
+
+        p += decimals;
+    }
+
+    return int(p - out);
+}
+
+
+static void appendSvgPoint(QString& buffer, const QPointF& point, int decimals)
+{
+    char chars[64];
+    int length = 0;
+
+    if (!buffer.isEmpty())
+        chars[length++] = ' ';
+
+    length += coordinateToSvg(point.x(), decimals, chars + length);
+    chars[length++] = ',';
+    length += coordinateToSvg(point.y(), decimals, chars + length);
+
+    buffer.append(QLatin1String(chars, length));
+}
+
+
+const QString& UBSvgSubsetAdaptor::UBSvgSubsetWriter::pointsToSvgPointsAttribute(QVector<QPointF> points)
+{
+    UBGeometryUtils::crashPointList(points);
+
+    // truncating keeps the capacity from one element to the next (clear() would free it),
+    // so a page only reallocates the buffer when a longer stroke than all previous ones comes by
+    mPointsBuffer.truncate(0);
+    mPointsBuffer.reserve(points.size() * 16);
+
+    for (int j = 0; j < points.size(); j++)
+        appendSvgPoint(mPointsBuffer, points.at(j), mCoordinatePrecision);
+
+    return mPointsBuffer;
+}
+
+
+const QString& UBSvgSubsetAdaptor::UBSvgSubsetWriter::centrelineToSvgPointsAttribute(const QVector<QPair<QPointF, qreal> >& centreline)
+{
+    mPointsBuffer.truncate(0);
+    mPointsBuffer.reserve(centreline.size() * 16);
+
+    for (int j = 0; j < centreline.size(); j++)
+        appendSvgPoint(mPointsBuffer, centreline.at(j).first, mCoordinatePrecision);
+
+    return mPointsBuffer;
+}
+
+
+const QString& UBSvgSubsetAdaptor::UBSvgSubsetWriter::centrelineToSvgWidthsAttribute(const QVector<QPair<QPointF, qreal> >& centreline)
+{
+    mPointsBuffer.truncate(0);
+    mPointsBuffer.reserve(centreline.size() * 6);
+
+    char width[32];
+
+    for (int j = 0; j < centreline.size(); j++)
+    {
+        int length = 0;
+
+        if (j > 0)
+            width[length++] = ' ';
+
+        length += coordinateToSvg(centreline.at(j).second, mCoordinatePrecision, width + length);
+        mPointsBuffer.append(QLatin1String(width, length));
+    }
+
+    return mPointsBuffer;
+}
+
+
 void UBSvgSubsetAdaptor::UBSvgSubsetWriter::writeSvgElement(std::shared_ptr<UBDocumentProxy> proxy)
 {
     mXmlWriter.writeStartElement("svg");
@@ -1248,7 +1736,7 @@ void UBSvgSubsetAdaptor::UBSvgSubsetWriter::writeSvgElement(std::shared_ptr<UBDo
     mXmlWriter.writeEndElement();
 }
 
-bool UBSvgSubsetAdaptor::UBSvgSubsetWriter::persistScene(std::shared_ptr<UBDocumentProxy> proxy, int pageIndex)
+bool UBSvgSubsetAdaptor::UBSvgSubsetWriter::persistScene(std::shared_ptr<UBDocumentProxy> proxy, int pageIndex, UBAtomicFileBatch* batch)
 {
     Q_UNUSED(pageIndex);
 
@@ -1280,8 +1768,61 @@ bool UBSvgSubsetAdaptor::UBSvgSubsetWriter::persistScene(std::shared_ptr<UBDocum
 
     bool groupHoldsInfo = false;
 
-    while (!items.empty())
+    // strokes unchanged since the last save were not copied, their fragments are written in z order
+    QList<UBSvgFragmentCache::ReusedFragment> reusedFragments = mScene->reusedFragments();
+
+    std::sort(reusedFragments.begin(), reusedFragments.end(), [](const UBSvgFragmentCache::ReusedFragment& fragment1, const UBSvgFragmentCache::ReusedFragment& fragment2){
+        return fragment1.zValue < fragment2.zValue;
+    });
+
+    // fragments of the strokes written now, to be reused by the next save
+    QHash<QUuid, UBSvgFragmentCache::Fragment> writtenFragments;
+    QSet<QUuid> splitFragments;
+    QUuid fragmentUuid;
+    qint64 fragmentStart = -1;
+
+    auto closeOpenStroke = [&]()
     {
+        mXmlWriter.writeEndElement(); //g
+        openStroke = 0;
+        groupHoldsInfo = false;
+
+        if (fragmentStart >= 0)
+        {
+            if (writtenFragments.contains(fragmentUuid))
+            {
+                // a strokes group written as several elements cannot be reused
+                splitFragments << fragmentUuid;
+            }
+
+            writtenFragments.insert(fragmentUuid, {mScene->fragmentFingerprint(fragmentUuid), buffer.data().mid(fragmentStart)});
+            fragmentStart = -1;
+        }
+    };
+
+    while (!items.empty() || !reusedFragments.empty())
+    {
+        if (!reusedFragments.empty())
+        {
+            UBGraphicsPolygonItem *nextPolygonItem = items.empty() ? nullptr : qgraphicsitem_cast<UBGraphicsPolygonItem*>(items.first());
+            bool continuesOpenStroke = openStroke && nextPolygonItem && nextPolygonItem->stroke() == openStroke;
+
+            if (!continuesOpenStroke && (items.empty() || reusedFragments.first().zValue < items.first()->data(UBGraphicsItemData::ItemOwnZValue).toReal()))
+            {
+                if (openStroke)
+                    closeOpenStroke();
+
+                UBSvgFragmentCache::ReusedFragment reused = reusedFragments.takeFirst();
+                buffer.write(reused.fragment.xml);
+
+                if (writtenFragments.contains(reused.uuid))
+                    splitFragments << reused.uuid;
+
+                writtenFragments.insert(reused.uuid, reused.fragment);
+                continue;
+            }
+        }
+
         QGraphicsItem *item = items.takeFirst();
 
         // Is the item a polygon?
@@ -1291,15 +1832,22 @@ bool UBSvgSubsetAdaptor::UBSvgSubsetWriter::persistScene(std::shared_ptr<UBDocum
             UBGraphicsStroke* currentStroke = polygonItem->stroke();
             if (openStroke && (currentStroke != openStroke))
             {
-                mXmlWriter.writeEndElement(); //g
-                openStroke = 0;
-                groupHoldsInfo = false;
+                closeOpenStroke();
             }
 
             bool firstPolygonInStroke = currentStroke  && !openStroke;
 
             if (firstPolygonInStroke)
             {
+                UBGraphicsStrokesGroup * sg = polygonItem->strokesGroup();
+
+                if (sg && !mScene->fragmentFingerprint(sg->uuid()).isEmpty())
+                {
+                    // the writer has no pending output between elements, so the fragment starts here
+                    fragmentUuid = sg->uuid();
+                    fragmentStart = buffer.pos();
+                }
+
                 mXmlWriter.writeStartElement("g");
                 openStroke = currentStroke;
 
@@ -1309,7 +1857,6 @@ bool UBSvgSubsetAdaptor::UBSvgSubsetWriter::persistScene(std::shared_ptr<UBDocum
                 {
                     QColor colorOnDarkBackground = polygonItem->colorOnDarkBackground();
                     QColor colorOnLightBackground = polygonItem->colorOnLightBackground();
-                    UBGraphicsStrokesGroup * sg = polygonItem->strokesGroup();
 
                     if (colorOnDarkBackground.isValid() && colorOnLightBackground.isValid() && sg)
                     {
@@ -1361,8 +1908,15 @@ bool UBSvgSubsetAdaptor::UBSvgSubsetWriter::persistScene(std::shared_ptr<UBDocum
             }
 
             UBGraphicsStroke* stroke = dynamic_cast<UBGraphicsStroke* >(currentStroke);
+            UBGraphicsStrokeItem* strokeItem = dynamic_cast<UBGraphicsStrokeItem*>(polygonItem);
+
+            if (strokeItem && strokeItem->hasCentreline())
+                strokeItemToSvgPolyline(strokeItem, groupHoldsInfo);
 
-            if (stroke && stroke->hasPressure())
+            else if (strokeItem)
+                polygonItemToSvgPolygon(polygonItem, groupHoldsInfo);
+
+            else if (stroke && stroke->hasPressure())
                 polygonItemToSvgPolygon(polygonItem, groupHoldsInfo);
 
             else if (polygonItem->isNominalLine())
@@ -1374,9 +1928,7 @@ bool UBSvgSubsetAdaptor::UBSvgSubsetWriter::persistScene(std::shared_ptr<UBDocum
 
         if (openStroke)
         {
-            mXmlWriter.writeEndElement(); //g
-            groupHoldsInfo = false;
-            openStroke = 0;
+            closeOpenStroke();
         }
 
         // Is the item a picture?
@@ -1508,8 +2060,17 @@ bool UBSvgSubsetAdaptor::UBSvgSubsetWriter::persistScene(std::shared_ptr<UBDocum
 
     if (openStroke)
     {
-        mXmlWriter.writeEndElement();
-        openStroke = 0;
+        closeOpenStroke();
+    }
+
+    if (mScene->isPersistenceCopy())
+    {
+        foreach (const QUuid& uuid, splitFragments)
+        {
+            writtenFragments.remove(uuid);
+        }
+
+        mScene->fragmentCache()->setFragments(writtenFragments);
     }
 
     //writing group data
@@ -1551,18 +2112,14 @@ bool UBSvgSubsetAdaptor::UBSvgSubsetWriter::persistScene(std::shared_ptr<UBDocum
 
     mXmlWriter.writeEndDocument();
     QString fileName = mDocumentPath + UBFileSystemUtils::digitFileFormat("/page%1.svg", mPageIndex);
-    QFile file(fileName);
 
-    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate))
+    // never leave a partially written page behind
+    if (batch)
     {
-        qCritical() << "cannot open " << fileName << " for writing. Error : " << file.errorString();
-        return false;
+        return batch->write(fileName, buffer.data());
     }
-    file.write(buffer.data());
-    file.flush();
-    file.close();
 
-    return true;
+    return UBAtomicFileBatch::writeFile(fileName, buffer.data());
 }
 
 void UBSvgSubsetAdaptor::UBSvgSubsetWriter::persistGroupToDom(QGraphicsItem *groupItem, QDomElement *curParent, QDomDocument *groupDomDocument)
@@ -1664,8 +2221,7 @@ void UBSvgSubsetAdaptor::UBSvgSubsetWriter::strokeToSvgPolyline(UBGraphicsStroke
             points[1] = QPointF(points[1].x() + 0.01, points[1].y());
         }
 
-        QString svgPoints = pointsToSvgPointsAttribute(points);
-        mXmlWriter.writeAttribute("points", svgPoints);
+        mXmlWriter.writeAttribute("points", pointsToSvgPointsAttribute(points));
 
         UBGraphicsPolygonItem* firstPolygonItem = pols.at(0);
 
@@ -1696,6 +2252,60 @@ void UBSvgSubsetAdaptor::UBSvgSubsetWriter::strokeToSvgPolyline(UBGraphicsStroke
 }
 
 
+/**
+ * Write a stroke item as a polyline along its centreline. The width of each point goes
+ * to ub:widths when it varies; stroke-width holds the mean width for other SVG readers.
+ */
+void UBSvgSubsetAdaptor::UBSvgSubsetWriter::strokeItemToSvgPolyline(UBGraphicsStrokeItem* strokeItem, bool groupHoldsInfo)
+{
+    QVector<QPair<QPointF, qreal> > centreline = strokeItem->centreline();
+
+    if (centreline.isEmpty())
+        return;
+
+    // SVG renderers do not draw a polyline made of a single point
+    if (centreline.size() == 1)
+        centreline << qMakePair(centreline.first().first + QPointF(0.01, 0), centreline.first().second);
+
+    qreal meanWidth = 0;
+
+    for (int i = 0; i < centreline.size(); i++)
+        meanWidth += centreline.at(i).second;
+
+    meanWidth /= centreline.size();
+
+    mXmlWriter.writeStartElement("polyline");
+    mXmlWriter.writeAttribute("points", centrelineToSvgPointsAttribute(centreline));
+
+    if (!strokeItem->hasConstantWidth())
+        mXmlWriter.writeAttribute(UBSettings::uniboardDocumentNamespaceUri, "widths", centrelineToSvgWidthsAttribute(centreline));
+
+    mXmlWriter.writeAttribute("fill", "none");
+    mXmlWriter.writeAttribute("stroke-width", QString::number(meanWidth, 'f', 2));
+    mXmlWriter.writeAttribute("stroke", strokeItem->brush().color().name());
+    mXmlWriter.writeAttribute("stroke-opacity", QString("%1").arg(strokeItem->brush().color().alphaF()));
+    mXmlWriter.writeAttribute("stroke-linecap", "round");
+    mXmlWriter.writeAttribute("stroke-linejoin", "round");
+
+    if (!groupHoldsInfo)
+    {
+        mXmlWriter.writeAttribute(UBSettings::uniboardDocumentNamespaceUri, "z-value", QString("%1").arg(strokeItem->zValue()));
+
+        mXmlWriter.writeAttribute(UBSettings::uniboardDocumentNamespaceUri
+                                  , "fill-on-dark-background", strokeItem->colorOnDarkBackground().name());
+        mXmlWriter.writeAttribute(UBSettings::uniboardDocumentNamespaceUri
+                                  , "fill-on-light-background", strokeItem->colorOnLightBackground().name());
+    }
+
+    mXmlWriter.writeAttribute(UBSettings::uniboardDocumentNamespaceUri, "uuid", UBStringUtils::toCanonicalUuid(strokeItem->uuid()));
+    if (strokeItem->parentItem()) {
+        mXmlWriter.writeAttribute(UBSettings::uniboardDocumentNamespaceUri, "parent", UBStringUtils::toCanonicalUuid(UBGraphicsItem::getOwnUuid(strokeItem->strokesGroup())));
+    }
+
+    mXmlWriter.writeEndElement();
+}
+
+
 void UBSvgSubsetAdaptor::UBSvgSubsetWriter::strokeToSvgPolygon(UBGraphicsStroke* stroke, bool groupHoldsInfo)
 {
     QList<UBGraphicsPolygonItem*> pis = stroke->polygons();
@@ -1727,8 +2337,7 @@ void UBSvgSubsetAdaptor::UBSvgSubsetWriter::polygonItemToSvgPolygon(UBGraphicsPo
     {
         mXmlWriter.writeStartElement("polygon");
 
-        QString points = pointsToSvgPointsAttribute(polygon);
-        mXmlWriter.writeAttribute("points", points);
+        mXmlWriter.writeAttribute("points", pointsToSvgPointsAttribute(polygon));
         mXmlWriter.writeAttribute("transform",toSvgTransform(polygonItem->transform()));
         mXmlWriter.writeAttribute("fill", polygonItem->brush().color().name());
 
@@ -1786,33 +2395,8 @@ UBGraphicsPolygonItem* UBSvgSubsetAdaptor::UBSvgSubsetReader::polygonItemFromPol
 
     if (!svgPoints.isNull())
     {
-        QStringList ts = svgPoints.toString().split(QLatin1Char(' '), UB::SplitBehavior::SkipEmptyParts);
-
-        foreach(const QString sPoint, ts)
-        {
-            QStringList sCoord = sPoint.split(QLatin1Char(','), UB::SplitBehavior::SkipEmptyParts);
-
-            if (sCoord.size() == 2)
-            {
-                QPointF point;
-                point.setX(sCoord.at(0).toFloat());
-                point.setY(sCoord.at(1).toFloat());
-                polygon << point;
-            }
-            else if (sCoord.size() == 4){
-                //This is the case on system were the "," is used to seperate decimal
-                QPointF point;
-                QString x = sCoord.at(0) + "." + sCoord.at(1);
-                QString y = sCoord.at(2) + "." + sCoord.at(3);
-                point.setX(x.toFloat());
-                point.setY(y.toFloat());
-                polygon << point;
-            }
-            else
-            {
-                qWarning() << "cannot make sense of a 'point' value" << sCoord;
-            }
-        }
+        // decoded when the page was parsed
+        polygon = mXmlReader.points();
     }
     else
     {
@@ -2092,46 +2676,34 @@ QList<UBGraphicsPolygonItem*> UBSvgSubsetAdaptor::UBSvgSubsetReader::polygonItem
 
     if (!svgPoints.isNull())
     {
-        QStringList ts = svgPoints.toString().split(QLatin1Char(' '),
-                                                    UB::SplitBehavior::SkipEmptyParts);
+        // decoded when the page was parsed
+        const QVector<QPointF>& points = mXmlReader.points();
 
-        QList<QPointF> points;
+        QVector<qreal> widths;
+        auto svgWidths = mXmlReader.attributes().value(mNamespaceUri, "widths");
 
-        foreach(const QString sPoint, ts)
-        {
-            QStringList sCoord = sPoint.split(QLatin1Char(','), UB::SplitBehavior::SkipEmptyParts);
+        if (!svgWidths.isNull())
+            widths = mXmlReader.widths();
 
-            if (sCoord.size() == 2)
-            {
-                QPointF point;
-                point.setX(sCoord.at(0).toFloat());
-                point.setY(sCoord.at(1).toFloat());
-                points << point;
-            }
-            else if (sCoord.size() == 4){
-                //This is the case on system were the "," is used to seperate decimal
-                QPointF point;
-                QString x = sCoord.at(0) + "." + sCoord.at(1);
-                QString y = sCoord.at(2) + "." + sCoord.at(3);
-                point.setX(x.toFloat());
-                point.setY(y.toFloat());
-                points << point;
-            }
-            else
-            {
-                qWarning() << "cannot make sense of a 'point' value" << sCoord;
-            }
-        }
+        if (widths.size() != points.size())
+            widths.fill(lineWidth, points.size());
 
-        for (int i = 0; i < points.size() - 1; i++)
+        // the whole polyline becomes a single stroke item, formerly one polygon per segment
+        if (!points.isEmpty())
         {
-            UBGraphicsPolygonItem* polygonItem = new UBGraphicsPolygonItem(QLineF(points.at(i), points.at(i + 1)), lineWidth);
-            polygonItem->setColor(brushColor);
-            UBGraphicsItem::assignZValue(polygonItem, zValue);
-            polygonItem->setColorOnDarkBackground(colorOnDarkBackground);
-            polygonItem->setColorOnLightBackground(colorOnLightBackground);
+            QVector<QPair<QPointF, qreal> > centreline;
+            centreline.reserve(points.size());
 
-            polygonItems <<polygonItem;
+            for (int i = 0; i < points.size(); i++)
+                centreline.append(qMakePair(points.at(i), widths.at(i)));
+
+            UBGraphicsStrokeItem* strokeItem = new UBGraphicsStrokeItem(centreline);
+            strokeItem->setColor(brushColor);
+            UBGraphicsItem::assignZValue(strokeItem, zValue);
+            strokeItem->setColorOnDarkBackground(colorOnDarkBackground);
+            strokeItem->setColorOnLightBackground(colorOnLightBackground);
+
+            polygonItems << strokeItem;
         }
     }
     else
@@ -2176,9 +2748,15 @@ UBGraphicsPixmapItem* UBSvgSubsetAdaptor::UBSvgSubsetReader::pixmapItemFromSvg()
     {
         pixmapItem = new UBGraphicsPixmapItem();
         QString href = imageHref.toString();
-        QImageReader rdr(mDocumentPath + "/" + UBFileSystemUtils::normalizeFilePath(href));
-        rdr.setAutoTransform(true);
-        QImage img = rdr.read();
+        QImage img = mPreloadedImages.take(href);
+
+        if (img.isNull())
+        {
+            QImageReader rdr(mDocumentPath + "/" + UBFileSystemUtils::normalizeFilePath(href));
+            rdr.setAutoTransform(true);
+            img = rdr.read();
+        }
+
         QPixmap pix = QPixmap::fromImage(img);
         pixmapItem->setPixmap(pix);
         graphicsItemFromSvg(pixmapItem);
@@ -3507,7 +4085,14 @@ void UBSvgSubsetAdaptor::convertSvgImagesToImages(std::shared_ptr<UBDocumentProx
 
 UBSvgSubsetAdaptor::UBSvgReaderContext::UBSvgReaderContext(std::shared_ptr<UBDocumentProxy> proxy, const QByteArray& pXmlData)
 {
-    reader = new UBSvgSubsetReader(proxy, pXmlData);
+    reader = new UBSvgSubsetReader(proxy, tokenize(pXmlData));
+    reader->start();
+}
+
+UBSvgSubsetAdaptor::UBSvgReaderContext::UBSvgReaderContext(std::shared_ptr<UBDocumentProxy> proxy, const UBSvgPreloadedData& pData)
+{
+    reader = new UBSvgSubsetReader(proxy, pData.tokens);
+    reader->setPreloadedImages(pData.images);
     reader->start();
 }
 
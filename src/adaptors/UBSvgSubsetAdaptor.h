@@ -55,11 +55,13 @@ class UBGraphicsProtractor;
 class UBGraphicsScene;
 class UBDocumentProxy;
 class UBGraphicsStroke;
+class UBGraphicsStrokeItem;
 class UBPersistenceManager;
 class UBGraphicsTriangle;
 class UBGraphicsCache;
 class UBGraphicsGroupContainerItem;
 class UBGraphicsStrokesGroup;
+class UBAtomicFileBatch;
 
 class UBSvgSubsetAdaptor
 {
@@ -70,10 +72,31 @@ class UBSvgSubsetAdaptor
         virtual ~UBSvgSubsetAdaptor() {;}
 
     public:
+        // an XML token of a page, read on any thread and replayed when the scene is built
+        struct UBSvgToken
+        {
+            QXmlStreamReader::TokenType type = QXmlStreamReader::NoToken;
+            QString name;
+            QXmlStreamAttributes attributes;
+            QString text; // characters, or the error of an invalid token
+
+            // decoded 'points' and 'widths' of polygons and polylines
+            QVector<QPointF> points;
+            QVector<qreal> widths;
+        };
+
+        // page content read and decoded ahead of time, may be produced on any thread
+        struct UBSvgPreloadedData
+        {
+            QVector<UBSvgToken> tokens;
+            QHash<QString, QImage> images;
+        };
+
         class UBSvgReaderContext
         {
         public:
             UBSvgReaderContext(std::shared_ptr<UBDocumentProxy> proxy, const QByteArray& pXmlData);
+            UBSvgReaderContext(std::shared_ptr<UBDocumentProxy> proxy, const UBSvgPreloadedData& pData);
             ~UBSvgReaderContext();
             bool isFinished() const;
             void step();
@@ -87,8 +110,10 @@ class UBSvgSubsetAdaptor
         static QByteArray loadSceneAsText(std::shared_ptr<UBDocumentProxy> proxy, const int pageIndex);
         static std::shared_ptr<UBGraphicsScene> loadScene(std::shared_ptr<UBDocumentProxy> proxy, const QByteArray& pArray);
         static std::shared_ptr<UBSvgReaderContext> prepareLoadingScene(std::shared_ptr<UBDocumentProxy> proxy, const int pageIndex);
+        static UBSvgPreloadedData preloadScene(const QString& documentPath, const int pageIndex);
 
-        static void persistScene(std::shared_ptr<UBDocumentProxy> proxy, std::shared_ptr<UBGraphicsScene> pScene, const int pageIndex);
+        // writes through batch if given, the caller commits it
+        static void persistScene(std::shared_ptr<UBDocumentProxy> proxy, std::shared_ptr<UBGraphicsScene> pScene, const int pageIndex, UBAtomicFileBatch* batch = nullptr);
         static void upgradeScene(std::shared_ptr<UBDocumentProxy> proxy, const int pageIndex);
 
         static QUuid sceneUuid(std::shared_ptr<UBDocumentProxy> proxy, const int pageIndex);
@@ -113,6 +138,8 @@ class UBSvgSubsetAdaptor
 
         static QDomDocument loadSceneDocument(std::shared_ptr<UBDocumentProxy> proxy, const int pPageIndex);
 
+        static QVector<UBSvgToken> tokenize(const QByteArray& pXmlData);
+
         static QString uniboardDocumentNamespaceUriFromVersion(int fileVersion);
 
         static const QString sFormerUniboardDocumentNamespaceUri;
@@ -121,17 +148,60 @@ class UBSvgSubsetAdaptor
         static QTransform fromSvgTransform(const QString& transform);
 
 
+        /**
+         * Replays the tokens of a page through the part of the QXmlStreamReader
+         * interface used by the reader, so that parsing can happen on another thread.
+         */
+        class UBSvgTokenReader
+        {
+            public:
+
+                explicit UBSvgTokenReader(const QVector<UBSvgToken>& pTokens);
+
+                QXmlStreamReader::TokenType readNext();
+                QXmlStreamReader::TokenType tokenType() const { return current().type; }
+
+                bool atEnd() const;
+                bool isStartElement() const { return tokenType() == QXmlStreamReader::StartElement; }
+                bool isEndElement() const { return tokenType() == QXmlStreamReader::EndElement; }
+                bool hasError() const { return tokenType() == QXmlStreamReader::Invalid; }
+                QString errorString() const { return hasError() ? current().text : QString(); }
+
+#if (QT_VERSION >= QT_VERSION_CHECK(6, 0, 0))
+                QStringView name() const { return current().name; }
+                QStringView text() const { return current().text; }
+#else
+                QStringRef name() const { return QStringRef(&current().name); }
+                QStringRef text() const { return QStringRef(&current().text); }
+#endif
+                const QXmlStreamAttributes& attributes() const { return current().attributes; }
+
+                const QVector<QPointF>& points() const { return current().points; }
+                const QVector<qreal>& widths() const { return current().widths; }
+
+                QString readElementText();
+                void skipCurrentElement();
+
+            private:
+
+                const UBSvgToken& current() const;
+
+                QVector<UBSvgToken> mTokens;
+                int mIndex;
+        };
+
         class UBSvgSubsetReader
         {
             public:
 
-                UBSvgSubsetReader(std::shared_ptr<UBDocumentProxy> proxy, const QByteArray& pXmlData);
+                UBSvgSubsetReader(std::shared_ptr<UBDocumentProxy> proxy, const QVector<UBSvgToken>& pTokens);
 
                 virtual ~UBSvgSubsetReader(){}
 
                 std::shared_ptr<UBGraphicsScene> loadScene(std::shared_ptr<UBDocumentProxy> proxy);
 
                 void start();
+                void setPreloadedImages(const QHash<QString, QImage>& images);
                 bool isFinished();
                 void processElement();
                 std::shared_ptr<UBGraphicsScene> scene();
@@ -182,7 +252,7 @@ class UBSvgSubsetAdaptor
 
                 qreal normalizedZValue(bool* hasValue);
 
-                QXmlStreamReader mXmlReader;
+                UBSvgTokenReader mXmlReader;
                 int mFileVersion;
                 std::shared_ptr<UBDocumentProxy> mProxy;
                 QString mDocumentPath;
@@ -198,6 +268,7 @@ class UBSvgSubsetAdaptor
                 std::shared_ptr<UBGraphicsScene> mScene;
 
                 QHash<QString,UBGraphicsStrokesGroup*> mStrokesList;
+                QHash<QString, QImage> mPreloadedImages;
 
                 UBGraphicsStrokesGroup* strokesGroup = nullptr;
                 UBGraphicsStroke* currentStroke = nullptr;
@@ -211,7 +282,7 @@ class UBSvgSubsetAdaptor
 
                 UBSvgSubsetWriter(std::shared_ptr<UBDocumentProxy> proxy, std::shared_ptr<UBGraphicsScene> pScene, const int pageIndex);
 
-                bool persistScene(std::shared_ptr<UBDocumentProxy> proxy, int pageIndex);
+                bool persistScene(std::shared_ptr<UBDocumentProxy> proxy, int pageIndex, UBAtomicFileBatch* batch = nullptr);
 
                 virtual ~UBSvgSubsetWriter(){}
 
@@ -223,35 +294,11 @@ class UBSvgSubsetAdaptor
                 void polygonItemToSvgLine(UBGraphicsPolygonItem* polygonItem, bool groupHoldsInfo);
                 void strokeToSvgPolyline(UBGraphicsStroke* stroke, bool groupHoldsInfo);
                 void strokeToSvgPolygon(UBGraphicsStroke* stroke, bool groupHoldsInfo);
+                void strokeItemToSvgPolyline(UBGraphicsStrokeItem* strokeItem, bool groupHoldsInfo);
 
-                inline QString pointsToSvgPointsAttribute(QVector<QPointF> points)
-                {
-                    UBGeometryUtils::crashPointList(points);
-
-                    int pointsCount = points.size();
-                    QString svgPoints;
-
-                    int length = 0;
-                    QString sBuf;
-
-                    for(int j = 0; j < pointsCount; j++)
-                    {
-                        sBuf = "%1,%2 ";
-                        const QPointF & point = points.at(j);
-
-                        QString temp1 =  "%1", temp2 = "%2";
-
-                        temp1 = temp1.arg(point.x());
-                        temp2 = temp2.arg(point.y());
-
-                        QLocale loc(QLocale::C);
-                        sBuf = sBuf.arg(loc.toFloat(temp1)).arg(loc.toFloat(temp2));
-
-                        svgPoints.insert(length, sBuf);
-                        length += sBuf.length();
-                    }
-                    return svgPoints;
-                }
+                const QString& pointsToSvgPointsAttribute(QVector<QPointF> points);
+                const QString& centrelineToSvgPointsAttribute(const QVector<QPair<QPointF, qreal> >& centreline);
+                const QString& centrelineToSvgWidthsAttribute(const QVector<QPair<QPointF, qreal> >& centreline);
 
                 inline qreal trickAlpha(qreal alpha)
                 {
@@ -289,6 +336,8 @@ class UBSvgSubsetAdaptor
                 QXmlStreamWriter mXmlWriter;
                 QString mDocumentPath;
                 int mPageIndex;
+                int mCoordinatePrecision;
+                QString mPointsBuffer;
 
         };
 };
@@ -32,10 +32,12 @@
 #include <QtCore>
 
 #include "frameworks/UBFileSystemUtils.h"
+#include "frameworks/UBAtomicFileBatch.h"
 
 #include "core/UBPersistenceManager.h"
 #include "core/UBApplication.h"
 #include "core/UBSettings.h"
+#include "core/UBThumbnailService.h"
 
 #include "board/UBBoardController.h"
 #include "board/UBBoardPaletteManager.h"
@@ -45,114 +47,108 @@
 #include "domain/UBGraphicsScene.h"
 
 #include "UBSvgSubsetAdaptor.h"
+#include "UBThumbnailPack.h"
 
 #include "core/memcheck.h"
 
-void UBThumbnailAdaptor::generateMissingThumbnails(std::shared_ptr<UBDocumentProxy> proxy)
-{
-    int existingPageCount = proxy->pageCount();
-
-    for (int iPageNo = 0; iPageNo < existingPageCount; ++iPageNo)
-    {
-        QString thumbFileName = proxy->persistencePath() + UBFileSystemUtils::digitFileFormat("/page%1.thumbnail.jpg", iPageNo);
-
-        QFile thumbFile(thumbFileName);
-
-        if (!thumbFile.exists())
-        {
-            bool displayMessage = (existingPageCount > 5);
-
-            int thumbCount = 0;
-
-            std::shared_ptr<UBGraphicsScene> scene = UBSvgSubsetAdaptor::loadScene(proxy, iPageNo);
-
-            if (scene)
-            {
-                thumbCount++;
-
-                if (displayMessage && thumbCount == 1)
-                    UBApplication::showMessage(tr("Generating preview thumbnails ..."));
-
-                persistScene(proxy, scene, iPageNo);
-            }
-
-            if (displayMessage && thumbCount > 0)
-                UBApplication::showMessage(tr("%1 thumbnails generated ...").arg(thumbCount));
-
-        }
-    }
-}
-
 QPixmap UBThumbnailAdaptor::get(std::shared_ptr<UBDocumentProxy> proxy, int pageIndex)
 {
-    QString fileName = proxy->persistencePath() + UBFileSystemUtils::digitFileFormat("/page%1.thumbnail.jpg", pageIndex);
+    QPixmap pix = UBThumbnailService::service()->thumbnail(proxy, pageIndex);
 
-    QFile file(fileName);
-    if (!file.exists())
-    {
-        generateMissingThumbnails(proxy);
-    }
-
-    QPixmap pix;
-    if (file.exists())
-    {
-        pix.load(fileName, 0, Qt::AutoColor);
-    }
-    return pix;
+    return pix.isNull() ? UBThumbnailService::service()->placeholder(proxy) : pix;
 }
 
 void UBThumbnailAdaptor::load(std::shared_ptr<UBDocumentProxy> proxy, QList<std::shared_ptr<QPixmap>>& list)
 {
     list.clear();
     UBApplication::showMessage(tr("Loading thumbnails (%1 pages)").arg(proxy->pageCount()));
+    // the views load the thumbnails they show
+    auto placeholder = std::make_shared<QPixmap>(UBThumbnailService::service()->placeholder(proxy));
+
     for(int i=0; i<proxy->pageCount(); i++)
     {
-        list.append(std::make_shared<QPixmap>(get(proxy, i)));
+        list.append(placeholder);
     }
 }
 
 void UBThumbnailAdaptor::persistScene(std::shared_ptr<UBDocumentProxy> proxy, std::shared_ptr<UBGraphicsScene> pScene, int pageIndex, bool overrideModified)
 {
-    QString fileName = proxy->persistencePath() + UBFileSystemUtils::digitFileFormat("/page%1.thumbnail.jpg", pageIndex);
+    QImage thumbnail = render(proxy, pScene, pageIndex, overrideModified);
 
-    QFile thumbFile(fileName);
+    if (!thumbnail.isNull())
+    {
+        UBThumbnailService::service()->insert(proxy, pageIndex, thumbnail);
+        write(proxy->persistencePath(), pageIndex, thumbnail);
+    }
+}
 
-    if (pScene->isModified() || overrideModified || !thumbFile.exists())
+QImage UBThumbnailAdaptor::render(std::shared_ptr<UBDocumentProxy> proxy, std::shared_ptr<UBGraphicsScene> pScene, int pageIndex, bool overrideModified)
+{
+    QFile thumbFile(thumbnailUrl(proxy, pageIndex).toLocalFile());
+
+    if (!pScene->isModified() && !overrideModified && thumbFile.exists())
     {
-        qreal nominalWidth = pScene->nominalSize().width();
-        qreal nominalHeight = pScene->nominalSize().height();
-        qreal ratio = nominalWidth / nominalHeight;
-        QRectF sceneRect = pScene->normalizedSceneRect(ratio);
+        return QImage();
+    }
+
+    qreal nominalWidth = pScene->nominalSize().width();
+    qreal nominalHeight = pScene->nominalSize().height();
+    qreal ratio = nominalWidth / nominalHeight;
+    QRectF sceneRect = pScene->normalizedSceneRect(ratio);
+
+    qreal width = UBSettings::maxThumbnailWidth;
+    qreal height = width / ratio;
+
+    QImage thumb(width, height, QImage::Format_ARGB32);
+
+    QRectF imageRect(0, 0, width, height);
+
+    QPainter painter(&thumb);
+    painter.setRenderHint(QPainter::Antialiasing, true);
+    painter.setRenderHint(QPainter::SmoothPixmapTransform, true);
 
-        qreal width = UBSettings::maxThumbnailWidth;
-        qreal height = width / ratio;
+    if (pScene->isDarkBackground())
+    {
+        painter.fillRect(imageRect, Qt::black);
+    }
+    else
+    {
+        painter.fillRect(imageRect, Qt::white);
+    }
 
-        QImage thumb(width, height, QImage::Format_ARGB32);
+    pScene->setRenderingContext(UBGraphicsScene::NonScreen);
+    pScene->setRenderingQuality(UBItem::RenderingQualityHigh, UBItem::CacheNotAllowed);
 
-        QRectF imageRect(0, 0, width, height);
+    pScene->render(&painter, imageRect, sceneRect, Qt::KeepAspectRatio);
 
-        QPainter painter(&thumb);
-        painter.setRenderHint(QPainter::Antialiasing, true);
-        painter.setRenderHint(QPainter::SmoothPixmapTransform, true);
+    pScene->setRenderingContext(UBGraphicsScene::Screen);
+    pScene->setRenderingQuality(UBItem::RenderingQualityNormal, UBItem::CacheAllowed);
 
-        if (pScene->isDarkBackground())
-        {
-            painter.fillRect(imageRect, Qt::black);
-        }
-        else
-        {
-            painter.fillRect(imageRect, Qt::white);
-        }
+    return thumb;
+}
 
-        pScene->setRenderingContext(UBGraphicsScene::NonScreen);
-        pScene->setRenderingQuality(UBItem::RenderingQualityHigh, UBItem::CacheNotAllowed);
+void UBThumbnailAdaptor::write(const QString& documentPath, int pageIndex, const QImage& thumbnail)
+{
+    write(documentPath, pageIndex, encode(thumbnail));
+}
 
-        pScene->render(&painter, imageRect, sceneRect, Qt::KeepAspectRatio);
+QByteArray UBThumbnailAdaptor::encode(const QImage& thumbnail)
+{
+    QBuffer buffer;
+    buffer.open(QBuffer::WriteOnly);
+    thumbnail.save(&buffer, "JPG");
 
-        pScene->setRenderingContext(UBGraphicsScene::Screen);
-        pScene->setRenderingQuality(UBItem::RenderingQualityNormal, UBItem::CacheAllowed);
+    return buffer.data();
+}
 
-        thumb.scaled(width, height, Qt::KeepAspectRatio, Qt::SmoothTransformation).save(fileName, "JPG");
+void UBThumbnailAdaptor::write(const QString& documentPath, int pageIndex, const QByteArray& jpeg)
+{
+    // flushed to disk together with the page by the persistence worker
+    const QString fileName = documentPath + UBFileSystemUtils::digitFileFormat("/page%1.thumbnail.jpg", pageIndex);
+    if (UBAtomicFileBatch::writeFile(fileName, jpeg, false))
+    {
+        // updated in place, the page file above stays the reference
+        UBThumbnailPack::write(documentPath, pageIndex, jpeg);
     }
 }
 
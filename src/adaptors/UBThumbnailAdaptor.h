@@ -31,6 +31,7 @@
 #define UBTHUMBNAILADAPTOR_H
 
 #include <QtCore>
+#include <QImage>
 
 class UBDocument;
 class UBDocumentProxy;
@@ -45,12 +46,23 @@ public:
 
     static void persistScene(std::shared_ptr<UBDocumentProxy> proxy, std::shared_ptr<UBGraphicsScene> pScene, int pageIndex, bool overrideModified = false);
 
+    // renders the thumbnail on the GUI thread, returns a null image if the thumbnail is up to date
+    static QImage render(std::shared_ptr<UBDocumentProxy> proxy, std::shared_ptr<UBGraphicsScene> pScene, int pageIndex, bool overrideModified = false);
+
+    // encodes and writes a rendered thumbnail to its page file and the pack, can be called on any thread
+    static void write(const QString& documentPath, int pageIndex, const QImage& thumbnail);
+
+    // the two steps of write(), so that the page index can be checked between encoding and writing
+    static QByteArray encode(const QImage& thumbnail);
+    static void write(const QString& documentPath, int pageIndex, const QByteArray& jpeg);
+
+    // returns a placeholder while the thumbnail is loaded or generated, see UBThumbnailService
     static QPixmap get(std::shared_ptr<UBDocumentProxy> proxy, int index);
+
+    // fills the list with placeholders only
     static void load(std::shared_ptr<UBDocumentProxy> proxy, QList<std::shared_ptr<QPixmap>>& list);
 
 private:
-    static void generateMissingThumbnails(std::shared_ptr<UBDocumentProxy> proxy);
-
     UBThumbnailAdaptor() {}
 };
 
@@ -0,0 +1,471 @@
+/*
+ * Copyright (C) 2015-2022 Département de l'Instruction Publique (DIP-SEM)
+ *
+ * Copyright (C) 2013 Open Education Foundation
+ *
+ * Copyright (C) 2010-2013 Groupement d'Intérêt Public pour
+ * l'Education Numérique en Afrique (GIP ENA)
+ *
+ * This file is part of OpenBoard.
+ *
+ * OpenBoard is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3 of the License,
+ * with a specific linking exception for the OpenSSL project's
+ * "OpenSSL" library (or with modified versions of it that use the
+ * same license as the "OpenSSL" library).
+ *
+ * OpenBoard is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with OpenBoard. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+
+
+
+
+
+#include "UBThumbnailPack.h"
+
+#include <QDateTime>
+#include <QFile>
+#include <QFileInfo>
+#include <QList>
+#include <QMutex>
+#include <QPair>
+#include <QVector>
+#include <QtEndian>
+
+#include <cstring>
+#include <memory>
+
+#include "frameworks/UBAtomicFileBatch.h"
+
+#include "UBMetadataDcSubsetAdaptor.h"
+
+#include "core/memcheck.h"
+
+namespace
+{
+    const char sMagic[4] = {'O', 'B', 'T', 'P'};
+    // version 3 stamps the whole pack with the metadata file of the document
+    const quint32 sVersion = 3;
+
+    // magic, version, capacity of the index, size and modification time of the metadata file
+    const qint64 sHeaderSize = 24;
+    const qint64 sStampOffset = 12;
+
+    // offset, size
+    const qint64 sEntrySize = 12;
+
+    const quint32 sMinimumCapacity = 64;
+
+    // outdated data tolerated before compacting
+    const qint64 sCompactionSlack = 1024 * 1024;
+
+    // packs of recently used documents stay open
+    const int sMaximumOpenPacks = 4;
+
+    struct Entry
+    {
+        quint64 offset;
+        quint32 size;
+    };
+
+    // every version rewrites the metadata file when a document was changed, the pack is
+    // only valid for the metadata file it was written with
+    struct Stamp
+    {
+        quint32 metadataSize;
+        qint64 metadataModified;
+
+        bool operator!=(const Stamp& other) const
+        {
+            return metadataSize != other.metadataSize || metadataModified != other.metadataModified;
+        }
+    };
+
+    class PackFile
+    {
+        public:
+            explicit PackFile(const QString& documentPath)
+                : mFile(UBThumbnailPack::fileName(documentPath))
+                , mMetadataFileName(documentPath + "/" + UBMetadataDcSubsetAdaptor::metadataFilename)
+                , mLoaded(false)
+                , mMap(nullptr)
+                , mMapSize(0)
+                , mUsed(0)
+            {
+            }
+
+            ~PackFile()
+            {
+                close();
+            }
+
+            QByteArray read(int pageIndex)
+            {
+                QMutexLocker locker(&mMutex);
+                load();
+
+                if (!mFile.isOpen() || pageIndex < 0 || pageIndex >= mIndex.size() || mIndex.at(pageIndex).size == 0)
+                {
+                    return QByteArray();
+                }
+
+                return data(mIndex.at(pageIndex));
+            }
+
+            void write(int pageIndex, const QByteArray& jpeg, bool replace)
+            {
+                QMutexLocker locker(&mMutex);
+                load();
+
+                // keeps a thumbnail written meanwhile
+                if (!replace && mFile.isOpen() && pageIndex < mIndex.size() && mIndex.at(pageIndex).size > 0)
+                    return;
+
+                if (!mFile.isOpen() || !mFile.isWritable() || pageIndex >= mIndex.size())
+                {
+                    quint32 capacity = qMax(sMinimumCapacity, quint32(mIndex.size()));
+
+                    while (capacity <= quint32(pageIndex))
+                        capacity *= 2;
+
+                    rebuild(capacity, pageIndex, jpeg);
+                    return;
+                }
+
+                // append the data first, so that the entry never points to incomplete data
+                const Entry entry = {quint64(mFile.size()), quint32(jpeg.size())};
+
+                if (!mFile.seek(entry.offset) || mFile.write(jpeg) != jpeg.size())
+                    return;
+
+                if (!mFile.seek(sHeaderSize + pageIndex * sEntrySize) || mFile.write(entryBytes(entry)) != sEntrySize)
+                    return;
+
+                mFile.flush();
+
+                mUsed += qint64(entry.size) - qint64(mIndex.at(pageIndex).size);
+                mIndex[pageIndex] = entry;
+
+                const qint64 dataSize = mFile.size() - sHeaderSize - mIndex.size() * sEntrySize;
+
+                if (dataSize > 2 * mUsed + sCompactionSlack)
+                {
+                    rebuild(mIndex.size(), -1, QByteArray());
+                }
+            }
+
+            bool isCurrent()
+            {
+                QMutexLocker locker(&mMutex);
+                load();
+
+                return mFile.isOpen();
+            }
+
+            void restamp()
+            {
+                QMutexLocker locker(&mMutex);
+                load();
+
+                if (!mFile.isOpen() || !mFile.isWritable() || !mFile.seek(sStampOffset))
+                    return;
+
+                if (mFile.write(stampBytes(metadataStamp())) == sHeaderSize - sStampOffset)
+                    mFile.flush();
+            }
+
+            void remove()
+            {
+                QMutexLocker locker(&mMutex);
+
+                close();
+                QFile::remove(mFile.fileName());
+
+                // known to be missing until the next write
+                mIndex.clear();
+                mUsed = 0;
+                mLoaded = true;
+            }
+
+        private:
+            void load()
+            {
+                // called with mMutex locked
+                if (mLoaded)
+                    return;
+
+                mLoaded = true;
+                mIndex.clear();
+                mUsed = 0;
+
+                if (!mFile.exists() || (!mFile.open(QIODevice::ReadWrite) && !mFile.open(QIODevice::ReadOnly)))
+                    return;
+
+                QByteArray header = mFile.read(sHeaderSize);
+
+                if (header.size() != sHeaderSize
+                        || std::memcmp(header.constData(), sMagic, sizeof(sMagic)) != 0
+                        || qFromLittleEndian<quint32>(header.constData() + 4) != sVersion)
+                {
+                    // unknown or damaged, replaced on the next write
+                    close();
+                    return;
+                }
+
+                const Stamp stamp = {qFromLittleEndian<quint32>(header.constData() + sStampOffset), qFromLittleEndian<qint64>(header.constData() + sStampOffset + 4)};
+
+                if (stamp != metadataStamp())
+                {
+                    // the document was changed without the pack, e.g. by an older version
+                    close();
+                    return;
+                }
+
+                const quint32 capacity = qFromLittleEndian<quint32>(header.constData() + 8);
+
+                if (qint64(capacity) * sEntrySize > mFile.size() - sHeaderSize)
+                {
+                    close();
+                    return;
+                }
+
+                const QByteArray index = mFile.read(capacity * sEntrySize);
+
+                if (index.size() != qint64(capacity) * sEntrySize)
+                {
+                    close();
+                    return;
+                }
+
+                const quint64 dataStart = sHeaderSize + capacity * sEntrySize;
+                const quint64 fileSize = mFile.size();
+
+                mIndex.resize(capacity);
+
+                for (quint32 i = 0; i < capacity; ++i)
+                {
+                    const char* entryData = index.constData() + i * sEntrySize;
+                    Entry entry = {qFromLittleEndian<quint64>(entryData), qFromLittleEndian<quint32>(entryData + 8)};
+
+                    if (entry.size == 0 || entry.offset < dataStart || entry.offset + entry.size > fileSize)
+                    {
+                        entry = Entry();
+                    }
+
+                    mIndex[i] = entry;
+                    mUsed += entry.size;
+                }
+            }
+
+            void close()
+            {
+                if (mMap)
+                {
+                    mFile.unmap(mMap);
+                    mMap = nullptr;
+                    mMapSize = 0;
+                }
+
+                mFile.close();
+            }
+
+            QByteArray data(const Entry& entry)
+            {
+                // called with mMutex locked, the mapping grows with the file
+                if (entry.offset + entry.size > quint64(mMapSize))
+                {
+                    if (mMap)
+                        mFile.unmap(mMap);
+
+                    mMapSize = mFile.size();
+                    mMap = mFile.map(0, mMapSize);
+
+                    if (!mMap)
+                        mMapSize = 0;
+                }
+
+                if (mMap)
+                {
+                    return QByteArray(reinterpret_cast<const char*>(mMap + entry.offset), entry.size);
+                }
+
+                if (!mFile.seek(entry.offset))
+                    return QByteArray();
+
+                return mFile.read(entry.size);
+            }
+
+            void rebuild(quint32 capacity, int pageIndex, const QByteArray& jpeg)
+            {
+                // called with mMutex locked, writes a new file with the current thumbnails and the given one
+                QByteArray pack(sHeaderSize + capacity * sEntrySize, '\0');
+
+                std::memcpy(pack.data(), sMagic, sizeof(sMagic));
+                qToLittleEndian<quint32>(sVersion, pack.data() + 4);
+                qToLittleEndian<quint32>(capacity, pack.data() + 8);
+                std::memcpy(pack.data() + sStampOffset, stampBytes(metadataStamp()).constData(), sHeaderSize - sStampOffset);
+
+                for (quint32 i = 0; i < capacity; ++i)
+                {
+                    QByteArray blob;
+                    Entry entry = Entry();
+
+                    if (int(i) == pageIndex)
+                    {
+                        blob = jpeg;
+                    }
+                    else if (mFile.isOpen() && int(i) < mIndex.size() && mIndex.at(i).size > 0)
+                    {
+                        blob = data(mIndex.at(i));
+                        entry = mIndex.at(i);
+                    }
+
+                    if (!blob.isEmpty())
+                    {
+                        entry.offset = quint64(pack.size());
+                        entry.size = quint32(blob.size());
+                        std::memcpy(pack.data() + sHeaderSize + i * sEntrySize, entryBytes(entry).constData(), sEntrySize);
+                        pack.append(blob);
+                    }
+                }
+
+                // closed first, so that it can be replaced on every platform
+                close();
+                UBAtomicFileBatch::writeFile(mFile.fileName(), pack, false);
+
+                mLoaded = false;
+                load();
+            }
+
+            Stamp metadataStamp() const
+            {
+                const QFileInfo metadata(mMetadataFileName);
+
+                if (!metadata.exists())
+                    return {0, 0};
+
+                return {quint32(metadata.size()), metadata.lastModified().toMSecsSinceEpoch()};
+            }
+
+            static QByteArray stampBytes(const Stamp& stamp)
+            {
+                QByteArray bytes(sHeaderSize - sStampOffset, '\0');
+
+                qToLittleEndian<quint32>(stamp.metadataSize, bytes.data());
+                qToLittleEndian<qint64>(stamp.metadataModified, bytes.data() + 4);
+
+                return bytes;
+            }
+
+            static QByteArray entryBytes(const Entry& entry)
+            {
+                QByteArray bytes(sEntrySize, '\0');
+
+                qToLittleEndian<quint64>(entry.offset, bytes.data());
+                qToLittleEndian<quint32>(entry.size, bytes.data() + 8);
+
+                return bytes;
+            }
+
+            QMutex mMutex;
+            QFile mFile;
+            const QString mMetadataFileName;
+            bool mLoaded;
+            uchar* mMap;
+            qint64 mMapSize;
+            QVector<Entry> mIndex;
+            qint64 mUsed;
+    };
+
+    QMutex sPacksMutex;
+    QList<QPair<QString, std::shared_ptr<PackFile>>> sPacks;
+
+    std::shared_ptr<PackFile> pack(const QString& documentPath)
+    {
+        QMutexLocker locker(&sPacksMutex);
+
+        for (int i = 0; i < sPacks.size(); ++i)
+        {
+            if (sPacks.at(i).first == documentPath)
+            {
+                sPacks.move(i, 0);
+                return sPacks.first().second;
+            }
+        }
+
+        std::shared_ptr<PackFile> packFile = std::make_shared<PackFile>(documentPath);
+        sPacks.prepend(qMakePair(documentPath, packFile));
+
+        // the file is closed when its last user is done
+        while (sPacks.size() > sMaximumOpenPacks)
+            sPacks.removeLast();
+
+        return packFile;
+    }
+}
+
+QAtomicInt UBThumbnailPack::sEnabled = 1;
+
+void UBThumbnailPack::setEnabled(bool enabled)
+{
+    sEnabled.storeRelease(enabled ? 1 : 0);
+}
+
+bool UBThumbnailPack::isEnabled()
+{
+    return sEnabled.loadAcquire() != 0;
+}
+
+QString UBThumbnailPack::fileName(const QString& documentPath)
+{
+    return documentPath + "/thumbnails.pack";
+}
+
+QByteArray UBThumbnailPack::read(const QString& documentPath, int pageIndex)
+{
+    if (!isEnabled())
+        return QByteArray();
+
+    return pack(documentPath)->read(pageIndex);
+}
+
+void UBThumbnailPack::write(const QString& documentPath, int pageIndex, const QByteArray& jpeg)
+{
+    if (!isEnabled() || pageIndex < 0 || jpeg.isEmpty())
+        return;
+
+    pack(documentPath)->write(pageIndex, jpeg, true);
+}
+
+void UBThumbnailPack::add(const QString& documentPath, int pageIndex, const QByteArray& jpeg)
+{
+    if (!isEnabled() || pageIndex < 0 || jpeg.isEmpty())
+        return;
+
+    pack(documentPath)->write(pageIndex, jpeg, false);
+}
+
+bool UBThumbnailPack::isCurrent(const QString& documentPath)
+{
+    return isEnabled() && pack(documentPath)->isCurrent();
+}
+
+void UBThumbnailPack::restamp(const QString& documentPath)
+{
+    if (isEnabled())
+        pack(documentPath)->restamp();
+}
+
+void UBThumbnailPack::remove(const QString& documentPath)
+{
+    pack(documentPath)->remove();
+}
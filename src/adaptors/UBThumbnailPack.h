@@ -0,0 +1,84 @@
+/*
+ * Copyright (C) 2015-2022 Département de l'Instruction Publique (DIP-SEM)
+ *
+ * Copyright (C) 2013 Open Education Foundation
+ *
+ * Copyright (C) 2010-2013 Groupement d'Intérêt Public pour
+ * l'Education Numérique en Afrique (GIP ENA)
+ *
+ * This file is part of OpenBoard.
+ *
+ * OpenBoard is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3 of the License,
+ * with a specific linking exception for the OpenSSL project's
+ * "OpenSSL" library (or with modified versions of it that use the
+ * same license as the "OpenSSL" library).
+ *
+ * OpenBoard is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with OpenBoard. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+
+
+
+
+
+#ifndef UBTHUMBNAILPACK_H
+#define UBTHUMBNAILPACK_H
+
+#include <QAtomicInt>
+#include <QByteArray>
+#include <QString>
+
+/**
+ * Keeps the page thumbnails of a document in a single file, so that opening a
+ * document reads one file instead of one per page.
+ *
+ * The file starts with a header and an index with one entry per page, followed by
+ * the JPEG data. A thumbnail is updated in place: its data is appended and its index
+ * entry rewritten. The file is compacted when most of it is unused. Readers map the
+ * file, an opened pack is kept for the next pages.
+ *
+ * The pack is a cache. The page%03d.thumbnail.jpg files are still written and are
+ * read for pages missing in the pack. The header keeps the size and modification
+ * time of the metadata file of the document, which every version rewrites after
+ * changing the document. A pack not matching the current metadata file is outdated
+ * as a whole and replaced, so that pages are validated without looking at their
+ * files. Packs may be used from any thread.
+ */
+class UBThumbnailPack
+{
+    public:
+        static void setEnabled(bool enabled);
+        static bool isEnabled();
+
+        static QString fileName(const QString& documentPath);
+
+        // returns an empty array if the pack has no thumbnail or is outdated
+        static QByteArray read(const QString& documentPath, int pageIndex);
+        static void write(const QString& documentPath, int pageIndex, const QByteArray& jpeg);
+
+        // keeps a thumbnail written meanwhile, for filling the pack from the page files
+        static void add(const QString& documentPath, int pageIndex, const QByteArray& jpeg);
+
+        // the metadata file is rewritten, a current pack is stamped again afterwards
+        static bool isCurrent(const QString& documentPath);
+        static void restamp(const QString& documentPath);
+
+        // the pages of the document were renumbered
+        static void remove(const QString& documentPath);
+
+    private:
+        UBThumbnailPack() {}
+
+        static QAtomicInt sEnabled;
+};
+
+#endif // UBTHUMBNAILPACK_H
@@ -3,12 +3,15 @@ HEADERS      += src/adaptors/UBExportAdaptor.h\
     $$PWD/UBWidgetUpgradeAdaptor.h \
                 src/adaptors/UBExportPDF.h \
                 src/adaptors/UBExportFullPDF.h \
+                src/adaptors/UBExportSceneLoader.h \
                 src/adaptors/UBExportDocument.h \
                 src/adaptors/UBSvgSubsetAdaptor.h \
+                src/adaptors/UBSvgFragmentCache.h \
                 src/adaptors/UBMetadataDcSubsetAdaptor.h \
                 src/adaptors/UBImportAdaptor.h \
                 src/adaptors/UBImportDocument.h \
                 src/adaptors/UBThumbnailAdaptor.h \
+                src/adaptors/UBThumbnailPack.h \
                 src/adaptors/UBImportPDF.h \
                 src/adaptors/UBImportImage.h \
                 src/adaptors/UBExportWeb.h \
@@ -23,12 +26,15 @@ SOURCES      += src/adaptors/UBExportAdaptor.cpp\
     $$PWD/UBWidgetUpgradeAdaptor.cpp \
                 src/adaptors/UBExportPDF.cpp \
                 src/adaptors/UBExportFullPDF.cpp \
+                src/adaptors/UBExportSceneLoader.cpp \
                 src/adaptors/UBExportDocument.cpp \
                 src/adaptors/UBSvgSubsetAdaptor.cpp \
+                src/adaptors/UBSvgFragmentCache.cpp \
                 src/adaptors/UBMetadataDcSubsetAdaptor.cpp \
                 src/adaptors/UBImportAdaptor.cpp \
                 src/adaptors/UBImportDocument.cpp \
                 src/adaptors/UBThumbnailAdaptor.cpp \
+                src/adaptors/UBThumbnailPack.cpp \
                 src/adaptors/UBImportPDF.cpp \
                 src/adaptors/UBImportImage.cpp \
                 src/adaptors/UBExportWeb.cpp \
@@ -74,6 +74,7 @@
 #include "domain/UBGraphicsSvgItem.h"
 #include "domain/UBGraphicsGroupContainerItem.h"
 #include "domain/UBGraphicsStrokesGroup.h"
+#include "domain/UBWetInkStroke.h"
 #include "domain/UBGraphicsItemDelegate.h"
 #include "domain/UBGraphicsTextItemDelegate.h"
 
@@ -181,6 +182,11 @@ void UBBoardView::init ()
     setCacheMode (QGraphicsView::CacheBackground);
 
     mUsingTabletEraser = false;
+    mWetInkStrokeId = 0;
+    mWetInkRasterizedCount = 0;
+    mInkLatencySamples = 0;
+    mInkLatencyTotal = 0;
+    mInkLatencyMax = 0;
     mIsCreatingTextZone = false;
     mRubberBand = 0;
     mUBRubberBand = 0;
@@ -364,6 +370,8 @@ void UBBoardView::tabletEvent (QTabletEvent * event)
 
             mUsingTabletEraser = false;
         }
+
+        dc->setUsingTabletEraser (mUsingTabletEraser);
     }
 
     QPointF scenePos = viewportTransform ().inverted ().map (tabletPos);
@@ -378,6 +386,11 @@ void UBBoardView::tabletEvent (QTabletEvent * event)
         return;
     }
 
+    // the oldest event not painted yet is measured
+    if (UBApplication::app()->isVerbose() && !mInkLatencyTimer.isValid()
+            && (event->type() == QEvent::TabletPress || (event->type() == QEvent::TabletMove && mTabletStylusIsPressed)))
+        mInkLatencyTimer.start();
+
     bool acceptEvent = true;
 #ifdef Q_OS_OSX
     //Work around #1388. After selecting annotation tool in desktop mode, annotation view appears on top when
@@ -1877,6 +1890,9 @@ void UBBoardView::drawBackground (QPainter *painter, const QRectF &rect)
 
 void UBBoardView::drawForeground(QPainter* painter, const QRectF& rect)
 {
+    // the stroke being drawn is below the margin covers, like the other items
+    paintWetInk(painter);
+
     QTransform transform{viewportTransform()};
     QRect viewportRect(0, 0, viewport()->width(), viewport()->height());
     QRectF visible{mapToScene(viewportRect).boundingRect()};
@@ -1923,6 +1939,99 @@ void UBBoardView::drawForeground(QPainter* painter, const QRectF& rect)
     painter->restore();
 }
 
+void UBBoardView::paintWetInk(QPainter* painter)
+{
+    std::shared_ptr<UBGraphicsScene> currentScene = scene();
+    const UBWetInkStroke* stroke = currentScene ? currentScene->wetInkStroke() : nullptr;
+
+    if (!stroke)
+    {
+        mWetInkImage = QImage();
+        mWetInkStrokeId = 0;
+        traceInkLatency(true);
+        return;
+    }
+
+    const qreal ratio = devicePixelRatioF();
+    const QSize size = viewport()->size() * ratio;
+    const QTransform transform = viewportTransform();
+
+    // a new stroke, or the view was scrolled, zoomed or resized: start over
+    if (stroke->id() != mWetInkStrokeId || transform != mWetInkTransform || mWetInkImage.size() != size)
+    {
+        mWetInkImage = QImage(size, QImage::Format_ARGB32_Premultiplied);
+        mWetInkImage.setDevicePixelRatio(ratio);
+        mWetInkImage.fill(Qt::transparent);
+
+        mWetInkStrokeId = stroke->id();
+        mWetInkTransform = transform;
+        mWetInkRasterizedCount = 0;
+    }
+
+    const QList<QPolygonF>& polygons = stroke->polygons();
+
+    // only the segments added since the last paint are rasterised, opaque so that they do not darken each other
+    if (mWetInkRasterizedCount < polygons.size())
+    {
+        QPainter imagePainter(&mWetInkImage);
+        imagePainter.setRenderHint(QPainter::Antialiasing);
+        imagePainter.setPen(Qt::NoPen);
+        imagePainter.setBrush(stroke->opaqueColor());
+        imagePainter.setTransform(transform);
+
+        for (int i = mWetInkRasterizedCount; i < polygons.size(); ++i)
+            imagePainter.drawPolygon(polygons.at(i), Qt::WindingFill);
+
+        mWetInkRasterizedCount = polygons.size();
+    }
+
+    painter->save();
+    painter->setOpacity(stroke->opacity());
+    painter->resetTransform();
+    painter->drawImage(QPointF(0, 0), mWetInkImage);
+
+    if (!stroke->tempPolygon().isEmpty())
+    {
+        painter->setTransform(transform);
+        painter->setRenderHint(QPainter::Antialiasing);
+        painter->setPen(Qt::NoPen);
+        painter->setBrush(stroke->opaqueColor());
+        painter->drawPolygon(stroke->tempPolygon(), Qt::WindingFill);
+    }
+
+    painter->restore();
+
+    traceInkLatency(false);
+}
+
+void UBBoardView::traceInkLatency(bool strokeFinished)
+{
+    if (strokeFinished)
+    {
+        // events of other tools are not painted as wet ink
+        mInkLatencyTimer.invalidate();
+
+        if (mInkLatencySamples > 0)
+        {
+            qDebug() << "wet ink latency:" << mInkLatencySamples << "events, mean"
+                     << mInkLatencyTotal / mInkLatencySamples / 1000 << "us, max" << mInkLatencyMax / 1000 << "us";
+        }
+
+        mInkLatencySamples = 0;
+        mInkLatencyTotal = 0;
+        mInkLatencyMax = 0;
+    }
+    else if (mInkLatencyTimer.isValid())
+    {
+        const qint64 latency = mInkLatencyTimer.nsecsElapsed();
+        mInkLatencyTimer.invalidate();
+
+        mInkLatencySamples++;
+        mInkLatencyTotal += latency;
+        mInkLatencyMax = qMax(mInkLatencyMax, latency);
+    }
+}
+
 void UBBoardView::scrollContentsBy(int dx, int dy)
 {
     QGraphicsView::scrollContentsBy(dx, dy);
@@ -32,6 +32,7 @@
 #define CONTROLVIEW_OBJ_NAME "ControlView"
 
 #include <QtGui>
+#include <QElapsedTimer>
 #include <QGraphicsView>
 #include <QRubberBand>
 
@@ -137,6 +138,9 @@ private:
 
     QList<QUrl> processMimeData(const QMimeData* pMimeData);
 
+    void paintWetInk(QPainter* painter);
+    void traceInkLatency(bool strokeFinished);
+
     UBBoardController* mController;
 
     int mStartLayer, mEndLayer;
@@ -145,6 +149,18 @@ private:
     bool mTabletStylusIsPressed;
     bool mUsingTabletEraser;
 
+    // wet ink of the stroke being drawn, rasterised in viewport pixels
+    QImage mWetInkImage;
+    quint64 mWetInkStrokeId;
+    int mWetInkRasterizedCount;
+    QTransform mWetInkTransform;
+
+    // time from a tablet event to the paint showing it, traced in verbose mode
+    QElapsedTimer mInkLatencyTimer;
+    int mInkLatencySamples;
+    qint64 mInkLatencyTotal;
+    qint64 mInkLatencyMax;
+
     bool mPendingStylusReleaseEvent;
 
     bool mMouseButtonIsPressed;
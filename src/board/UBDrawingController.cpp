@@ -63,6 +63,7 @@ UBDrawingController::UBDrawingController(QObject * parent)
     , mStylusTool((UBStylusTool::Enum)-1)
     , mLatestDrawingTool((UBStylusTool::Enum)-1)
     , mIsDesktopMode(false)
+    , mUsingTabletEraser(false)
 {
     connect(UBSettings::settings(), SIGNAL(colorContextChanged()), this, SIGNAL(colorPaletteChanged()));
 
@@ -364,6 +365,24 @@ UBAbstractDrawRuler* UBDrawingController::activeRuler() const
     return nullptr;
 }
 
+void UBDrawingController::setUsingTabletEraser(bool usingTabletEraser)
+{
+    mUsingTabletEraser = usingTabletEraser;
+}
+
+/**
+ * @brief Whether the eraser removes whole strokes instead of clipping them
+ *
+ * The eraser end of a tablet pen has its own setting.
+ */
+bool UBDrawingController::isWholeStrokeEraser() const
+{
+    if (mUsingTabletEraser)
+        return UBSettings::settings()->boardTabletEraserErasesWholeStrokes->get().toBool();
+
+    return UBSettings::settings()->boardEraseWholeStrokes->get().toBool();
+}
+
 
 void UBDrawingController::penToolSelected(bool checked)
 {
@@ -68,6 +68,9 @@ class UBDrawingController : public QObject
         void setActiveRuler(UBAbstractDrawRuler* ruler);
         UBAbstractDrawRuler* activeRuler() const;
 
+        void setUsingTabletEraser(bool usingTabletEraser);
+        bool isWholeStrokeEraser() const;
+
         void setInDesktopMode(bool mode){
             mIsDesktopMode = mode;
         }
@@ -95,6 +98,7 @@ class UBDrawingController : public QObject
         UBStylusTool::Enum mStylusTool;
         UBStylusTool::Enum mLatestDrawingTool;
         bool mIsDesktopMode;
+        bool mUsingTabletEraser;
 
         static UBDrawingController* sDrawingController;
 
@@ -46,6 +46,7 @@
 #include "UBIdleTimer.h"
 #include "UBApplicationController.h"
 #include "UBShortcutManager.h"
+#include "UBThumbnailService.h"
 
 #include "board/UBBoardController.h"
 #include "board/UBDrawingController.h"
@@ -165,6 +166,8 @@ UBApplication::~UBApplication()
 
     UBPersistenceManager::destroy();
 
+    UBThumbnailService::destroy();
+
     UBDownloadManager::destroy();
 
     UBDrawingController::destroy();
@@ -27,6 +27,8 @@
 
 #include "UBDocumentManager.h"
 
+#include <QProgressDialog>
+
 #include "frameworks/UBStringUtils.h"
 
 #include "adaptors/UBExportFullPDF.h"
@@ -48,8 +50,11 @@
 #include "document/UBDocumentController.h"
 #include "board/UBBoardController.h"
 
+#include "gui/UBMainWindow.h"
+
 #include "UBApplication.h"
 #include "UBSettings.h"
+#include "UBPageImporter.h"
 #include "UBPersistenceManager.h"
 
 #include "../adaptors/UBExportWeb.h"
@@ -210,6 +215,31 @@ std::shared_ptr<UBDocumentProxy> UBDocumentManager::importFile(const QFile& pFil
                         }
                     }
 
+                    UBPageImporter* pageImporter = importAdaptor->createPageImporter(document, uuid, filepath);
+
+                    if (pageImporter)
+                    {
+                        // the document can be opened with its first page, the other pages follow in the background
+                        pageImporter->setParent(this);
+                        pageImporter->importFirstPage();
+                        UBPersistenceManager::persistenceManager()->persistDocumentMetadata(document);
+
+                        // shown when the import takes a while, lets the user stop it
+                        QProgressDialog* progress = new QProgressDialog(tr("Importing %1...").arg(documentName), tr("Cancel"),
+                                                                        0, pageImporter->pageCount(), UBApplication::mainWindow);
+                        progress->setWindowModality(Qt::NonModal);
+                        progress->setMinimumDuration(2000);
+
+                        connect(pageImporter, &UBPageImporter::progress, progress, &QProgressDialog::setValue);
+                        connect(pageImporter, &UBPageImporter::finished, progress, &QObject::deleteLater);
+                        connect(progress, &QProgressDialog::canceled, pageImporter, &UBPageImporter::cancel);
+
+                        pageImporter->start();
+
+                        UBApplication::setDisabled(false);
+                        return document;
+                    }
+
                     QList<UBGraphicsItem*> pages = importAdaptor->import(uuid, filepath);
                     int pageIndex = 0;
 
@@ -0,0 +1,290 @@
+/*
+ * Copyright (C) 2015-2022 Département de l'Instruction Publique (DIP-SEM)
+ *
+ * Copyright (C) 2013 Open Education Foundation
+ *
+ * Copyright (C) 2010-2013 Groupement d'Intérêt Public pour
+ * l'Education Numérique en Afrique (GIP ENA)
+ *
+ * This file is part of OpenBoard.
+ *
+ * OpenBoard is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3 of the License,
+ * with a specific linking exception for the OpenSSL project's
+ * "OpenSSL" library (or with modified versions of it that use the
+ * same license as the "OpenSSL" library).
+ *
+ * OpenBoard is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with OpenBoard. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+
+
+
+
+
+#include "UBPageImporter.h"
+
+#include <QElapsedTimer>
+#include <QFutureWatcher>
+#include <QtConcurrent>
+
+#include "adaptors/UBThumbnailAdaptor.h"
+
+#include "board/UBBoardController.h"
+
+#include "core/UBApplication.h"
+#include "core/UBPersistenceManager.h"
+#include "core/UBSettings.h"
+#include "core/UBThumbnailService.h"
+
+#include "document/UBDocumentController.h"
+#include "document/UBDocumentProxy.h"
+
+#include "domain/UBGraphicsScene.h"
+
+#include "core/memcheck.h"
+
+namespace
+{
+    // time spent on the GUI thread before handling events again
+    const int sSliceDuration = 20;
+
+    // pages waiting for the persistence worker before the import waits for it
+    const int sMaximumPendingWrites = 16;
+    const int sThrottleInterval = 50;
+}
+
+UBPageImporter::UBPageImporter(std::shared_ptr<UBDocumentProxy> document, int pageCount, QObject* parent)
+    : QObject(parent)
+    , mDocument(document)
+    , mPageCount(pageCount)
+    , mNextPage(0)
+    , mPendingThumbnails(0)
+    , mRenumberCount(0)
+    , mCancelled(false)
+    , mDone(false)
+    , mDocumentDeleted(false)
+{
+    mThreadPool.setMaxThreadCount(qBound(1, QThread::idealThreadCount() / 2, 4));
+
+    mSliceTimer.setSingleShot(true);
+    connect(&mSliceTimer, &QTimer::timeout, this, &UBPageImporter::importNextPages);
+
+    connect(UBPersistenceManager::persistenceManager(), &UBPersistenceManager::documentWillBeDeleted, this, &UBPageImporter::onDocumentWillBeDeleted);
+    connect(UBThumbnailService::service(), &UBThumbnailService::invalidated, this, &UBPageImporter::onDocumentInvalidated);
+}
+
+UBPageImporter::~UBPageImporter()
+{
+    waitForThumbnails();
+}
+
+bool UBPageImporter::importFirstPage()
+{
+    if (mPageCount <= 0)
+    {
+        return false;
+    }
+
+    importPage(mNextPage++, true);
+    return true;
+}
+
+void UBPageImporter::start()
+{
+    if (mNextPage < mPageCount)
+    {
+        UBApplication::showMessage(tr("Importing page %1 of %2...").arg(mNextPage).arg(mPageCount), true);
+        mSliceTimer.start(0);
+    }
+    else
+    {
+        finish(false);
+    }
+}
+
+void UBPageImporter::cancel()
+{
+    if (!mDone)
+    {
+        mCancelled = true;
+        finish(true);
+    }
+}
+
+void UBPageImporter::waitForThumbnails()
+{
+    mThreadPool.waitForDone();
+}
+
+void UBPageImporter::importNextPages()
+{
+    if (mDone)
+    {
+        return;
+    }
+
+    if (UBApplication::isClosing)
+    {
+        cancel();
+        return;
+    }
+
+    UBPersistenceManager* persistenceManager = UBPersistenceManager::persistenceManager();
+
+    if (persistenceManager->pendingWriteCount() > sMaximumPendingWrites)
+    {
+        // the pages are created faster than written, do not keep all of them in memory
+        mSliceTimer.start(sThrottleInterval);
+        return;
+    }
+
+    const int firstSceneIndex = mDocument->pageCount();
+
+    QElapsedTimer slice;
+    slice.start();
+
+    do
+    {
+        importPage(mNextPage++, false);
+    }
+    while (mNextPage < mPageCount && slice.elapsed() < sSliceDuration);
+
+    // show the new pages in the views displaying the document
+    const bool updateBoard = UBApplication::boardController && UBApplication::boardController->selectedDocument() == mDocument;
+    const bool updateDocumentView = UBApplication::documentController && UBApplication::documentController->selectedDocument() == mDocument;
+
+    if (updateBoard)
+    {
+        for (int sceneIndex = firstSceneIndex; sceneIndex < mDocument->pageCount(); ++sceneIndex)
+            emit UBApplication::boardController->addThumbnailRequired(mDocument, sceneIndex);
+    }
+
+    // only the new items, the whole view is refreshed once at the end of the import
+    if (updateDocumentView)
+    {
+        UBApplication::documentController->appendThumbnails(mDocument, firstSceneIndex);
+    }
+
+    emit progress(mNextPage, mPageCount);
+
+    if (mNextPage < mPageCount)
+    {
+        UBApplication::showMessage(tr("Importing page %1 of %2...").arg(mNextPage).arg(mPageCount), true);
+        mSliceTimer.start(0);
+    }
+    else
+    {
+        finish(false);
+    }
+}
+
+void UBPageImporter::onDocumentWillBeDeleted(std::shared_ptr<UBDocumentProxy> document)
+{
+    if (document == mDocument)
+    {
+        // nothing may be written to the directory anymore
+        mDocumentDeleted = true;
+        cancel();
+    }
+}
+
+void UBPageImporter::onDocumentInvalidated(std::shared_ptr<UBDocumentProxy> document)
+{
+    if (document == mDocument)
+    {
+        ++mRenumberCount;
+    }
+}
+
+void UBPageImporter::importPage(int pageIndex, bool immediate)
+{
+    UBPersistenceManager* persistenceManager = UBPersistenceManager::persistenceManager();
+
+    // appended, the user may work on the document meanwhile
+    const int sceneIndex = mDocument->pageCount();
+    const QString documentPath = mDocument->persistencePath();
+
+    UBGraphicsItem* item = createPageItem(pageIndex);
+    std::shared_ptr<UBGraphicsScene> scene = persistenceManager->createDocumentSceneAt(mDocument, sceneIndex, true, false);
+    placePageItem(scene, item);
+
+    if (immediate)
+    {
+        // the document is opened with this page, its thumbnail is needed now
+        QImage thumbnail = renderThumbnail(pageIndex, UBSettings::maxThumbnailWidth);
+
+        if (!thumbnail.isNull())
+        {
+            UBThumbnailAdaptor::write(documentPath, sceneIndex, thumbnail);
+            UBThumbnailService::service()->insert(mDocument, sceneIndex, thumbnail);
+        }
+
+        persistenceManager->persistDocumentScene(mDocument, scene, sceneIndex, false, true, thumbnail.isNull());
+        return;
+    }
+
+    persistenceManager->persistDocumentScene(mDocument, scene, sceneIndex, false, false, false);
+
+    ++mPendingThumbnails;
+
+    // the rendered thumbnail and its JPEG
+    typedef QPair<QImage, QByteArray> EncodedThumbnail;
+
+    QFutureWatcher<EncodedThumbnail>* watcher = new QFutureWatcher<EncodedThumbnail>(this);
+
+    const int renumberCount = mRenumberCount;
+
+    connect(watcher, &QFutureWatcher<EncodedThumbnail>::finished, this, [this, watcher, sceneIndex, renumberCount, documentPath](){
+        const EncodedThumbnail thumbnail = watcher->result();
+        watcher->deleteLater();
+
+        // written on the GUI thread, where the pages are renumbered; the thumbnail of a page
+        // which may have moved meanwhile is rendered from its scene when it is displayed
+        if (!thumbnail.first.isNull() && !mDocumentDeleted && renumberCount == mRenumberCount)
+        {
+            UBThumbnailAdaptor::write(documentPath, sceneIndex, thumbnail.second);
+            UBThumbnailService::service()->insert(mDocument, sceneIndex, thumbnail.first);
+        }
+
+        if (--mPendingThumbnails == 0 && mDone)
+            deleteLater();
+    });
+
+    watcher->setFuture(QtConcurrent::run(&mThreadPool, [this, pageIndex](){
+        const QImage thumbnail = renderThumbnail(pageIndex, UBSettings::maxThumbnailWidth);
+        return EncodedThumbnail(thumbnail, thumbnail.isNull() ? QByteArray() : UBThumbnailAdaptor::encode(thumbnail));
+    }));
+}
+
+void UBPageImporter::finish(bool cancelled)
+{
+    mSliceTimer.stop();
+    mDone = true;
+
+    if (!mDocumentDeleted)
+    {
+        UBPersistenceManager::persistenceManager()->persistDocumentMetadata(mDocument);
+
+        // the items were appended during the import, the view is laid out once
+        if (!UBApplication::isClosing && UBApplication::documentController && UBApplication::documentController->selectedDocument() == mDocument)
+            UBApplication::documentController->reloadThumbnails();
+
+        UBApplication::showMessage(cancelled ? tr("Import cancelled.") : tr("Import successful."));
+    }
+
+    emit finished(cancelled);
+
+    if (mPendingThumbnails == 0)
+    {
+        deleteLater();
+    }
+}
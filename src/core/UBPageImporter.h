@@ -0,0 +1,113 @@
+/*
+ * Copyright (C) 2015-2022 Département de l'Instruction Publique (DIP-SEM)
+ *
+ * Copyright (C) 2013 Open Education Foundation
+ *
+ * Copyright (C) 2010-2013 Groupement d'Intérêt Public pour
+ * l'Education Numérique en Afrique (GIP ENA)
+ *
+ * This file is part of OpenBoard.
+ *
+ * OpenBoard is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3 of the License,
+ * with a specific linking exception for the OpenSSL project's
+ * "OpenSSL" library (or with modified versions of it that use the
+ * same license as the "OpenSSL" library).
+ *
+ * OpenBoard is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with OpenBoard. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+
+
+
+
+
+#ifndef UBPAGEIMPORTER_H
+#define UBPAGEIMPORTER_H
+
+#include <QImage>
+#include <QObject>
+#include <QThreadPool>
+#include <QTimer>
+
+#include <memory>
+
+class UBDocumentProxy;
+class UBGraphicsItem;
+class UBGraphicsScene;
+
+/**
+ * Imports the pages of a file one at a time, without blocking the user interface.
+ *
+ * The first page is written at once, so that the document can be opened. The other
+ * pages are appended in short time slices on the GUI thread, their files are written
+ * by the persistence worker. Page thumbnails are rendered from the imported file on a
+ * thread pool instead of from the scenes. A thumbnail rendered while pages of the
+ * document were inserted, removed or moved is dropped, its page may have another index.
+ *
+ * The import stops when it is cancelled, e.g. from the progress dialog, when the
+ * document is deleted or when the application is closed. The importer deletes itself
+ * when it is done.
+ */
+class UBPageImporter : public QObject
+{
+    Q_OBJECT
+
+    public:
+        UBPageImporter(std::shared_ptr<UBDocumentProxy> document, int pageCount, QObject* parent = nullptr);
+        virtual ~UBPageImporter();
+
+        std::shared_ptr<UBDocumentProxy> document() const { return mDocument; }
+        int pageCount() const { return mPageCount; }
+
+        // returns false if there is no page to import
+        bool importFirstPage();
+
+        void start();
+        void cancel();
+
+    signals:
+        void progress(int importedPages, int pageCount);
+        void finished(bool cancelled);
+
+    protected:
+        // called on the GUI thread, the item is placed on a new scene
+        virtual UBGraphicsItem* createPageItem(int pageIndex) = 0;
+        virtual void placePageItem(std::shared_ptr<UBGraphicsScene> scene, UBGraphicsItem* item) = 0;
+
+        // called on a worker thread, a null image lets the thumbnail be rendered from the scene when needed
+        virtual QImage renderThumbnail(int pageIndex, int width) = 0;
+
+        // to be called by the destructor of subclasses, before their data is gone
+        void waitForThumbnails();
+
+    private slots:
+        void importNextPages();
+        void onDocumentWillBeDeleted(std::shared_ptr<UBDocumentProxy> document);
+        void onDocumentInvalidated(std::shared_ptr<UBDocumentProxy> document);
+
+    private:
+        void importPage(int pageIndex, bool immediate);
+        void finish(bool cancelled);
+
+        std::shared_ptr<UBDocumentProxy> mDocument;
+        int mPageCount;
+        int mNextPage;
+        int mPendingThumbnails;
+        int mRenumberCount;
+        bool mCancelled;
+        bool mDone;
+        bool mDocumentDeleted;
+        QTimer mSliceTimer;
+        QThreadPool mThreadPool;
+};
+
+#endif // UBPAGEIMPORTER_H
@@ -38,17 +38,20 @@
 
 #include "frameworks/UBPlatformUtils.h"
 #include "frameworks/UBFileSystemUtils.h"
+#include "frameworks/UBAtomicFileBatch.h"
 
 #include "core/UBApplication.h"
 #include "core/UBSettings.h"
 #include "core/UBSetting.h"
 #include "core/UBForeignObjectsHandler.h"
+#include "core/UBThumbnailService.h"
 
 #include "document/UBDocumentProxy.h"
 
 #include "adaptors/UBExportPDF.h"
 #include "adaptors/UBSvgSubsetAdaptor.h"
 #include "adaptors/UBThumbnailAdaptor.h"
+#include "adaptors/UBThumbnailPack.h"
 #include "adaptors/UBMetadataDcSubsetAdaptor.h"
 
 #include "domain/UBGraphicsMediaItem.h"
@@ -83,7 +86,6 @@ UBPersistenceManager * UBPersistenceManager::sSingleton = 0;
 UBPersistenceManager::UBPersistenceManager(QObject *pParent)
     : QObject(pParent)
     , mHasPurgedDocuments(false)
-    , mIsWorkerFinished(false)
     , mReplaceDialogReturnedReplaceAll(false)
     , mReplaceDialogReturnedCancel(false)
 {
@@ -103,19 +105,15 @@ UBPersistenceManager::UBPersistenceManager(QObject *pParent)
     mDocumentTreeStructureModel = new UBDocumentTreeModel(this);
     createDocumentProxiesStructure();
 
-    mThread = new QThread;
-    mWorker = new UBPersistenceWorker();
-    mWorker->moveToThread(mThread);
+    mPrefetchScheduler = new UBPrefetchScheduler(&mSceneCache, this);
+
+    UBThumbnailPack::setEnabled(UBSettings::settings()->thumbnailPack->get().toBool());
+
+    mWorker = new UBPersistenceWorker(this);
 
     connect(mWorker, SIGNAL(error(QString)), this, SLOT(errorString(QString)));
-    connect(mThread, SIGNAL(started()), mWorker, SLOT(process()));
-    connect(mWorker, SIGNAL(finished()), mThread, SLOT(quit()));
-    connect(mWorker, SIGNAL(finished()), this, SLOT(onWorkerFinished()));
-    connect(mWorker, SIGNAL(finished()), mWorker, SLOT(deleteLater()));
-    connect(mThread, SIGNAL(finished()), mThread, SLOT(deleteLater()));
     connect(mWorker, &UBPersistenceWorker::scenePersisted, this, &UBPersistenceManager::onScenePersisted);
-
-    mThread->start();
+    connect(mWorker, &UBPersistenceWorker::sceneDiscarded, this, &UBPersistenceManager::onScenePersisted);
 }
 
 UBPersistenceManager* UBPersistenceManager::persistenceManager()
@@ -135,11 +133,6 @@ void UBPersistenceManager::destroy()
     sSingleton = NULL;
 }
 
-void UBPersistenceManager::onWorkerFinished()
-{
-    mIsWorkerFinished = true;
-}
-
 void UBPersistenceManager::onScenePersisted(UBGraphicsScene *scene)
 {
     // delete the copy
@@ -150,18 +143,14 @@ UBPersistenceManager::~UBPersistenceManager()
 {
     mIsApplicationClosing = true;
 
-    if(mWorker)
-        mWorker->applicationWillClose();
-
     QElapsedTimer t;
     t.start();
     qDebug() << "start waiting";
 
-    while(!mIsWorkerFinished)
-        QCoreApplication::processEvents(QEventLoop::AllEvents, 100);
-    qDebug() << "stop waiting after " << t.elapsed() << " ms";
-
     // to be sure that all the scenes are stored on disk
+    mWorker->flush();
+
+    qDebug() << "stop waiting after " << t.elapsed() << " ms";
 }
 
 void UBPersistenceManager::errorString(QString error)
@@ -449,6 +438,16 @@ QString UBPersistenceManager::adjustDocumentVirtualPath(const QString &str)
 
 void UBPersistenceManager::closing()
 {
+    QProgressDialog progress(tr("Saving documents..."), QString(), 0, 0);
+    progress.setWindowFlags(Qt::Window | Qt::WindowTitleHint | Qt::CustomizeWindowHint);
+    progress.setWindowModality(Qt::ApplicationModal);
+    progress.setMinimumDuration(500);
+
+    mWorker->flush([&progress](int written, int total) {
+        progress.setMaximum(total);
+        progress.setValue(written);
+    });
+
     QDir rootDir(mDocumentRepositoryPath);
     rootDir.mkpath(rootDir.path());
 
@@ -722,10 +721,18 @@ void UBPersistenceManager::deleteDocument(std::shared_ptr<UBDocumentProxy> pDocu
     qWarning() << "deleting dir with path: " << pDocumentProxy->persistencePath();
     checkIfDocumentRepositoryExists();
 
+    mPrefetchScheduler->cancel();
+
+    emit documentWillBeDeleted(pDocumentProxy);
+
+    // an open pack would keep the directory on Windows
+    UBThumbnailPack::remove(pDocumentProxy->persistencePath());
+
     if (QFileInfo(pDocumentProxy->persistencePath()).exists())
         UBFileSystemUtils::deleteDir(pDocumentProxy->persistencePath());
 
     mSceneCache.removeAllScenes(pDocumentProxy);
+    UBThumbnailService::service()->invalidate(pDocumentProxy);
 }
 
 std::shared_ptr<UBDocumentProxy> UBPersistenceManager::duplicateDocument(std::shared_ptr<UBDocumentProxy> pDocumentProxy)
@@ -769,6 +776,11 @@ void UBPersistenceManager::deleteDocumentScenes(std::shared_ptr<UBDocumentProxy>
 {
     checkIfDocumentRepositoryExists();
 
+    // page files are renamed, stop prefetching the old pages and let the
+    // writes queued under the old page indexes finish first
+    mPrefetchScheduler->cancel();
+    mWorker->flushDocument(proxy);
+
     int pageCount = UBPersistenceManager::persistenceManager()->sceneCount(proxy);
 
     QList<int> compactedIndexes;
@@ -812,6 +824,8 @@ void UBPersistenceManager::deleteDocumentScenes(std::shared_ptr<UBDocumentProxy>
         }
     }
 
+    mWorker->flushDocument(trashDocProxy);
+
     for (int i = 1; i < indexes.size(); i++)
     {
         renamePage(trashDocProxy, i , i - 1);
@@ -851,6 +865,8 @@ void UBPersistenceManager::deleteDocumentScenes(std::shared_ptr<UBDocumentProxy>
 
         }
     }
+
+    UBThumbnailService::service()->invalidate(proxy);
 }
 
 
@@ -858,6 +874,9 @@ void UBPersistenceManager::duplicateDocumentScene(std::shared_ptr<UBDocumentProx
 {
     checkIfDocumentRepositoryExists();
 
+    // pending writes use the page indexes before the renaming
+    mWorker->flushDocument(proxy);
+
     int pageCount = UBPersistenceManager::persistenceManager()->sceneCount(proxy);
 
     for (int i = pageCount; i > index + 1; i--)
@@ -870,6 +889,8 @@ void UBPersistenceManager::duplicateDocumentScene(std::shared_ptr<UBDocumentProx
 
     copyPage(proxy, index , index + 1);
 
+    UBThumbnailService::service()->invalidate(proxy);
+
     //TODO: write a proper way to handle object on disk
     std::shared_ptr<UBGraphicsScene> scene = loadDocumentScene(proxy, index + 1);
 
@@ -978,8 +999,8 @@ void UBPersistenceManager::copyDocumentScene(std::shared_ptr<UBDocumentProxy> fr
     QString thumbTmp(from->persistencePath() + UBFileSystemUtils::digitFileFormat("/page%1.thumbnail.jpg", fromIndex));
     QString thumbTo(to->persistencePath() + UBFileSystemUtils::digitFileFormat("/page%1.thumbnail.jpg", toIndex));
 
-    QFile::remove(thumbTo);
-    QFile::copy(thumbTmp, thumbTo);
+    UBThumbnailService::service()->invalidate(to);
+    copyPageThumbnail(from, fromIndex, to, toIndex);
 
     Q_ASSERT(QFileInfo(thumbTmp).exists());
     Q_ASSERT(QFileInfo(thumbTo).exists());
@@ -992,16 +1013,24 @@ void UBPersistenceManager::copyDocumentScene(std::shared_ptr<UBDocumentProxy> fr
 }
 
 
-std::shared_ptr<UBGraphicsScene> UBPersistenceManager::createDocumentSceneAt(std::shared_ptr<UBDocumentProxy> proxy, int index, bool useUndoRedoStack)
+std::shared_ptr<UBGraphicsScene> UBPersistenceManager::createDocumentSceneAt(std::shared_ptr<UBDocumentProxy> proxy, int index, bool useUndoRedoStack, bool persist)
 {
     int count = proxy->pageCount();
 
-    for(int i = count - 1; i >= index; i--)
+    if (index < count)
     {
-        renamePage(proxy, i , i + 1);
-    }
+        // page files are renamed, stop prefetching the old pages
+        mPrefetchScheduler->cancel();
+        mWorker->flushDocument(proxy);
 
-    mSceneCache.shiftUpScenes(proxy, index, count -1);
+        for(int i = count - 1; i >= index; i--)
+        {
+            renamePage(proxy, i , i + 1);
+        }
+
+        mSceneCache.shiftUpScenes(proxy, index, count -1);
+        UBThumbnailService::service()->invalidate(proxy);
+    }
 
     std::shared_ptr<UBGraphicsScene> newScene = mSceneCache.createScene(proxy, index, useUndoRedoStack);
 
@@ -1012,7 +1041,8 @@ std::shared_ptr<UBGraphicsScene> UBPersistenceManager::createDocumentSceneAt(std
 
     proxy->incPageCount();
 
-    persistDocumentScene(proxy, newScene, index);
+    if (persist)
+        persistDocumentScene(proxy, newScene, index);
 
     emit documentSceneCreated(proxy, index);
 
@@ -1024,6 +1054,10 @@ void UBPersistenceManager::insertDocumentSceneAt(std::shared_ptr<UBDocumentProxy
 {
     scene->setDocument(proxy);
 
+    // page files are renamed, stop prefetching the old pages
+    mPrefetchScheduler->cancel();
+    mWorker->flushDocument(proxy);
+
     int count = sceneCount(proxy);
 
     for(int i = count - 1; i >= index; i--)
@@ -1032,6 +1066,7 @@ void UBPersistenceManager::insertDocumentSceneAt(std::shared_ptr<UBDocumentProxy
     }
 
     mSceneCache.shiftUpScenes(proxy, index, count -1);
+    UBThumbnailService::service()->invalidate(proxy);
 
     mSceneCache.insert(proxy, index, scene);
 
@@ -1047,6 +1082,16 @@ void UBPersistenceManager::insertDocumentSceneAt(std::shared_ptr<UBDocumentProxy
 }
 
 
+void UBPersistenceManager::insertCopiedSceneAt(std::shared_ptr<UBDocumentProxy> proxy, std::shared_ptr<UBGraphicsScene> scene, int index,
+                                               std::shared_ptr<UBDocumentProxy> sourceProxy, int sourceIndex)
+{
+    insertDocumentSceneAt(proxy, scene, index, false);
+    persistDocumentScene(proxy, scene, index, false, false, false);
+
+    copyPageThumbnail(sourceProxy, sourceIndex, proxy, index);
+}
+
+
 void UBPersistenceManager::moveSceneToIndex(std::shared_ptr<UBDocumentProxy> proxy, int source, int target)
 {
     checkIfDocumentRepositoryExists();
@@ -1054,6 +1099,10 @@ void UBPersistenceManager::moveSceneToIndex(std::shared_ptr<UBDocumentProxy> pro
     if (source == target)
         return;
 
+    // page files are renamed, stop prefetching the old pages
+    mPrefetchScheduler->cancel();
+    mWorker->flushDocument(proxy);
+
     QFile svgTmp(proxy->persistencePath() + UBFileSystemUtils::digitFileFormat("/page%1.svg", source));
     svgTmp.rename(proxy->persistencePath() + UBFileSystemUtils::digitFileFormat("/page%1.tmp", target));
 
@@ -1082,6 +1131,7 @@ void UBPersistenceManager::moveSceneToIndex(std::shared_ptr<UBDocumentProxy> pro
     thumb.rename(proxy->persistencePath() + UBFileSystemUtils::digitFileFormat("/page%1.thumbnail.jpg", target));
 
     mSceneCache.moveScene(proxy, source, target);
+    UBThumbnailService::service()->invalidate(proxy);
 }
 
 
@@ -1093,19 +1143,17 @@ std::shared_ptr<UBGraphicsScene> UBPersistenceManager::loadDocumentScene(std::sh
 
     if (cacheNeighboringScenes)
     {
-        if(sceneIndex + 1 < proxy->pageCount() &&  !mSceneCache.contains(proxy, sceneIndex + 1))
-            mSceneCache.prepareLoading(proxy,sceneIndex+1);
-
-        if(sceneIndex + 2 < proxy->pageCount() &&  !mSceneCache.contains(proxy, sceneIndex + 2))
-            mSceneCache.prepareLoading(proxy,sceneIndex+2);
-
-        if(sceneIndex - 1 >= 0 &&  !mSceneCache.contains(proxy, sceneIndex - 1))
-            mSceneCache.prepareLoading(proxy,sceneIndex-1);
+        mPrefetchScheduler->pageChanged(proxy, sceneIndex);
     }
 
     return scene;
 }
 
+void UBPersistenceManager::prefetchHint(std::shared_ptr<UBDocumentProxy> proxy, int sceneIndex)
+{
+    mPrefetchScheduler->hintPage(proxy, sceneIndex);
+}
+
 std::shared_ptr<UBGraphicsScene> UBPersistenceManager::getDocumentScene(std::shared_ptr<UBDocumentProxy> pDocumentProxy, int sceneIndex)
 {
     return mSceneCache.value(pDocumentProxy, sceneIndex);
@@ -1116,7 +1164,12 @@ void UBPersistenceManager::reassignDocProxy(std::shared_ptr<UBDocumentProxy> new
     return mSceneCache.reassignDocProxy(newDocument, oldDocument);
 }
 
-void UBPersistenceManager::persistDocumentScene(std::shared_ptr<UBDocumentProxy> pDocumentProxy, std::shared_ptr<UBGraphicsScene> pScene, const int pSceneIndex, bool isAnAutomaticBackup, bool forceImmediateSaving)
+int UBPersistenceManager::pendingWriteCount()
+{
+    return mWorker->pendingCount();
+}
+
+void UBPersistenceManager::persistDocumentScene(std::shared_ptr<UBDocumentProxy> pDocumentProxy, std::shared_ptr<UBGraphicsScene> pScene, const int pSceneIndex, bool isAnAutomaticBackup, bool forceImmediateSaving, bool renderThumbnail)
 {
     checkIfDocumentRepositoryExists();
 
@@ -1128,20 +1181,32 @@ void UBPersistenceManager::persistDocumentScene(std::shared_ptr<UBDocumentProxy>
     QDir dir(pDocumentProxy->persistencePath());
     dir.mkpath(pDocumentProxy->persistencePath());
 
+    // the thumbnail is rendered now, encoded and flushed to disk together with the page
+    QImage thumbnail = renderThumbnail ? UBThumbnailAdaptor::render(pDocumentProxy, pScene, pSceneIndex) : QImage();
+
+    if (!thumbnail.isNull())
+        UBThumbnailService::service()->insert(pDocumentProxy, pSceneIndex, thumbnail);
+
     if(forceImmediateSaving)
     {
-        UBSvgSubsetAdaptor::persistScene(pDocumentProxy, pScene, pSceneIndex);
+        if (!thumbnail.isNull())
+            UBThumbnailAdaptor::write(pDocumentProxy->persistencePath(), pSceneIndex, thumbnail);
+
+        UBAtomicFileBatch batch;
+        UBSvgSubsetAdaptor::persistScene(pDocumentProxy, pScene, pSceneIndex, &batch);
+        batch.sync(UBThumbnailAdaptor::thumbnailUrl(pDocumentProxy, pSceneIndex).toLocalFile());
+        batch.sync(UBThumbnailPack::fileName(pDocumentProxy->persistencePath()));
+        batch.commit();
     }
     else
     {
-       std::shared_ptr<UBGraphicsScene> copiedScene = pScene->sceneDeepCopy();
-       mWorker->saveScene(pDocumentProxy, copiedScene.get(), pSceneIndex);
+       std::shared_ptr<UBGraphicsScene> copiedScene = pScene->scenePersistenceCopy();
+       mWorker->saveScene(pDocumentProxy, copiedScene.get(), pSceneIndex, thumbnail);
 
        // keep copiedScene alive until saving is finished
        mScenesToSave.append(copiedScene);
     }
 
-    UBThumbnailAdaptor::persistScene(pDocumentProxy, pScene, pSceneIndex);
     pScene->setModified(false);
 
     mSceneCache.insert(pDocumentProxy, pSceneIndex, pScene);
@@ -1190,6 +1255,30 @@ void UBPersistenceManager::copyPage(std::shared_ptr<UBDocumentProxy> pDocumentPr
 }
 
 
+void UBPersistenceManager::copyPageThumbnail(std::shared_ptr<UBDocumentProxy> from, const int fromIndex,
+                                             std::shared_ptr<UBDocumentProxy> to, const int toIndex)
+{
+    // a pending save of either page would write its own thumbnail after the copy
+    if (mWorker->pendingCount() > 0)
+        mWorker->flush();
+
+    QFile thumb(from->persistencePath() + UBFileSystemUtils::digitFileFormat("/page%1.thumbnail.jpg", fromIndex));
+
+    if (thumb.open(QIODevice::ReadOnly))
+    {
+        const QByteArray jpeg = thumb.readAll();
+        thumb.close();
+
+        const QString target = to->persistencePath() + UBFileSystemUtils::digitFileFormat("/page%1.thumbnail.jpg", toIndex);
+
+        if (UBAtomicFileBatch::writeFile(target, jpeg, false))
+            UBThumbnailPack::write(to->persistencePath(), toIndex, jpeg);
+    }
+
+    UBThumbnailService::service()->reload(to, toIndex);
+}
+
+
 int UBPersistenceManager::sceneCount(const std::shared_ptr<UBDocumentProxy> proxy)
 {
     const QString pPath = proxy->persistencePath();
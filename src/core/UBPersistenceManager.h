@@ -33,6 +33,7 @@
 
 #include "UBSceneCache.h"
 #include "UBPersistenceWorker.h"
+#include "UBPrefetchScheduler.h"
 
 class QDomNode;
 class QDomElement;
@@ -104,18 +105,29 @@ class UBPersistenceManager : public QObject
 
         virtual void copyDocumentScene(std::shared_ptr<UBDocumentProxy>from, int fromIndex, std::shared_ptr<UBDocumentProxy>to, int toIndex);
 
-        virtual void persistDocumentScene(std::shared_ptr<UBDocumentProxy> pDocumentProxy, std::shared_ptr<UBGraphicsScene> pScene, const int pSceneIndex, bool isAnAutomaticBackup = false, bool forceImmediateSaving = false);
+        // renderThumbnail is false when the caller provides the thumbnail of the page
+        virtual void persistDocumentScene(std::shared_ptr<UBDocumentProxy> pDocumentProxy, std::shared_ptr<UBGraphicsScene> pScene, const int pSceneIndex, bool isAnAutomaticBackup = false, bool forceImmediateSaving = false, bool renderThumbnail = true);
 
-        virtual std::shared_ptr<UBGraphicsScene> createDocumentSceneAt(std::shared_ptr<UBDocumentProxy> pDocumentProxy, int index, bool useUndoRedoStack = true);
+        // persist is false when the caller fills the scene and persists it afterwards
+        virtual std::shared_ptr<UBGraphicsScene> createDocumentSceneAt(std::shared_ptr<UBDocumentProxy> pDocumentProxy, int index, bool useUndoRedoStack = true, bool persist = true);
 
         virtual void insertDocumentSceneAt(std::shared_ptr<UBDocumentProxy> pDocumentProxy, std::shared_ptr<UBGraphicsScene> scene, int index, bool persist = true, bool deleting = false);
 
+        // inserts a copy of a page of another document and copies its thumbnail, as a
+        // scene that was never shown does not render a correct one
+        virtual void insertCopiedSceneAt(std::shared_ptr<UBDocumentProxy> pDocumentProxy, std::shared_ptr<UBGraphicsScene> scene, int index,
+                                         std::shared_ptr<UBDocumentProxy> sourceProxy, int sourceIndex);
+
         virtual void moveSceneToIndex(std::shared_ptr<UBDocumentProxy> pDocumentProxy, int source, int target);
 
         virtual std::shared_ptr<UBGraphicsScene> loadDocumentScene(std::shared_ptr<UBDocumentProxy> pDocumentProxy, int sceneIndex, bool cacheNeighboringScenes = true);
+        void prefetchHint(std::shared_ptr<UBDocumentProxy> pDocumentProxy, int sceneIndex);
         std::shared_ptr<UBGraphicsScene> getDocumentScene(std::shared_ptr<UBDocumentProxy> pDocumentProxy, int sceneIndex);
         void reassignDocProxy(std::shared_ptr<UBDocumentProxy> newDocument, std::shared_ptr<UBDocumentProxy> oldDocument);
 
+        // scenes and metadata not written yet
+        int pendingWriteCount();
+
 //        QList<QPointer<UBDocumentProxy> > documentProxies;
         UBDocumentTreeNode *mDocumentTreeStructure;
         UBDocumentTreeModel *mDocumentTreeStructureModel;
@@ -163,6 +175,8 @@ class UBPersistenceManager : public QObject
 
         void documentSceneCreated(std::shared_ptr<UBDocumentProxy> pDocumentProxy, int pIndex);
 
+        void documentWillBeDeleted(std::shared_ptr<UBDocumentProxy> pDocumentProxy);
+
 private:
         int sceneCount(const std::shared_ptr<UBDocumentProxy> pDocumentProxy);
         static QStringList getSceneFileNames(const QString& folder);
@@ -170,6 +184,8 @@ private:
                         const int sourceIndex, const int targetIndex);
         void copyPage(std::shared_ptr<UBDocumentProxy> pDocumentProxy,
                       const int sourceIndex, const int targetIndex);
+        void copyPageThumbnail(std::shared_ptr<UBDocumentProxy> from, const int fromIndex,
+                               std::shared_ptr<UBDocumentProxy> to, const int toIndex);
         void generatePathIfNeeded(std::shared_ptr<UBDocumentProxy> pDocumentProxy);
         void checkIfDocumentRepositoryExists();
 
@@ -181,6 +197,7 @@ private:
         QString xmlFolderStructureFilename;
 
         UBSceneCache mSceneCache;
+        UBPrefetchScheduler* mPrefetchScheduler;
         QStringList mDocumentSubDirectories;
         QMutex mDeletedListMutex;
         bool mHasPurgedDocuments;
@@ -191,9 +208,6 @@ private:
         UBPersistenceWorker* mWorker;
         QList<std::shared_ptr<UBGraphicsScene>> mScenesToSave;
 
-        QThread* mThread;
-        bool mIsWorkerFinished;
-
         bool mIsApplicationClosing;
 
         bool mReplaceDialogReturnedReplaceAll;
@@ -202,7 +216,6 @@ private:
     private slots:
         void documentRepositoryChanged(const QString& path);
         void errorString(QString error);
-        void onWorkerFinished();
         void onScenePersisted(UBGraphicsScene* scene);
 };
 
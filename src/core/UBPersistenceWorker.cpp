@@ -25,62 +25,205 @@
  */
 
 
-
 #include "UBPersistenceWorker.h"
+
+#include <QCoreApplication>
+#include <QtConcurrent>
+
 #include "adaptors/UBSvgSubsetAdaptor.h"
 #include "adaptors/UBThumbnailAdaptor.h"
+#include "adaptors/UBThumbnailPack.h"
 #include "adaptors/UBMetadataDcSubsetAdaptor.h"
 
+#include "frameworks/UBAtomicFileBatch.h"
+
+namespace
+{
+    // keep most cores for the user interface while working
+    int backgroundWriterCount()
+    {
+        return qBound(1, QThread::idealThreadCount() / 2, 4);
+    }
+}
+
 UBPersistenceWorker::UBPersistenceWorker(QObject *parent) :
     QObject(parent)
-  , mReceivedApplicationClosing(false)
+  , mRunning(0)
+  , mWritten(0)
 {
+    mThreadPool.setMaxThreadCount(backgroundWriterCount());
 }
 
-void UBPersistenceWorker::saveScene(std::shared_ptr<UBDocumentProxy> proxy, UBGraphicsScene *scene, const int pageIndex)
+UBPersistenceWorker::~UBPersistenceWorker()
 {
-    PersistenceInformation entry = {WriteScene, proxy, scene, pageIndex};
+    flush();
+}
 
-    QMutexLocker locker(&mMutex);
-    saves.append(entry);
-    mSemaphore.release();
+void UBPersistenceWorker::saveScene(std::shared_ptr<UBDocumentProxy> proxy, UBGraphicsScene *scene, const int pageIndex, const QImage& thumbnail)
+{
+    PersistenceInformation entry = {WriteScene, proxy, scene, pageIndex, thumbnail};
+    enqueue(entry);
 }
 
 void UBPersistenceWorker::saveMetadata(std::shared_ptr<UBDocumentProxy> proxy)
 {
-    PersistenceInformation entry = {WriteMetadata, proxy, NULL, 0};
+    PersistenceInformation entry = {WriteMetadata, proxy, NULL, 0, QImage()};
+    enqueue(entry);
+}
+
+int UBPersistenceWorker::pendingCount()
+{
+    QMutexLocker locker(&mMutex);
+    return mPending.size() + mRunning;
+}
+
+void UBPersistenceWorker::flush(std::function<void(int written, int total)> progress)
+{
     QMutexLocker locker(&mMutex);
-    saves.append(entry);
-    mSemaphore.release();
+
+    // nothing else to wait for, use all cores
+    mThreadPool.setMaxThreadCount(QThread::idealThreadCount());
+    dispatch();
+
+    const int writtenBefore = mWritten;
+
+    while (!mPending.isEmpty() || mRunning > 0)
+    {
+        mIdle.wait(&mMutex, 50);
+
+        const int written = mWritten - writtenBefore;
+        const int total = written + mPending.size() + mRunning;
+
+        locker.unlock();
+
+        if (progress)
+            progress(written, total);
+
+        // deliver the persisted signals
+        QCoreApplication::processEvents(QEventLoop::ExcludeUserInputEvents);
+
+        locker.relock();
+    }
+
+    mThreadPool.setMaxThreadCount(backgroundWriterCount());
 }
 
-void UBPersistenceWorker::applicationWillClose()
+void UBPersistenceWorker::flushDocument(std::shared_ptr<UBDocumentProxy> proxy)
 {
-    qDebug() << "application Will close signal received";
-    mReceivedApplicationClosing = true;
-    mSemaphore.release();
+    QMutexLocker locker(&mMutex);
+
+    while (hasPendingWrites(proxy.get()))
+    {
+        mIdle.wait(&mMutex);
+    }
 }
 
-void UBPersistenceWorker::process()
+bool UBPersistenceWorker::hasPendingWrites(UBDocumentProxy* proxy) const
 {
-    qDebug() << "process starts";
-    mSemaphore.acquire();
-    do{
-        PersistenceInformation info;
+    // called with mMutex locked
+    if (mBusyDocuments.contains(proxy))
+        return true;
+
+    for (const PersistenceKey& key : mQueue)
+    {
+        if (key.proxy == proxy)
+            return true;
+    }
+
+    return false;
+}
+
+void UBPersistenceWorker::enqueue(const PersistenceInformation& info)
+{
+    PersistenceKey key = {info.proxy.get(), info.sceneIndex, info.action};
+    PersistenceInformation entry = info;
+    UBGraphicsScene* discardedScene = nullptr;
+
+    {
+        QMutexLocker locker(&mMutex);
+
+        if (mPending.contains(key))
         {
-            QMutexLocker locker(&mMutex);
-            info = saves.takeFirst();
+            // the latest request wins, keeping the place of the first one
+            const PersistenceInformation& discarded = mPending[key];
+            discardedScene = discarded.scene;
+
+            // and the latest thumbnail
+            if (entry.thumbnail.isNull())
+                entry.thumbnail = discarded.thumbnail;
         }
-        if(info.action == WriteScene){
-            UBSvgSubsetAdaptor::persistScene(info.proxy, info.scene->shared_from_this(), info.sceneIndex);
-            emit scenePersisted(info.scene);
+        else if (info.action == WriteMetadata)
+        {
+            // metadata is small and written before all scenes
+            int position = 0;
+
+            while (position < mQueue.size() && mQueue.at(position).action == WriteMetadata)
+                ++position;
+
+            mQueue.insert(position, key);
         }
-        else if (info.action == WriteMetadata) {
-            UBMetadataDcSubsetAdaptor::persist(info.proxy);
-            emit metadataPersisted(info.proxy);
+        else
+        {
+            mQueue.append(key);
         }
-        mSemaphore.acquire();
-    }while(!mReceivedApplicationClosing);
-    qDebug() << "process will stop";
-    emit finished();
+
+        mPending.insert(key, entry);
+        dispatch();
+    }
+
+    if (discardedScene && discardedScene != info.scene)
+        emit sceneDiscarded(discardedScene);
+}
+
+void UBPersistenceWorker::dispatch()
+{
+    // called with mMutex locked
+    for (auto it = mQueue.begin(); it != mQueue.end() && mRunning < mThreadPool.maxThreadCount(); )
+    {
+        if (mBusyDocuments.contains(it->proxy))
+        {
+            ++it;
+            continue;
+        }
+
+        PersistenceInformation info = mPending.take(*it);
+        it = mQueue.erase(it);
+
+        mBusyDocuments.insert(info.proxy.get());
+        ++mRunning;
+
+        QtConcurrent::run(&mThreadPool, [this, info]() {
+            write(info);
+
+            QMutexLocker locker(&mMutex);
+            mBusyDocuments.remove(info.proxy.get());
+            --mRunning;
+            ++mWritten;
+            dispatch();
+            mIdle.wakeAll();
+        });
+    }
+}
+
+void UBPersistenceWorker::write(const PersistenceInformation& info)
+{
+    if(info.action == WriteScene){
+        QString thumbnailFile = UBThumbnailAdaptor::thumbnailUrl(info.proxy, info.sceneIndex).toLocalFile();
+
+        if (!info.thumbnail.isNull())
+            UBThumbnailAdaptor::write(info.proxy->persistencePath(), info.sceneIndex, info.thumbnail);
+
+        // flush the page, its thumbnail and the thumbnail pack to disk at once
+        UBAtomicFileBatch batch;
+        UBSvgSubsetAdaptor::persistScene(info.proxy, info.scene->shared_from_this(), info.sceneIndex, &batch);
+        batch.sync(thumbnailFile);
+        batch.sync(UBThumbnailPack::fileName(info.proxy->persistencePath()));
+        batch.commit();
+
+        emit scenePersisted(info.scene);
+    }
+    else if (info.action == WriteMetadata) {
+        UBMetadataDcSubsetAdaptor::persist(info.proxy);
+        emit metadataPersisted(info.proxy);
+    }
 }
@@ -25,12 +25,19 @@
  */
 
 
-
 #ifndef UBPERSISTENCEWORKER_H
 #define UBPERSISTENCEWORKER_H
 
 #include <QObject>
-#include <QSemaphore>
+#include <QHash>
+#include <QImage>
+#include <QMutex>
+#include <QSet>
+#include <QThreadPool>
+#include <QWaitCondition>
+
+#include <functional>
+
 #include "document/UBDocumentProxy.h"
 #include "domain/UBGraphicsScene.h"
 
@@ -44,32 +51,76 @@ typedef struct{
     std::shared_ptr<UBDocumentProxy> proxy;
     UBGraphicsScene* scene;
     int sceneIndex;
+    QImage thumbnail;
 }PersistenceInformation;
 
+typedef struct{
+    UBDocumentProxy* proxy;
+    int sceneIndex;
+    ActionType action;
+}PersistenceKey;
+
+inline bool operator==(const PersistenceKey& key1, const PersistenceKey& key2)
+{
+    return key1.proxy == key2.proxy && key1.sceneIndex == key2.sceneIndex && key1.action == key2.action;
+}
+
+inline uint qHash(const PersistenceKey& key)
+{
+    uint hash = qHash(key.proxy);
+    hash ^= qHash(key.sceneIndex) + 0x9e3779b9 + (hash << 6) + (hash >> 2);
+    hash ^= qHash(int(key.action)) + 0x9e3779b9 + (hash << 6) + (hash >> 2);
+    return hash;
+}
+
+/**
+ * Writes scenes and metadata on a small thread pool.
+ *
+ * Requests are coalesced by document, page and action, so only the latest request
+ * for a page is written. Metadata is written before scenes. Requests for different
+ * documents are written in parallel, those for the same document one after the other.
+ * Page thumbnails are encoded here too, off the GUI thread.
+ */
 class UBPersistenceWorker : public QObject
 {
     Q_OBJECT
 public:
     explicit UBPersistenceWorker(QObject *parent = 0);
+    virtual ~UBPersistenceWorker();
 
-    void saveScene(std::shared_ptr<UBDocumentProxy> proxy, UBGraphicsScene* scene, const int pageIndex);
+    // the thumbnail is rendered by the caller, it is encoded and written together with the page
+    void saveScene(std::shared_ptr<UBDocumentProxy> proxy, UBGraphicsScene* scene, const int pageIndex, const QImage& thumbnail = QImage());
     void saveMetadata(std::shared_ptr<UBDocumentProxy> proxy);
 
+    int pendingCount();
+
+    // blocks until all requests are written, reporting the progress while processing events
+    void flush(std::function<void(int written, int total)> progress = nullptr);
+
+    // blocks until the requests of the document are written, without processing events,
+    // so that its page files can be renamed
+    void flushDocument(std::shared_ptr<UBDocumentProxy> proxy);
+
 signals:
-   void finished();
    void error(QString string);
    void scenePersisted(UBGraphicsScene* scene);
+   void sceneDiscarded(UBGraphicsScene* scene);
    void metadataPersisted(std::shared_ptr<UBDocumentProxy> proxy);
 
-public slots:
-   void process();
-   void applicationWillClose();
-
 protected:
-   bool mReceivedApplicationClosing;
-   QSemaphore mSemaphore;
+   void enqueue(const PersistenceInformation& info);
+   void dispatch();
+   void write(const PersistenceInformation& info);
+   bool hasPendingWrites(UBDocumentProxy* proxy) const;
+
    QMutex mMutex;
-   QList<PersistenceInformation> saves;
+   QWaitCondition mIdle;
+   QHash<PersistenceKey, PersistenceInformation> mPending;
+   QList<PersistenceKey> mQueue;
+   QSet<UBDocumentProxy*> mBusyDocuments;
+   int mRunning;
+   int mWritten;
+   QThreadPool mThreadPool;
 };
 
 #endif // UBPERSISTENCEWORKER_H
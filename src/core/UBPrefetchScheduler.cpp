@@ -0,0 +1,256 @@
+/*
+ * Copyright (C) 2015-2022 Département de l'Instruction Publique (DIP-SEM)
+ *
+ * Copyright (C) 2013 Open Education Foundation
+ *
+ * Copyright (C) 2010-2013 Groupement d'Intérêt Public pour
+ * l'Education Numérique en Afrique (GIP ENA)
+ *
+ * This file is part of OpenBoard.
+ *
+ * OpenBoard is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3 of the License,
+ * with a specific linking exception for the OpenSSL project's
+ * "OpenSSL" library (or with modified versions of it that use the
+ * same license as the "OpenSSL" library).
+ *
+ * OpenBoard is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with OpenBoard. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+
+
+
+
+#include "UBPrefetchScheduler.h"
+
+#include <algorithm>
+
+#include "core/UBSceneCache.h"
+#include "core/UBSettings.h"
+#include "core/UBSetting.h"
+
+#include "document/UBDocumentProxy.h"
+
+#include "core/memcheck.h"
+
+namespace
+{
+    // pages prefetched at rest, ahead and behind the navigation direction
+    const int sMinPagesAhead = 2;
+    const int sPagesBehind = 1;
+
+    // upper limit of pages prefetched ahead while paging fast
+    const int sMaxPagesAhead = 10;
+
+    // how far in time the prefetch window reaches ahead at the current paging speed
+    const qreal sLookaheadSeconds = 1.5;
+
+    // a pause longer than this resets the paging speed
+    const qint64 sPagingPauseMs = 2000;
+
+    // interval for checking whether the previous prefetch has completed
+    const int sQueueIntervalMs = 20;
+}
+
+UBPrefetchScheduler::UBPrefetchScheduler(UBSceneCache* sceneCache, QObject* parent)
+    : QObject(parent)
+    , mSceneCache(sceneCache)
+    , mCurrentPage(-1)
+    , mDirection(1)
+    , mPagesPerSecond(0)
+    , mHintedPage(-1)
+    , mLoadingPage(-1)
+{
+    mTimer.setInterval(sQueueIntervalMs);
+    connect(&mTimer, &QTimer::timeout, this, &UBPrefetchScheduler::processQueue);
+}
+
+UBPrefetchScheduler::~UBPrefetchScheduler()
+{
+    // NOOP
+}
+
+void UBPrefetchScheduler::pageChanged(std::shared_ptr<UBDocumentProxy> proxy, int pageIndex)
+{
+    if (proxy != mProxy)
+    {
+        cancel();
+        mProxy = proxy;
+        mCurrentPage = pageIndex;
+        mDirection = 1;
+        mPagesPerSecond = 0;
+        mLastPageChange.start();
+        schedule();
+        return;
+    }
+
+    int delta = pageIndex - mCurrentPage;
+
+    if (delta == 0)
+    {
+        return;
+    }
+
+    qint64 elapsed = mLastPageChange.isValid() ? mLastPageChange.restart() : sPagingPauseMs;
+
+    if (elapsed >= sPagingPauseMs)
+    {
+        mPagesPerSecond = 0;
+    }
+    else
+    {
+        // smooth the speed over the last few page changes
+        qreal pagesPerSecond = qAbs(delta) * 1000. / qMax<qint64>(elapsed, 1);
+        mPagesPerSecond = (mPagesPerSecond + pagesPerSecond) / 2.;
+    }
+
+    mDirection = delta > 0 ? 1 : -1;
+    mCurrentPage = pageIndex;
+
+    schedule();
+}
+
+void UBPrefetchScheduler::hintPage(std::shared_ptr<UBDocumentProxy> proxy, int pageIndex)
+{
+    if (proxy != mProxy || pageIndex == mHintedPage)
+    {
+        return;
+    }
+
+    if (mHintedPage >= 0)
+    {
+        // scrolling through the thumbnails also tells where the user is heading
+        mDirection = pageIndex > mHintedPage ? 1 : -1;
+    }
+
+    mHintedPage = pageIndex;
+
+    schedule();
+}
+
+void UBPrefetchScheduler::cancel()
+{
+    mTimer.stop();
+    mQueue.clear();
+
+    if (mProxy && mLoadingPage >= 0)
+    {
+        mSceneCache->cancelLoading(mProxy, mLoadingPage);
+    }
+
+    mLoadingPage = -1;
+    mHintedPage = -1;
+}
+
+void UBPrefetchScheduler::processQueue()
+{
+    if (mLoadingPage >= 0 && mSceneCache->isLoading(mProxy, mLoadingPage))
+    {
+        // load one page after the other, so that only one scene is attached at a time
+        return;
+    }
+
+    mLoadingPage = -1;
+
+    while (!mQueue.isEmpty())
+    {
+        int pageIndex = mQueue.takeFirst();
+
+        if (pageIndex < 0 || pageIndex >= mProxy->pageCount() || mSceneCache->contains(mProxy, pageIndex))
+        {
+            continue;
+        }
+
+        mSceneCache->prepareLoading(mProxy, pageIndex);
+        mLoadingPage = pageIndex;
+        return;
+    }
+
+    mTimer.stop();
+}
+
+void UBPrefetchScheduler::schedule()
+{
+    if (!mProxy)
+    {
+        return;
+    }
+
+    int pagesAhead = sMinPagesAhead + qRound(mPagesPerSecond * sLookaheadSeconds);
+    pagesAhead = qMin(pagesAhead, sMaxPagesAhead);
+
+    int pagesBehind = sPagesBehind;
+    int affordable = affordablePrefetchCount(pagesAhead + pagesBehind + (mHintedPage >= 0 ? 1 : 0));
+
+    QList<int> queue;
+
+    // the thumbnail under the cursor is most likely to be shown next
+    if (mHintedPage >= 0 && mHintedPage != mCurrentPage)
+    {
+        queue << mHintedPage;
+    }
+
+    for (int i = 1; i <= pagesAhead; ++i)
+    {
+        queue << mCurrentPage + i * mDirection;
+
+        // interleave the page behind after the next page
+        if (i == 1 && pagesBehind > 0)
+        {
+            queue << mCurrentPage - mDirection;
+        }
+    }
+
+    queue.erase(std::remove_if(queue.begin(), queue.end(), [this](int pageIndex){
+        return pageIndex < 0 || pageIndex >= mProxy->pageCount();
+    }), queue.end());
+
+    while (queue.size() > affordable)
+    {
+        queue.removeLast();
+    }
+
+    // cancel a pending prefetch which is no longer wanted
+    if (mLoadingPage >= 0 && !queue.contains(mLoadingPage))
+    {
+        mSceneCache->cancelLoading(mProxy, mLoadingPage);
+        mLoadingPage = -1;
+    }
+
+    mQueue = queue;
+
+    if (!mQueue.isEmpty() && !mTimer.isActive())
+    {
+        processQueue();
+        mTimer.start();
+    }
+}
+
+int UBPrefetchScheduler::affordablePrefetchCount(int wanted) const
+{
+    // keep one cache slot for the current page
+    const int maxEntries = UBSettings::settings()->pageCacheSize->get().toInt() - 1;
+    int affordable = qMin(wanted, maxEntries);
+
+    // estimate the memory of the prefetched pages from the average page in the cache
+    const UBSceneCache::Statistics stats = mSceneCache->statistics();
+    const qint64 budget = UBSettings::settings()->pageCacheMemoryBudget->get().toLongLong() * 1024 * 1024;
+
+    if (stats.entries > 0 && stats.estimatedBytes > 0)
+    {
+        const qint64 averagePageSize = stats.estimatedBytes / stats.entries;
+        const qint64 available = budget - stats.estimatedBytes;
+
+        affordable = qMin<qint64>(affordable, qMax<qint64>(available / averagePageSize, 1));
+    }
+
+    return qMax(affordable, 0);
+}
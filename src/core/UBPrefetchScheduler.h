@@ -0,0 +1,84 @@
+/*
+ * Copyright (C) 2015-2022 Département de l'Instruction Publique (DIP-SEM)
+ *
+ * Copyright (C) 2013 Open Education Foundation
+ *
+ * Copyright (C) 2010-2013 Groupement d'Intérêt Public pour
+ * l'Education Numérique en Afrique (GIP ENA)
+ *
+ * This file is part of OpenBoard.
+ *
+ * OpenBoard is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3 of the License,
+ * with a specific linking exception for the OpenSSL project's
+ * "OpenSSL" library (or with modified versions of it that use the
+ * same license as the "OpenSSL" library).
+ *
+ * OpenBoard is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with OpenBoard. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+
+
+
+
+#ifndef UBPREFETCHSCHEDULER_H
+#define UBPREFETCHSCHEDULER_H
+
+#include <QObject>
+#include <QElapsedTimer>
+#include <QTimer>
+
+#include <memory>
+
+class UBDocumentProxy;
+class UBSceneCache;
+
+/**
+ * Prefetches pages around the current page of the board into the scene cache.
+ *
+ * The prefetch window follows the navigation direction and grows with the paging
+ * speed. Pages are loaded one after the other, a page hinted by the thumbnail view
+ * first. Pending prefetches outside of a new window are cancelled.
+ */
+class UBPrefetchScheduler : public QObject
+{
+    Q_OBJECT
+
+    public:
+        UBPrefetchScheduler(UBSceneCache* sceneCache, QObject* parent = nullptr);
+        virtual ~UBPrefetchScheduler();
+
+        void pageChanged(std::shared_ptr<UBDocumentProxy> proxy, int pageIndex);
+        void hintPage(std::shared_ptr<UBDocumentProxy> proxy, int pageIndex);
+        void cancel();
+
+    private slots:
+        void processQueue();
+
+    private:
+        void schedule();
+        int affordablePrefetchCount(int wanted) const;
+
+        UBSceneCache* mSceneCache;
+        std::shared_ptr<UBDocumentProxy> mProxy;
+
+        int mCurrentPage;
+        int mDirection;
+        qreal mPagesPerSecond;
+        QElapsedTimer mLastPageChange;
+
+        int mHintedPage;
+        int mLoadingPage;
+        QList<int> mQueue;
+        QTimer mTimer;
+};
+
+#endif // UBPREFETCHSCHEDULER_H
@@ -28,6 +28,8 @@
 
 #include "UBSceneCache.h"
 
+#include <QtConcurrent>
+
 #include "domain/UBGraphicsScene.h"
 
 #include <adaptors/UBSvgSubsetAdaptor.h>
@@ -38,8 +40,16 @@
 
 #include "document/UBDocumentProxy.h"
 
+#include "domain/UBGraphicsPixmapItem.h"
+#include "domain/UBGraphicsPolygonItem.h"
+#include "domain/UBGraphicsStrokeItem.h"
+#include "domain/UBGraphicsPDFItem.h"
+
 #include "core/memcheck.h"
 
+// maximum time in ms spent attaching items of a prefetched scene per event loop iteration
+static const qint64 sAttachTimeSliceMs = 5;
+
 UBSceneCache::UBSceneCache()
 {
     // NOOP
@@ -70,7 +80,7 @@ std::shared_ptr<UBGraphicsScene> UBSceneCache::prepareLoading(std::shared_ptr<UB
 
     // no entry in cache; create a cache entry to load scene
     qDebug() << "Preparing to load scene" << pageIndex;
-    auto cacheEntry = std::make_shared<SceneCacheEntry>(proxy, pageIndex);
+    auto cacheEntry = std::make_shared<SceneCacheEntry>(this, proxy, pageIndex);
 
     insertEntry({proxy, pageIndex}, cacheEntry);
     cacheEntry->startLoading();
@@ -81,21 +91,33 @@ std::shared_ptr<UBGraphicsScene> UBSceneCache::prepareLoading(std::shared_ptr<UB
 void UBSceneCache::insert (std::shared_ptr<UBDocumentProxy> proxy, int pageIndex, std::shared_ptr<UBGraphicsScene> scene)
 {
     // remove all entries pointing to this scene
-    const auto keylist = mSceneCache.keys();
+    QList<std::shared_ptr<UBDocumentProxy>> documents{proxy};
 
-    for (const auto& key : keylist)
+    if (scene->document() && scene->document() != proxy)
     {
-        auto entry = mSceneCache.value(key);
+        documents << scene->document();
+    }
+
+    for (const auto& document : documents)
+    {
+        const auto pages = cachedPages(document.get());
 
-        if (entry->isSceneAvailable() && entry->scene() == scene)
+        for (int page : pages)
         {
-            mSceneCache.remove(key);
-            mCachedKeyFIFO.removeAll(key);
+            UBSceneCacheID key{document, page};
+            auto entry = mSceneCache.value(key);
+
+            if (entry->isSceneAvailable() && entry->scene() == scene)
+            {
+                takeEntry(key);
+            }
         }
     }
 
     UBSceneCacheID key{proxy, pageIndex};
-    insertEntry(key, std::make_shared<SceneCacheEntry>(scene));
+    auto entry = std::make_shared<SceneCacheEntry>(this, scene);
+    entry->setEstimatedSize(estimatedSceneSize(scene.get()));
+    insertEntry(key, entry);
 
     // restore view state
     if (mViewStates.contains(key))
@@ -111,6 +133,22 @@ bool UBSceneCache::contains(std::shared_ptr<UBDocumentProxy> proxy, int pageInde
 }
 
 
+bool UBSceneCache::isLoading(std::shared_ptr<UBDocumentProxy> proxy, int pageIndex) const
+{
+    auto entry = mSceneCache.value({proxy, pageIndex});
+    return entry && !entry->isSceneAvailable();
+}
+
+
+void UBSceneCache::cancelLoading(std::shared_ptr<UBDocumentProxy> proxy, int pageIndex)
+{
+    if (isLoading(proxy, pageIndex))
+    {
+        takeEntry({proxy, pageIndex});
+    }
+}
+
+
 std::shared_ptr<UBGraphicsScene> UBSceneCache::value(std::shared_ptr<UBDocumentProxy> proxy, int pageIndex)
 {
     UBSceneCacheID key{proxy, pageIndex};
@@ -119,13 +157,22 @@ std::shared_ptr<UBGraphicsScene> UBSceneCache::value(std::shared_ptr<UBDocumentP
     {
         auto entry = mSceneCache.value(key);
 
-        mCachedKeyFIFO.removeAll(key);
-        mCachedKeyFIFO.enqueue(key);
+        if (entry->isSceneAvailable())
+        {
+            ++mHits;
+        }
+        else
+        {
+            ++mMisses;
+        }
+
+        touch(key);
 
         return entry->scene();
     }
     else
     {
+        ++mMisses;
         return nullptr;
     }
 }
@@ -144,8 +191,7 @@ void UBSceneCache::removeScene(std::shared_ptr<UBDocumentProxy> proxy, int pageI
 
     if (!entry->isSceneAvailable() || !entry->scene()->isActive())
     {
-        int count = mSceneCache.remove(key);
-        mCachedKeyFIFO.removeAll(key);
+        takeEntry(key);
 
         if (entry->isSceneAvailable())
         {
@@ -157,9 +203,11 @@ void UBSceneCache::removeScene(std::shared_ptr<UBDocumentProxy> proxy, int pageI
 
 void UBSceneCache::removeAllScenes(std::shared_ptr<UBDocumentProxy> proxy)
 {
-    for(int i = 0 ; i < proxy->pageCount(); i++)
+    const auto pages = cachedPages(proxy.get());
+
+    for (int page : pages)
     {
-        removeScene(proxy, i);
+        removeScene(proxy, page);
     }
 }
 
@@ -168,14 +216,7 @@ void UBSceneCache::moveScene(std::shared_ptr<UBDocumentProxy> proxy, int sourceI
 {
     UBSceneCacheID keySource(proxy, sourceIndex);
 
-    std::shared_ptr<SceneCacheEntry> entry;
-    bool hasEntry = mSceneCache.contains(keySource);
-
-    if (hasEntry)
-    {
-        entry = mSceneCache.value(keySource);
-        mCachedKeyFIFO.removeAll(keySource);
-    }
+    std::shared_ptr<SceneCacheEntry> entry = takeMovableEntry(keySource);
 
     if (sourceIndex < targetIndex)
     {
@@ -194,15 +235,13 @@ void UBSceneCache::moveScene(std::shared_ptr<UBDocumentProxy> proxy, int sourceI
 
     UBSceneCacheID keyTarget(proxy, targetIndex);
 
-    if (hasEntry)
+    if (entry)
     {
         insertEntry(keyTarget, entry);
-        mCachedKeyFIFO.enqueue(keyTarget);
     }
-    else if (mSceneCache.contains(keyTarget))
+    else
     {
-        entry = mSceneCache.take(keyTarget);
-        mCachedKeyFIFO.removeAll(keyTarget);
+        takeEntry(keyTarget);
     }
 
 }
@@ -218,133 +257,366 @@ void UBSceneCache::reassignDocProxy(std::shared_ptr<UBDocumentProxy> newDocument
     if (!QFileInfo(oldDocument->persistencePath()).exists()) {
         return;
     }
-    for (int i = 0; i < oldDocument->pageCount(); i++) {
+    const auto pages = cachedPages(oldDocument.get());
+
+    for (int page : pages) {
 
-        UBSceneCacheID sourceKey(oldDocument, i);
-        auto entry = mSceneCache.value(sourceKey);
+        UBSceneCacheID sourceKey(oldDocument, page);
+        auto entry = takeMovableEntry(sourceKey);
+
+        if (!entry)
+        {
+            continue;
+        }
 
         if (entry->isSceneAvailable())
         {
             entry->scene()->setDocument(newDocument);
         }
 
-        mCachedKeyFIFO.removeAll(sourceKey);
-        int count = mSceneCache.remove(sourceKey);
-
-        insertEntry({newDocument, i}, entry);
+        putEntry({newDocument, page}, entry);
     }
 }
 
 
 void UBSceneCache::shiftUpScenes(std::shared_ptr<UBDocumentProxy> proxy, int startIncIndex, int endIncIndex)
 {
-    for(int i = endIncIndex; i >= startIncIndex; i--)
+    // only visit the cached pages of this document, highest index first
+    QList<int> pages = cachedPages(proxy.get());
+    std::sort(pages.begin(), pages.end(), std::greater<int>());
+
+    for (int page : pages)
     {
-        UBApplication::showMessage(QObject::tr("Moving cached scenes (%1/%2)").arg(i).arg(endIncIndex));
-        internalMoveScene(proxy, i, i + 1);
+        if (page > endIncIndex + 1 || page < startIncIndex)
+        {
+            continue;
+        }
+
+        auto entry = takeMovableEntry({proxy, page});
+
+        if (entry && page <= endIncIndex)
+        {
+            UBApplication::showMessage(QObject::tr("Moving cached scenes (%1/%2)").arg(page).arg(endIncIndex));
+            putEntry({proxy, page + 1}, entry);
+        }
     }
 }
 
 
+qint64 UBSceneCache::loadLatency(std::shared_ptr<UBDocumentProxy> proxy, int pageIndex) const
+{
+    auto entry = mSceneCache.value({proxy, pageIndex});
+    return entry ? entry->loadLatency() : -1;
+}
+
+
+qint64 UBSceneCache::blockingTime(std::shared_ptr<UBDocumentProxy> proxy, int pageIndex) const
+{
+    auto entry = mSceneCache.value({proxy, pageIndex});
+    return entry ? entry->blockingTime() : 0;
+}
+
+
+UBSceneCache::Statistics UBSceneCache::statistics() const
+{
+    Statistics stats;
+    stats.entries = mSceneCache.size();
+    stats.estimatedBytes = mEstimatedBytes;
+    stats.hits = mHits;
+    stats.misses = mMisses;
+    stats.evictions = mEvictions;
+
+    return stats;
+}
+
+
+QList<int> UBSceneCache::cachedPages(UBDocumentProxy* proxy) const
+{
+    return mDocumentPartitions.value(proxy).values();
+}
+
+
 void UBSceneCache::internalMoveScene(std::shared_ptr<UBDocumentProxy> proxy, int sourceIndex, int targetIndex)
 {
     UBSceneCacheID sourceKey(proxy, sourceIndex);
+    UBSceneCacheID targetKey(proxy, targetIndex);
+
+    auto entry = takeMovableEntry(sourceKey);
 
-    if (mSceneCache.contains(sourceKey))
+    if (entry)
     {
-        auto scene = mSceneCache.take(sourceKey);
-        mCachedKeyFIFO.removeAll(sourceKey);
+        takeEntry(targetKey);
+        putEntry(targetKey, entry);
+    }
+    else
+    {
+        takeEntry(targetKey);
+    }
+}
+
+void UBSceneCache::insertEntry(UBSceneCacheID key, std::shared_ptr<SceneCacheEntry> entry)
+{
+    putEntry(key, entry);
+    evict(key);
+}
+
+void UBSceneCache::putEntry(const UBSceneCacheID& key, std::shared_ptr<SceneCacheEntry> entry)
+{
+    takeEntry(key);
+
+    mSceneCache.insert(key, entry);
+    mDocumentPartitions[key.documentProxy.get()].insert(key.pageIndex);
+    entry->setCached(true);
+    mEstimatedBytes += entry->estimatedSize();
+
+    touch(key);
+}
 
-        UBSceneCacheID targetKey(proxy, targetIndex);
-        mSceneCache.insert(targetKey, scene);
-        mCachedKeyFIFO.enqueue(targetKey);
+std::shared_ptr<UBSceneCache::SceneCacheEntry> UBSceneCache::takeEntry(const UBSceneCacheID& key)
+{
+    auto entry = mSceneCache.take(key);
+
+    if (entry)
+    {
+        entry->setCached(false);
+        mEstimatedBytes -= entry->estimatedSize();
+
+        auto partition = mDocumentPartitions.find(key.documentProxy.get());
 
+        if (partition != mDocumentPartitions.end())
+        {
+            partition->remove(key.pageIndex);
+
+            if (partition->isEmpty())
+            {
+                mDocumentPartitions.erase(partition);
+            }
+        }
+    }
+
+    auto position = mLruPositions.find(key);
+
+    if (position != mLruPositions.end())
+    {
+        mLruKeys.erase(position.value());
+        mLruPositions.erase(position);
+    }
+
+    return entry;
+}
+
+std::shared_ptr<UBSceneCache::SceneCacheEntry> UBSceneCache::takeMovableEntry(const UBSceneCacheID& key)
+{
+    auto entry = takeEntry(key);
+
+    // page files are renamed when scenes move, a pending load might read the wrong file
+    if (entry && !entry->isSceneAvailable())
+    {
+        return nullptr;
+    }
+
+    return entry;
+}
+
+void UBSceneCache::touch(const UBSceneCacheID& key)
+{
+    auto position = mLruPositions.find(key);
+
+    if (position != mLruPositions.end())
+    {
+        // move to the most recently used end without reallocating
+        mLruKeys.splice(mLruKeys.end(), mLruKeys, position.value());
     }
     else
     {
-        UBSceneCacheID targetKey(proxy, targetIndex);
-        if (mSceneCache.contains(targetKey))
+        mLruPositions.insert(key, mLruKeys.insert(mLruKeys.end(), key));
+    }
+}
+
+void UBSceneCache::updateEstimatedSize(SceneCacheEntry* entry)
+{
+    if (!entry->isSceneAvailable())
+    {
+        return;
+    }
+
+    const qint64 size = estimatedSceneSize(entry->scene().get());
+
+    if (entry->isCached())
+    {
+        mEstimatedBytes += size - entry->estimatedSize();
+    }
+
+    entry->setEstimatedSize(size);
+}
+
+bool UBSceneCache::isEvictable(const UBSceneCacheID& key, const std::shared_ptr<SceneCacheEntry>& entry) const
+{
+    Q_UNUSED(key);
+
+    if (!entry->isSceneAvailable())
+    {
+        // still loading, nothing lost
+        return true;
+    }
+
+    auto scene = entry->scene();
+
+    // never evict the active scene or a scene shown in the control or display view
+    return !scene->isActive() && scene->views().isEmpty();
+}
+
+void UBSceneCache::evict(const UBSceneCacheID& protectedKey)
+{
+    const int maxEntries = UBSettings::settings()->pageCacheSize->get().toInt();
+    const qint64 maxBytes = UBSettings::settings()->pageCacheMemoryBudget->get().toLongLong() * 1024 * 1024;
+
+    // an edited scene is estimated again when it is persisted, which re-inserts it,
+    // so eviction never walks the other entries
+    auto it = mLruKeys.begin();
+
+    while (it != mLruKeys.end() && (mSceneCache.size() > maxEntries || mEstimatedBytes > maxBytes))
+    {
+        const UBSceneCacheID key = *it;
+        ++it;
+
+        if (key == protectedKey)
+        {
+            continue;
+        }
+
+        auto entry = mSceneCache.value(key);
+
+        if (!entry || !isEvictable(key, entry))
         {
-            mSceneCache.take(targetKey);
+            continue;
+        }
 
-            mCachedKeyFIFO.removeAll(targetKey);
+        qDebug() << "cache full, removing page" << key.pageIndex << "of" << key.documentProxy->documentFolderName()
+                 << "estimated size" << entry->estimatedSize() / 1024 << "kB";
+
+        if (entry->isSceneAvailable())
+        {
+            mViewStates.insert(key, entry->scene()->viewState());
         }
+
+        takeEntry(key);
+        ++mEvictions;
     }
 }
 
-void UBSceneCache::insertEntry(UBSceneCacheID key, std::shared_ptr<SceneCacheEntry> entry)
+qint64 UBSceneCache::estimatedSceneSize(UBGraphicsScene* scene)
 {
-    mSceneCache.insert(key, entry);
-    mCachedKeyFIFO.removeAll(key);
-    mCachedKeyFIFO.enqueue(key);
+    // rough estimate of the memory held by the items of a scene
+    static const qint64 itemOverhead = 256;
+
+    if (!scene)
+    {
+        return 0;
+    }
 
-    // remove LRU entries if cache size grows beyond limit
-    auto entries = mCachedKeyFIFO.size();
+    qint64 size = 0;
+    const auto items = scene->items();
 
-    while (entries-- > UBSettings::settings()->pageCacheSize->get().toInt())
+    for (const QGraphicsItem* item : items)
     {
-        qDebug() << "cache full, size" << entries;
-        const auto key = mCachedKeyFIFO.dequeue();
-        auto entry = mSceneCache.value(key);
+        size += itemOverhead;
+
+        switch (item->type())
+        {
+        case UBGraphicsPixmapItem::Type:
+        {
+            const QPixmap pixmap = static_cast<const UBGraphicsPixmapItem*>(item)->pixmap();
+            size += qint64(pixmap.width()) * pixmap.height() * pixmap.depth() / 8;
+            break;
+        }
 
-        // remove if still loading or inactive
-        if ((entry->isSceneAvailable() && !entry->scene()->isActive())
-                || !entry->isSceneAvailable())
+        case UBGraphicsPDFItem::Type:
         {
-            qDebug() << "removing page" << key.pageIndex << "of" << key.documentProxy->documentFolderName();
-            removeScene(key.documentProxy, key.pageIndex);
-            entry = nullptr;
-            qDebug() << "removed page" << key.pageIndex << "of" << key.documentProxy->documentFolderName();
+            // page rendered by the splash output device, RGB8
+            const QSizeF pageSize = item->boundingRect().size() * item->scale();
+            size += qint64(pageSize.width() * pageSize.height()) * 3;
+            break;
+        }
+
+        case UBGraphicsPolygonItem::Type:
+        {
+            // do not tessellate stroke items only to weigh them, their outline has about twice their points
+            const UBGraphicsStrokeItem* strokeItem = dynamic_cast<const UBGraphicsStrokeItem*>(item);
+
+            if (strokeItem && strokeItem->hasCentreline())
+                size += strokeItem->centreline().size() * qint64(sizeof(QPair<QPointF, qreal>) + 2 * sizeof(QPointF));
+            else
+                size += static_cast<const UBGraphicsPolygonItem*>(item)->polygon().size() * qint64(sizeof(QPointF));
+
+            break;
+        }
+
+        default:
             break;
         }
     }
+
+    return size;
 }
 
-UBSceneCache::SceneCacheEntry::SceneCacheEntry(std::shared_ptr<UBDocumentProxy> proxy, int pageIndex)
+UBSceneCache::SceneCacheEntry::SceneCacheEntry(UBSceneCache* cache, std::shared_ptr<UBDocumentProxy> proxy, int pageIndex)
+    : mCache(cache)
+    , mProxy(proxy)
+    , mPageIndex(pageIndex)
 {
-    mContext = UBSvgSubsetAdaptor::prepareLoadingScene(proxy, pageIndex);
+    mLoadTimer.start();
+
+    if (!UBSettings::settings()->pageLoadInBackground->get().toBool())
+    {
+        mContext = UBSvgSubsetAdaptor::prepareLoadingScene(proxy, pageIndex);
+    }
 }
 
-UBSceneCache::SceneCacheEntry::SceneCacheEntry(std::shared_ptr<UBGraphicsScene> scene)
+UBSceneCache::SceneCacheEntry::SceneCacheEntry(UBSceneCache* cache, std::shared_ptr<UBGraphicsScene> scene)
+    : mCache(cache)
 {
     mScene = scene;
 }
 
 UBSceneCache::SceneCacheEntry::~SceneCacheEntry()
 {
-    if (mTimer)
+    stopTimer();
+
+    if (mPreloadWatcher)
     {
-        delete mTimer;
+        // the worker just finishes its job, the result is discarded
+        mPreloadWatcher->disconnect();
+        delete mPreloadWatcher;
     }
 }
 
 void UBSceneCache::SceneCacheEntry::startLoading()
 {
-    mTimer = new QTimer;
-    QObject::connect(mTimer, &QTimer::timeout, mTimer, [this](){
-        if (UBApplication::isClosing)
+    if (mContext)
+    {
+        startAttaching();
+        return;
+    }
+
+    // read and parse the file and decode images on the thread pool, then attach items on the GUI thread
+    const QString documentPath = mProxy->persistencePath();
+    const int pageIndex = mPageIndex;
+
+    mPreloadWatcher = new QFutureWatcher<UBSvgSubsetAdaptor::UBSvgPreloadedData>;
+    QObject::connect(mPreloadWatcher, &QFutureWatcher<UBSvgSubsetAdaptor::UBSvgPreloadedData>::finished, mPreloadWatcher, [this](){
+        if (UBApplication::isClosing || mContext || mScene)
         {
-            mTimer->stop();
-            delete mTimer;
             return;
         }
 
-        if (mContext)
-        {
-            mContext->step();
-
-            if (mContext->isFinished())
-            {
-                mScene = mContext->scene();
-                mContext = nullptr;
-                mTimer->stop();
-                delete mTimer;
-                mTimer = nullptr;
-            }
-        }
+        mContext = std::make_shared<UBSvgSubsetAdaptor::UBSvgReaderContext>(mProxy, mPreloadWatcher->result());
+        startAttaching();
     });
 
-    mTimer->start();
+    mPreloadWatcher->setFuture(QtConcurrent::run([documentPath, pageIndex](){
+        return UBSvgSubsetAdaptor::preloadScene(documentPath, pageIndex);
+    }));
 }
 
 bool UBSceneCache::SceneCacheEntry::isSceneAvailable() const
@@ -354,14 +626,18 @@ bool UBSceneCache::SceneCacheEntry::isSceneAvailable() const
 
 std::shared_ptr<UBGraphicsScene> UBSceneCache::SceneCacheEntry::scene()
 {
-    if (mContext && !mScene)
+    if (!mScene && (mContext || mPreloadWatcher))
     {
-        // finish loading
-        if (mTimer)
+        // scene is needed now, finish loading synchronously
+        QElapsedTimer blockingTimer;
+        blockingTimer.start();
+
+        stopTimer();
+
+        if (!mContext)
         {
-            mTimer->stop();
-            delete mTimer;
-            mTimer = nullptr;
+            mPreloadWatcher->waitForFinished();
+            mContext = std::make_shared<UBSvgSubsetAdaptor::UBSvgReaderContext>(mProxy, mPreloadWatcher->result());
         }
 
         while (!mContext->isFinished())
@@ -369,9 +645,92 @@ std::shared_ptr<UBGraphicsScene> UBSceneCache::SceneCacheEntry::scene()
             mContext->step();
         }
 
-        mScene = mContext->scene();
-        mContext = nullptr;
+        mBlockingTime += blockingTimer.elapsed();
+        finishLoading();
     }
 
     return mScene;
 }
+
+qint64 UBSceneCache::SceneCacheEntry::loadLatency() const
+{
+    return mLoadLatency;
+}
+
+qint64 UBSceneCache::SceneCacheEntry::blockingTime() const
+{
+    return mBlockingTime;
+}
+
+qint64 UBSceneCache::SceneCacheEntry::estimatedSize() const
+{
+    return mEstimatedSize;
+}
+
+void UBSceneCache::SceneCacheEntry::setEstimatedSize(qint64 size)
+{
+    mEstimatedSize = size;
+}
+
+bool UBSceneCache::SceneCacheEntry::isCached() const
+{
+    return mCached;
+}
+
+void UBSceneCache::SceneCacheEntry::setCached(bool cached)
+{
+    mCached = cached;
+}
+
+void UBSceneCache::SceneCacheEntry::startAttaching()
+{
+    mTimer = new QTimer;
+    QObject::connect(mTimer, &QTimer::timeout, mTimer, [this](){
+        if (UBApplication::isClosing)
+        {
+            stopTimer();
+            return;
+        }
+
+        if (mContext)
+        {
+            // attach items in bounded time slices to keep the GUI responsive
+            QElapsedTimer sliceTimer;
+            sliceTimer.start();
+
+            while (!mContext->isFinished() && sliceTimer.elapsed() < sAttachTimeSliceMs)
+            {
+                mContext->step();
+            }
+
+            mBlockingTime += sliceTimer.elapsed();
+
+            if (mContext->isFinished())
+            {
+                stopTimer();
+                finishLoading();
+            }
+        }
+    });
+
+    mTimer->start();
+}
+
+void UBSceneCache::SceneCacheEntry::stopTimer()
+{
+    if (mTimer)
+    {
+        mTimer->stop();
+        mTimer->deleteLater();
+        mTimer = nullptr;
+    }
+}
+
+void UBSceneCache::SceneCacheEntry::finishLoading()
+{
+    mScene = mContext->scene();
+    mContext = nullptr;
+    mLoadLatency = mLoadTimer.elapsed();
+
+    mCache->updateEstimatedSize(this);
+}
@@ -31,7 +31,9 @@
 #define UBSCENECACHE_H
 
 #include <QtCore>
+#include <QFutureWatcher>
 
+#include <list>
 #include <variant>
 
 #include "adaptors/UBSvgSubsetAdaptor.h"
@@ -70,13 +72,26 @@ inline bool operator==(const UBSceneCacheID &id1, const UBSceneCacheID &id2)
 
 inline uint qHash(const UBSceneCacheID &id)
 {
-    return qHash(id.pageIndex);
+    // combine document identity and page index, so that the same page of
+    // different documents does not land in the same bucket
+    uint hash = qHash(id.documentProxy.get());
+    hash ^= qHash(id.pageIndex) + 0x9e3779b9 + (hash << 6) + (hash >> 2);
+    return hash;
 }
 
 
 class UBSceneCache
 {
 public:
+    struct Statistics
+    {
+        int entries = 0;
+        qint64 estimatedBytes = 0;
+        quint64 hits = 0;
+        quint64 misses = 0;
+        quint64 evictions = 0;
+    };
+
     UBSceneCache();
     virtual ~UBSceneCache();
 
@@ -88,6 +103,10 @@ public:
 
     bool contains(std::shared_ptr<UBDocumentProxy> proxy, int pageIndex) const;
 
+    bool isLoading(std::shared_ptr<UBDocumentProxy> proxy, int pageIndex) const;
+
+    void cancelLoading(std::shared_ptr<UBDocumentProxy> proxy, int pageIndex);
+
     std::shared_ptr<UBGraphicsScene> value(std::shared_ptr<UBDocumentProxy> proxy, int pageIndex);
 
     void removeScene(std::shared_ptr<UBDocumentProxy> proxy, int pageIndex);
@@ -100,34 +119,83 @@ public:
 
     void shiftUpScenes(std::shared_ptr<UBDocumentProxy> proxy, int startIncIndex, int endIncIndex);
 
+    // time in ms from prepareLoading until the scene was complete, -1 if unknown or still loading
+    qint64 loadLatency(std::shared_ptr<UBDocumentProxy> proxy, int pageIndex) const;
+
+    // time in ms spent on the GUI thread for building the scene
+    qint64 blockingTime(std::shared_ptr<UBDocumentProxy> proxy, int pageIndex) const;
+
+    // a hit is a call to value() finding a completely loaded scene
+    Statistics statistics() const;
+
 
 private:
     class SceneCacheEntry
     {
     public:
-        SceneCacheEntry(std::shared_ptr<UBDocumentProxy> proxy, int pageIndex);
-        SceneCacheEntry(std::shared_ptr<UBGraphicsScene> scene);
+        SceneCacheEntry(UBSceneCache* cache, std::shared_ptr<UBDocumentProxy> proxy, int pageIndex);
+        SceneCacheEntry(UBSceneCache* cache, std::shared_ptr<UBGraphicsScene> scene);
         ~SceneCacheEntry();
         void startLoading();
         bool isSceneAvailable() const;
         std::shared_ptr<UBGraphicsScene> scene();
+        qint64 loadLatency() const;
+        qint64 blockingTime() const;
+
+        qint64 estimatedSize() const;
+        void setEstimatedSize(qint64 size);
+        bool isCached() const;
+        void setCached(bool cached);
 
     private:
+        void startAttaching();
+        void stopTimer();
+        void finishLoading();
+
+        UBSceneCache* mCache = nullptr;
+        std::shared_ptr<UBDocumentProxy> mProxy = nullptr;
+        int mPageIndex = -1;
+        QFutureWatcher<UBSvgSubsetAdaptor::UBSvgPreloadedData>* mPreloadWatcher = nullptr;
         std::shared_ptr<UBSvgSubsetAdaptor::UBSvgReaderContext> mContext = nullptr;
         std::shared_ptr<UBGraphicsScene> mScene = nullptr;
         QTimer* mTimer = nullptr;
+        QElapsedTimer mLoadTimer;
+        qint64 mLoadLatency = -1;
+        qint64 mBlockingTime = 0;
+        qint64 mEstimatedSize = 0;
+        bool mCached = false;
     };
 
-//    typedef QFuture<std::shared_ptr<UBGraphicsScene>> FutureScene;
-//    typedef std::variant<std::shared_ptr<UBGraphicsScene>, FutureScene> CacheEntry;
+    typedef std::list<UBSceneCacheID> LruList;
 
     void internalMoveScene(std::shared_ptr<UBDocumentProxy> proxy, int sourceIndex, int targetIndex);
 
     void insertEntry(UBSceneCacheID key, std::shared_ptr<SceneCacheEntry> entry);
+    void putEntry(const UBSceneCacheID& key, std::shared_ptr<SceneCacheEntry> entry);
+    std::shared_ptr<SceneCacheEntry> takeEntry(const UBSceneCacheID& key);
+    std::shared_ptr<SceneCacheEntry> takeMovableEntry(const UBSceneCacheID& key);
+    void touch(const UBSceneCacheID& key);
+    void updateEstimatedSize(SceneCacheEntry* entry);
+    bool isEvictable(const UBSceneCacheID& key, const std::shared_ptr<SceneCacheEntry>& entry) const;
+    void evict(const UBSceneCacheID& protectedKey);
+
+    static qint64 estimatedSceneSize(UBGraphicsScene* scene);
+
+    QList<int> cachedPages(UBDocumentProxy* proxy) const;
 
     QHash<UBSceneCacheID, std::shared_ptr<SceneCacheEntry>> mSceneCache;
 
-    QQueue<UBSceneCacheID> mCachedKeyFIFO;
+    // cached page indexes per document
+    QHash<UBDocumentProxy*, QSet<int>> mDocumentPartitions;
+
+    // least recently used key first
+    LruList mLruKeys;
+    QHash<UBSceneCacheID, LruList::iterator> mLruPositions;
+
+    qint64 mEstimatedBytes = 0;
+    quint64 mHits = 0;
+    quint64 mMisses = 0;
+    quint64 mEvictions = 0;
 
     QHash<UBSceneCacheID, UBGraphicsScene::SceneViewState> mViewStates;
 };
@@ -285,6 +285,8 @@ void UBSettings::init()
     boardMarkerPressureSensitive = new UBSetting(this, "Board", "MarkerPressureSensitive", false);
 
     boardUseHighResTabletEvent = new UBSetting(this, "Board", "UseHighResTabletEvent", true);
+    boardEraseWholeStrokes = new UBSetting(this, "Board", "EraseWholeStrokes", false);
+    boardTabletEraserErasesWholeStrokes = new UBSetting(this, "Board", "TabletEraserErasesWholeStrokes", false);
 
     boardInterpolatePenStrokes = new UBSetting(this, "Board", "InterpolatePenStrokes", true);
     boardSimplifyPenStrokes = new UBSetting(this, "Board", "SimplifyPenStrokes", true);
@@ -293,6 +295,8 @@ void UBSettings::init()
 
     boardInterpolateMarkerStrokes = new UBSetting(this, "Board", "InterpolateMarkerStrokes", true);
     boardSimplifyMarkerStrokes = new UBSetting(this, "Board", "SimplifyMarkerStrokes", true);
+    boardMarkerStrokeLayer = new UBSetting(this, "Board", "MarkerStrokeLayer", true);
+    boardWetInk = new UBSetting(this, "Board", "WetInk", true);
 
     boardKeyboardPaletteKeyBtnSize = new UBSetting(this, "Board", "KeyboardPaletteKeyBtnSize", "16x16");
     ValidateKeyboardPaletteKeyBtnSize();
@@ -374,6 +378,10 @@ void UBSettings::init()
     webPrivateBrowsing = new UBSetting(this, "Web", "PrivateBrowsing", false);
 
     pageCacheSize = new UBSetting(this, "App", "PageCacheSize", 20);
+    pageCacheMemoryBudget = new UBSetting(this, "App", "PageCacheMemoryBudgetMB", 512);
+    pageLoadInBackground = new UBSetting(this, "App", "PageLoadInBackground", true);
+    thumbnailMemoryBudget = new UBSetting(this, "App", "ThumbnailMemoryBudgetMB", 64);
+    thumbnailPack = new UBSetting(this, "App", "ThumbnailPack", true);
 
     bitmapFileExtensions << "jpg" << "jpeg" <<  "png" <<  "tiff" << "tif" << "bmp" << "gif";
     vectoFileExtensions << "svg" <<  "svgz";
@@ -415,12 +423,14 @@ void UBSettings::init()
     magnifierDrawingMode = new UBSetting(this, "Board", "MagnifierDrawingMode", "0");
     autoSaveInterval = new UBSetting(this, "Board", "AutoSaveIntervalInMinutes", "3");
 
+    svgCoordinatePrecision = new UBSetting(this, "SVG", "CoordinatePrecision", -1);
     svgViewBoxMargin = new UBSetting(this, "SVG", "ViewBoxMargin", "50");
 
     pdfMargin = new UBSetting(this, "PDF", "Margin", "20");
     pdfPageFormat = new UBSetting(this, "PDF", "PageFormat", "A4");
     pdfUsePDFMerger = new UBSetting(this, "PDF", "UsePDFMerger", "true");
     pdfResolution = new UBSetting(this, "PDF", "Resolution", "300");
+    pdfTileCacheBudget = new UBSetting(this, "PDF", "TileCacheBudgetMB", 128);
 
     exportBackgroundGrid = new UBSetting(this, "PDF", "ExportBackgroundGrid", false);
     exportBackgroundColor = new UBSetting(this, "PDF", "ExportBackgroundColor", false);
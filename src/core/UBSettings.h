@@ -287,6 +287,8 @@ class UBSettings : public QObject
         UBSetting* boardMarkerPressureSensitive;
 
         UBSetting* boardUseHighResTabletEvent;
+        UBSetting* boardEraseWholeStrokes;
+        UBSetting* boardTabletEraserErasesWholeStrokes;
 
         UBSetting* boardInterpolatePenStrokes;
         UBSetting* boardSimplifyPenStrokes;
@@ -294,6 +296,8 @@ class UBSettings : public QObject
         UBSetting* boardSimplifyPenStrokesThresholdWidthDifference;
         UBSetting* boardInterpolateMarkerStrokes;
         UBSetting* boardSimplifyMarkerStrokes;
+        UBSetting* boardMarkerStrokeLayer;
+        UBSetting* boardWetInk;
 
         UBSetting* boardKeyboardPaletteKeyBtnSize;
 
@@ -339,6 +343,10 @@ class UBSettings : public QObject
         UBSetting* webPrivateBrowsing;
 
         UBSetting* pageCacheSize;
+        UBSetting* pageCacheMemoryBudget;
+        UBSetting* pageLoadInBackground;
+        UBSetting* thumbnailMemoryBudget;
+        UBSetting* thumbnailPack;
 
         UBSetting* boardZoomBase;
         UBSetting* boardZoomFactor;
@@ -361,11 +369,13 @@ class UBSettings : public QObject
 
         QMap<DocumentSizeRatio::Enum, QSize> documentSizes;
 
+        UBSetting* svgCoordinatePrecision;
         UBSetting* svgViewBoxMargin;
         UBSetting* pdfMargin;
         UBSetting* pdfPageFormat;
         UBSetting* pdfUsePDFMerger;
         UBSetting* pdfResolution;
+        UBSetting* pdfTileCacheBudget;
 
         UBSetting* exportBackgroundGrid;
         UBSetting* exportBackgroundColor;
@@ -0,0 +1,475 @@
+/*
+ * Copyright (C) 2015-2022 Département de l'Instruction Publique (DIP-SEM)
+ *
+ * Copyright (C) 2013 Open Education Foundation
+ *
+ * Copyright (C) 2010-2013 Groupement d'Intérêt Public pour
+ * l'Education Numérique en Afrique (GIP ENA)
+ *
+ * This file is part of OpenBoard.
+ *
+ * OpenBoard is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3 of the License,
+ * with a specific linking exception for the OpenSSL project's
+ * "OpenSSL" library (or with modified versions of it that use the
+ * same license as the "OpenSSL" library).
+ *
+ * OpenBoard is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with OpenBoard. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+
+
+
+
+
+#include "UBThumbnailService.h"
+
+#include <QBuffer>
+#include <QElapsedTimer>
+#include <QImageReader>
+#include <QtConcurrent>
+
+#include "adaptors/UBThumbnailAdaptor.h"
+#include "adaptors/UBThumbnailPack.h"
+
+#include "core/UBApplication.h"
+#include "core/UBSettings.h"
+
+#include "document/UBDocumentProxy.h"
+
+#include "domain/UBGraphicsScene.h"
+
+#include "core/memcheck.h"
+
+// recently used thumbnails kept in memory, in kilobytes
+static const int sRecentCacheSize = 32 * 1024;
+
+// same time slice as the scene cache uses for attaching items
+static const qint64 sAttachTimeSliceMs = 5;
+
+namespace
+{
+    // keep most cores for the user interface while working
+    int backgroundThreadCount()
+    {
+        return qBound(1, QThread::idealThreadCount() / 2, 4);
+    }
+
+    int imageCost(const QImage& image)
+    {
+        return qMax(1, image.bytesPerLine() * image.height() / 1024);
+    }
+}
+
+UBThumbnailService* UBThumbnailService::sSingleton = nullptr;
+
+UBThumbnailService* UBThumbnailService::service()
+{
+    if (!sSingleton)
+    {
+        sSingleton = new UBThumbnailService(UBApplication::staticMemoryCleaner);
+    }
+
+    return sSingleton;
+}
+
+void UBThumbnailService::destroy()
+{
+    if (sSingleton)
+        delete sSingleton;
+    sSingleton = nullptr;
+}
+
+UBThumbnailService::UBThumbnailService(QObject* parent)
+    : QObject(parent)
+    , mNextSerial(0)
+    , mRecent(sRecentCacheSize)
+    , mInvalidations(0)
+    , mGenerating({UBSceneCacheID(), 0, QSize()})
+    , mPreloadWatcher(nullptr)
+{
+    mThreadPool.setMaxThreadCount(backgroundThreadCount());
+
+    mAttachTimer.setInterval(0);
+    connect(&mAttachTimer, &QTimer::timeout, this, &UBThumbnailService::attachItems);
+}
+
+UBThumbnailService::~UBThumbnailService()
+{
+    cancelGeneration();
+
+    // let the generated thumbnails be written
+    mThreadPool.waitForDone();
+}
+
+QPixmap UBThumbnailService::thumbnail(std::shared_ptr<UBDocumentProxy> proxy, int pageIndex, const QSize& size)
+{
+    UBSceneCacheID id(proxy, pageIndex);
+
+    Thumbnail* recent = mRecent.object(id);
+
+    if (recent && covers(*recent, size))
+    {
+        return QPixmap::fromImage(recent->image);
+    }
+
+    bool pending = mPending.contains(id);
+
+    if (pending)
+    {
+        // a larger request replaces the running one
+        const QSize pendingSize = mPending.value(id).size;
+        pending = !pendingSize.isValid() || (size.isValid() && pendingSize.expandedTo(size) == pendingSize);
+    }
+
+    if (!pending)
+    {
+        Request request = {id, ++mNextSerial, size};
+        mPending.insert(id, request);
+        load(request);
+    }
+
+    return QPixmap();
+}
+
+void UBThumbnailService::insert(std::shared_ptr<UBDocumentProxy> proxy, int pageIndex, const QImage& thumbnail)
+{
+    UBSceneCacheID id(proxy, pageIndex);
+
+    if (mPending.contains(id))
+    {
+        // jobs still running for this page are outdated now
+        deliver(id, {thumbnail, false});
+    }
+    else
+    {
+        mRecent.insert(id, new Thumbnail{thumbnail, false}, imageCost(thumbnail));
+    }
+}
+
+void UBThumbnailService::invalidate(std::shared_ptr<UBDocumentProxy> proxy)
+{
+    ++mInvalidations;
+
+    foreach(const UBSceneCacheID& id, mRecent.keys())
+    {
+        if (id.documentProxy == proxy)
+            mRecent.remove(id);
+    }
+
+    // the pack holds the thumbnails by page index, it is filled again from the page files
+    UBThumbnailPack::remove(proxy->persistencePath());
+
+    // running jobs of this document use outdated page files, restart the requests
+    QList<Request> restarted;
+
+    for (auto it = mPending.begin(); it != mPending.end(); ++it)
+    {
+        if (it.key().documentProxy == proxy)
+        {
+            it.value().serial = ++mNextSerial;
+            restarted << it.value();
+        }
+    }
+
+    for (auto it = mGenerationQueue.begin(); it != mGenerationQueue.end(); )
+    {
+        if (it->id.documentProxy == proxy)
+            it = mGenerationQueue.erase(it);
+        else
+            ++it;
+    }
+
+    if (mGenerating.id.documentProxy == proxy)
+    {
+        cancelGeneration();
+    }
+
+    foreach(const Request& request, restarted)
+    {
+        load(request);
+    }
+
+    generateNext();
+
+    emit invalidated(proxy);
+}
+
+void UBThumbnailService::reload(std::shared_ptr<UBDocumentProxy> proxy, int pageIndex)
+{
+    UBSceneCacheID id(proxy, pageIndex);
+
+    mRecent.remove(id);
+
+    // a new serial outdates the jobs still running for this page
+    const QSize size = mPending.contains(id) ? mPending.value(id).size : QSize();
+    Request request = {id, ++mNextSerial, size};
+    mPending.insert(id, request);
+    load(request);
+}
+
+QPixmap UBThumbnailService::placeholder(std::shared_ptr<UBDocumentProxy> proxy)
+{
+    // same aspect ratio as the thumbnail, so that the layout does not change when it arrives
+    QSize documentSize = proxy->defaultDocumentSize();
+    qreal ratio = documentSize.isEmpty() ? UBSettings::minScreenRatio : qreal(documentSize.width()) / documentSize.height();
+
+    const int height = qRound(UBSettings::maxThumbnailWidth / ratio);
+    const quint64 key = (quint64(quint32(UBSettings::maxThumbnailWidth)) << 32) | quint32(height);
+
+    if (!mPlaceholders.contains(key))
+    {
+        QPixmap pixmap(UBSettings::maxThumbnailWidth, height);
+        pixmap.fill(QColor(240, 240, 240));
+
+        mPlaceholders.insert(key, pixmap);
+    }
+
+    return mPlaceholders.value(key);
+}
+
+void UBThumbnailService::load(const Request& request)
+{
+    const QString documentPath = request.id.documentProxy->persistencePath();
+    const QString fileName = UBThumbnailAdaptor::thumbnailUrl(request.id.documentProxy, request.id.pageIndex).toLocalFile();
+
+    const int pageIndex = request.id.pageIndex;
+    const QSize size = request.size;
+
+    QFutureWatcher<Thumbnail>* watcher = new QFutureWatcher<Thumbnail>(this);
+
+    connect(watcher, &QFutureWatcher<Thumbnail>::finished, this, [this, watcher, request](){
+        loaded(request, watcher->result());
+        watcher->deleteLater();
+    });
+
+    watcher->setFuture(QtConcurrent::run(&mThreadPool, [documentPath, fileName, pageIndex, size](){
+        auto decode = [size](QByteArray data, Thumbnail& thumbnail){
+            QBuffer buffer(&data);
+            buffer.open(QIODevice::ReadOnly);
+
+            QImageReader reader(&buffer);
+            const QSize fileSize = reader.size();
+
+            if (size.isValid() && fileSize.isValid() && (fileSize.width() > size.width() || fileSize.height() > size.height()))
+            {
+                // let the JPEG decoder skip the details which are not displayed
+                reader.setScaledSize(fileSize.scaled(size, Qt::KeepAspectRatio));
+                thumbnail.scaled = true;
+            }
+
+            return reader.read(&thumbnail.image);
+        };
+
+        Thumbnail thumbnail = {QImage(), false};
+
+        // the pack of the document is already open for the neighbouring pages
+        if (decode(UBThumbnailPack::read(documentPath, pageIndex), thumbnail))
+        {
+            return thumbnail;
+        }
+
+        thumbnail.scaled = false;
+
+        QFile file(fileName);
+
+        if (!file.open(QIODevice::ReadOnly))
+        {
+            return thumbnail;
+        }
+
+        const QByteArray data = file.readAll();
+        file.close();
+
+        // a damaged thumbnail, e.g. after a power cut, is generated again and then
+        // replaces the file atomically, so it is not removed here
+        if (decode(data, thumbnail))
+        {
+            // older documents get their pack while they are browsed
+            UBThumbnailPack::add(documentPath, pageIndex, data);
+        }
+
+        return thumbnail;
+    }));
+}
+
+void UBThumbnailService::loaded(const Request& request, const Thumbnail& thumbnail)
+{
+    if (UBApplication::isClosing || !isCurrent(request))
+    {
+        return;
+    }
+
+    if (thumbnail.image.isNull())
+    {
+        mGenerationQueue << request;
+        generateNext();
+    }
+    else
+    {
+        deliver(request.id, thumbnail);
+    }
+}
+
+void UBThumbnailService::generateNext()
+{
+    if (mPreloadWatcher || mContext || mGenerationQueue.isEmpty() || UBApplication::isClosing)
+    {
+        return;
+    }
+
+    mGenerating = mGenerationQueue.takeFirst();
+
+    // read and parse the page and decode its images on the thread pool
+    const QString documentPath = mGenerating.id.documentProxy->persistencePath();
+    const int pageIndex = mGenerating.id.pageIndex;
+
+    mPreloadWatcher = new QFutureWatcher<UBSvgSubsetAdaptor::UBSvgPreloadedData>(this);
+
+    connect(mPreloadWatcher, &QFutureWatcher<UBSvgSubsetAdaptor::UBSvgPreloadedData>::finished, this, [this](){
+        UBSvgSubsetAdaptor::UBSvgPreloadedData data = mPreloadWatcher->result();
+
+        mPreloadWatcher->deleteLater();
+        mPreloadWatcher = nullptr;
+
+        if (UBApplication::isClosing)
+        {
+            return;
+        }
+
+        if (!isCurrent(mGenerating) || data.tokens.isEmpty())
+        {
+            // outdated, or the page does not exist (anymore)
+            if (isCurrent(mGenerating))
+                mPending.remove(mGenerating.id);
+
+            mGenerating = {UBSceneCacheID(), 0, QSize()};
+            generateNext();
+            return;
+        }
+
+        mContext = std::make_shared<UBSvgSubsetAdaptor::UBSvgReaderContext>(mGenerating.id.documentProxy, data);
+        mAttachTimer.start();
+    });
+
+    mPreloadWatcher->setFuture(QtConcurrent::run(&mThreadPool, [documentPath, pageIndex](){
+        return UBSvgSubsetAdaptor::preloadScene(documentPath, pageIndex);
+    }));
+}
+
+void UBThumbnailService::attachItems()
+{
+    if (!mContext || UBApplication::isClosing)
+    {
+        cancelGeneration();
+        return;
+    }
+
+    if (!isCurrent(mGenerating))
+    {
+        cancelGeneration();
+        generateNext();
+        return;
+    }
+
+    // attach items in bounded time slices to keep the GUI responsive
+    QElapsedTimer sliceTimer;
+    sliceTimer.start();
+
+    while (!mContext->isFinished() && sliceTimer.elapsed() < sAttachTimeSliceMs)
+    {
+        mContext->step();
+    }
+
+    if (mContext->isFinished())
+    {
+        finishGeneration();
+    }
+}
+
+void UBThumbnailService::finishGeneration()
+{
+    mAttachTimer.stop();
+
+    std::shared_ptr<UBGraphicsScene> scene = mContext->scene();
+    mContext = nullptr;
+
+    if (scene)
+    {
+        // rendering needs the GUI thread, encoding does not
+        QImage thumbnail = UBThumbnailAdaptor::render(mGenerating.id.documentProxy, scene, mGenerating.id.pageIndex, true);
+        const QString documentPath = mGenerating.id.documentProxy->persistencePath();
+        const int pageIndex = mGenerating.id.pageIndex;
+        const quint64 invalidations = mInvalidations;
+
+        QFutureWatcher<QByteArray>* watcher = new QFutureWatcher<QByteArray>(this);
+
+        connect(watcher, &QFutureWatcher<QByteArray>::finished, this, [this, watcher, documentPath, pageIndex, invalidations](){
+            const QByteArray jpeg = watcher->result();
+            watcher->deleteLater();
+
+            // written on the GUI thread, where the pages are renumbered
+            if (!UBApplication::isClosing && invalidations == mInvalidations && !jpeg.isEmpty())
+                UBThumbnailAdaptor::write(documentPath, pageIndex, jpeg);
+        });
+
+        watcher->setFuture(QtConcurrent::run(&mThreadPool, [thumbnail](){
+            return UBThumbnailAdaptor::encode(thumbnail);
+        }));
+
+        deliver(mGenerating.id, {thumbnail, false});
+    }
+    else
+    {
+        // a later request tries again
+        mPending.remove(mGenerating.id);
+    }
+
+    mGenerating = {UBSceneCacheID(), 0, QSize()};
+
+    generateNext();
+}
+
+void UBThumbnailService::cancelGeneration()
+{
+    mAttachTimer.stop();
+    mContext = nullptr;
+
+    if (mPreloadWatcher)
+    {
+        // the worker just finishes its job, the result is discarded
+        mPreloadWatcher->disconnect();
+        mPreloadWatcher->deleteLater();
+        mPreloadWatcher = nullptr;
+    }
+
+    mGenerating = {UBSceneCacheID(), 0, QSize()};
+}
+
+void UBThumbnailService::deliver(const UBSceneCacheID& id, const Thumbnail& thumbnail)
+{
+    mPending.remove(id);
+    mRecent.insert(id, new Thumbnail(thumbnail), imageCost(thumbnail.image));
+
+    emit thumbnailReady(id.documentProxy, id.pageIndex, QPixmap::fromImage(thumbnail.image));
+}
+
+bool UBThumbnailService::isCurrent(const Request& request) const
+{
+    return request.serial != 0 && mPending.contains(request.id) && mPending.value(request.id).serial == request.serial;
+}
+
+bool UBThumbnailService::covers(const Thumbnail& thumbnail, const QSize& size)
+{
+    // a scaled thumbnail fills the requested size in at least one direction
+    return !thumbnail.scaled
+        || (size.isValid() && (thumbnail.image.width() >= size.width() || thumbnail.image.height() >= size.height()));
+}
@@ -0,0 +1,139 @@
+/*
+ * Copyright (C) 2015-2022 Département de l'Instruction Publique (DIP-SEM)
+ *
+ * Copyright (C) 2013 Open Education Foundation
+ *
+ * Copyright (C) 2010-2013 Groupement d'Intérêt Public pour
+ * l'Education Numérique en Afrique (GIP ENA)
+ *
+ * This file is part of OpenBoard.
+ *
+ * OpenBoard is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3 of the License,
+ * with a specific linking exception for the OpenSSL project's
+ * "OpenSSL" library (or with modified versions of it that use the
+ * same license as the "OpenSSL" library).
+ *
+ * OpenBoard is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with OpenBoard. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+
+
+
+
+
+#ifndef UBTHUMBNAILSERVICE_H
+#define UBTHUMBNAILSERVICE_H
+
+#include <QCache>
+#include <QFutureWatcher>
+#include <QHash>
+#include <QImage>
+#include <QObject>
+#include <QPixmap>
+#include <QThreadPool>
+#include <QTimer>
+
+#include <memory>
+
+#include "adaptors/UBSvgSubsetAdaptor.h"
+#include "core/UBSceneCache.h"
+
+class UBDocumentProxy;
+
+/**
+ * Provides page thumbnails without blocking the user interface.
+ *
+ * Thumbnails are read and decoded on a thread pool. Missing thumbnails are generated
+ * one page after the other: the page is preloaded on the thread pool, its items are
+ * attached in short time slices on the GUI thread and the scene is rendered there,
+ * then the JPEG is encoded on the thread pool. It is written on the GUI thread unless
+ * the pages of a document were renumbered meanwhile.
+ *
+ * A thumbnail which is not available yet is delivered later by thumbnailReady.
+ * Several requests for the same page are served by a single job. Views showing many
+ * pages ask for the size they display, so that the JPEG is decoded at that size.
+ */
+class UBThumbnailService : public QObject
+{
+    Q_OBJECT
+
+    public:
+        static UBThumbnailService* service();
+        static void destroy();
+
+        // returns a null pixmap if the thumbnail is not available yet, an invalid size means full size
+        QPixmap thumbnail(std::shared_ptr<UBDocumentProxy> proxy, int pageIndex, const QSize& size = QSize());
+
+        // a thumbnail rendered while saving the page, which may not be on disk yet
+        void insert(std::shared_ptr<UBDocumentProxy> proxy, int pageIndex, const QImage& thumbnail);
+
+        // pages of the document were inserted, removed or moved
+        void invalidate(std::shared_ptr<UBDocumentProxy> proxy);
+
+        // the thumbnail file of the page was replaced, the views get it again
+        void reload(std::shared_ptr<UBDocumentProxy> proxy, int pageIndex);
+
+        // shown until the thumbnail is available, shares its data with all placeholders of the same size
+        QPixmap placeholder(std::shared_ptr<UBDocumentProxy> proxy);
+
+    signals:
+        void thumbnailReady(std::shared_ptr<UBDocumentProxy> proxy, int pageIndex, const QPixmap& thumbnail);
+        void invalidated(std::shared_ptr<UBDocumentProxy> proxy);
+
+    private slots:
+        void generateNext();
+        void attachItems();
+
+    private:
+        UBThumbnailService(QObject* parent = nullptr);
+        virtual ~UBThumbnailService();
+
+        struct Request
+        {
+            UBSceneCacheID id;
+            quint64 serial;
+            QSize size;
+        };
+
+        struct Thumbnail
+        {
+            QImage image;
+            bool scaled;
+        };
+
+        void load(const Request& request);
+        void loaded(const Request& request, const Thumbnail& thumbnail);
+        void finishGeneration();
+        void cancelGeneration();
+        void deliver(const UBSceneCacheID& id, const Thumbnail& thumbnail);
+        bool isCurrent(const Request& request) const;
+        static bool covers(const Thumbnail& thumbnail, const QSize& size);
+
+        static UBThumbnailService* sSingleton;
+
+        QThreadPool mThreadPool;
+        QHash<UBSceneCacheID, Request> mPending;
+        quint64 mNextSerial;
+        QCache<UBSceneCacheID, Thumbnail> mRecent;
+        QHash<quint64, QPixmap> mPlaceholders;
+
+        // counts the calls of invalidate(), the index of a page may have changed
+        quint64 mInvalidations;
+
+        QList<Request> mGenerationQueue;
+        Request mGenerating;
+        QFutureWatcher<UBSvgSubsetAdaptor::UBSvgPreloadedData>* mPreloadWatcher;
+        std::shared_ptr<UBSvgSubsetAdaptor::UBSvgReaderContext> mContext;
+        QTimer mAttachTimer;
+};
+
+#endif // UBTHUMBNAILSERVICE_H
@@ -4,8 +4,11 @@ HEADERS      += src/core/UB.h \
                 src/core/UBApplication.h \
                 src/core/UBSettings.h \
                 src/core/UBSetting.h \
+                src/core/UBPageImporter.h \
                 src/core/UBPersistenceManager.h \
                 src/core/UBSceneCache.h \
+                src/core/UBPrefetchScheduler.h \
+                src/core/UBThumbnailService.h \
                 src/core/UBPreferencesController.h \
                 src/core/UBMimeData.h \
                 src/core/UBIdleTimer.h \
@@ -23,8 +26,11 @@ SOURCES      += src/core/main.cpp \
                 src/core/UBApplication.cpp \
                 src/core/UBSettings.cpp \
                 src/core/UBSetting.cpp \
+                src/core/UBPageImporter.cpp \
                 src/core/UBPersistenceManager.cpp \
                 src/core/UBSceneCache.cpp \
+                src/core/UBPrefetchScheduler.cpp \
+                src/core/UBThumbnailService.cpp \
                 src/core/UBPreferencesController.cpp \
                 src/core/UBMimeData.cpp \
                 src/core/UBIdleTimer.cpp \
@@ -30,6 +30,7 @@
 #include "UBDocumentContainer.h"
 #include "adaptors/UBThumbnailAdaptor.h"
 #include "core/UBPersistenceManager.h"
+#include "frameworks/UBAtomicFileBatch.h"
 #include "core/memcheck.h"
 
 
@@ -48,6 +49,10 @@ void UBDocumentContainer::setDocument(std::shared_ptr<UBDocumentProxy> document,
     if (mCurrentDocument != document || forceReload)
     {
         mCurrentDocument = document;
+
+        if (mCurrentDocument)
+            UBAtomicFileBatch::removeStaleFiles(mCurrentDocument->persistencePath());
+
         emit documentSet(mCurrentDocument);
         reloadThumbnails();
     }
@@ -42,6 +42,7 @@
 #include "core/UBSetting.h"
 #include "core/UBMimeData.h"
 #include "core/UBForeignObjectsHandler.h"
+#include "core/UBThumbnailService.h"
 
 #include "adaptors/UBExportPDF.h"
 #include "adaptors/UBThumbnailAdaptor.h"
@@ -1682,14 +1683,12 @@ void UBDocumentTreeView::dropEvent(QDropEvent *event)
                     }
                 }
 
-                UBPersistenceManager::persistenceManager()->insertDocumentSceneAt(targetDocProxy, sceneClone, targetDocProxy->pageCount());
+                // the thumbnail is copied, as the invisible clone does not render a correct one
+                UBPersistenceManager::persistenceManager()->insertCopiedSceneAt(targetDocProxy, sceneClone, toIndex, fromProxy, fromIndex);
 
                 QString thumbTmp(fromProxy->persistencePath() + UBFileSystemUtils::digitFileFormat("/page%1.thumbnail.jpg", fromIndex));
                 QString thumbTo(targetDocProxy->persistencePath() + UBFileSystemUtils::digitFileFormat("/page%1.thumbnail.jpg", toIndex));
 
-                QFile::remove(thumbTo);
-                QFile::copy(thumbTmp, thumbTo);
-
                 Q_ASSERT(QFileInfo::exists(thumbTmp));
                 Q_ASSERT(QFileInfo::exists(thumbTo));
 
@@ -3357,6 +3356,36 @@ void UBDocumentController::insertThumbnail(int index, const QPixmap& pix)
     mDocumentUI->thumbnailWidget->insertThumbnail(index, newThumbnail);
 }
 
+void UBDocumentController::appendThumbnails(std::shared_ptr<UBDocumentProxy> document, int firstSceneIndex)
+{
+    // otherwise the thumbnails are reloaded when the document is shown
+    if (document != selectedDocument() || documentThumbs().size() != firstSceneIndex)
+        return;
+
+    // the view loads the thumbnails it shows
+    auto placeholder = std::make_shared<QPixmap>(UBThumbnailService::service()->placeholder(document));
+    const bool showsDocument = mDocumentUI->thumbnailWidget->currentThumbnailsDocument() == document;
+
+    QList<QGraphicsItem*> items;
+    QList<QUrl> itemsPath;
+    QStringList labels;
+
+    for (int i = firstSceneIndex; i < document->pageCount(); i++)
+    {
+        addPixmapAt(placeholder, i);
+
+        if (showsDocument)
+        {
+            items << new UBSceneThumbnailPixmap(*placeholder, document, i); // deleted by the tree widget
+            labels << tr("Page %1").arg(pageFromSceneIndex(i));
+            itemsPath.append(QUrl::fromLocalFile(document->persistencePath() + QString("/pages/%1").arg(UBDocumentContainer::pageFromSceneIndex(i))));
+        }
+    }
+
+    if (showsDocument)
+        mDocumentUI->thumbnailWidget->appendGraphicsItems(items, itemsPath, labels);
+}
+
 void UBDocumentController::updateThumbnail(int index)
 {
     auto pix = pageAt(index);
@@ -518,6 +518,8 @@ class UBDocumentController : public UBDocumentContainer
         void removeThumbnail(int index);
         void moveThumbnail(int from, int to);
         void insertThumbnail(int index, const QPixmap& pix);
+        // pages appended to the end of the document, the items of the other pages are kept
+        void appendThumbnails(std::shared_ptr<UBDocumentProxy> document, int firstSceneIndex);
 
 protected:
         virtual void setupViews();
@@ -0,0 +1,334 @@
+/*
+ * Copyright (C) 2015-2022 Département de l'Instruction Publique (DIP-SEM)
+ *
+ * Copyright (C) 2013 Open Education Foundation
+ *
+ * Copyright (C) 2010-2013 Groupement d'Intérêt Public pour
+ * l'Education Numérique en Afrique (GIP ENA)
+ *
+ * This file is part of OpenBoard.
+ *
+ * OpenBoard is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3 of the License,
+ * with a specific linking exception for the OpenSSL project's
+ * "OpenSSL" library (or with modified versions of it that use the
+ * same license as the "OpenSSL" library).
+ *
+ * OpenBoard is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with OpenBoard. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+
+
+
+
+
+#include "UBBackgroundRenderer.h"
+
+#include <QtMath>
+
+#include "core/memcheck.h"
+
+const int UBBackgroundRenderer::sStripLength = 256;
+const int UBBackgroundRenderer::sStripThickness = 4;
+const int UBBackgroundRenderer::sMaxScales = 3;
+const int UBBackgroundRenderer::sMaxStrips = 256;
+
+// positions are truncated, as the integer drawLine() used to do
+static void drawHorizontalLine(QPainter* painter, const QRectF& rect, qreal y)
+{
+    painter->drawLine(QLineF(rect.left(), (int) y, rect.right(), (int) y));
+}
+
+static void drawVerticalLine(QPainter* painter, const QRectF& rect, qreal x)
+{
+    painter->drawLine(QLineF((int) x, rect.top(), (int) x, rect.bottom()));
+}
+
+bool UBBackgroundRenderer::Pattern::operator==(const Pattern& other) const
+{
+    return background == other.background
+            && seyes == other.seyes
+            && intermediateLines == other.intermediateLines
+            && gridSize == other.gridSize
+            && color == other.color
+            && pageLeft == other.pageLeft;
+}
+
+
+UBBackgroundRenderer::UBBackgroundRenderer()
+{
+    // NOOP
+}
+
+
+void UBBackgroundRenderer::draw(QPainter* painter, const Pattern& pattern, const QRectF& rect)
+{
+    if (pattern.background == UBPageBackground::plain || pattern.gridSize <= 0)
+        return;
+
+    const QTransform transform = painter->worldTransform();
+
+    // strips only fit unrotated raster output, printers and PDF get the lines
+    if (transform.type() > QTransform::TxScale
+            || transform.m11() != transform.m22() || transform.m11() <= 0
+            || !painter->paintEngine() || painter->paintEngine()->type() != QPaintEngine::Raster)
+    {
+        drawLines(painter, pattern, rect);
+        return;
+    }
+
+    if (pattern != mPattern)
+    {
+        mStrips.clear();
+        mPattern = pattern;
+    }
+
+    const qreal ratio = painter->device()->devicePixelRatioF();
+    const qreal scale = transform.m11() * ratio;
+    const qint64 key = qRound64(scale * 1000);
+
+    if (!mStrips.contains(key))
+    {
+        while (mStrips.size() >= sMaxScales)
+            mStrips.erase(mStrips.begin());
+    }
+
+    Strips& strips = mStrips[key];
+
+    if (strips.rows.size() + strips.columns.size() > sMaxStrips)
+    {
+        strips.rows.clear();
+        strips.columns.clear();
+    }
+
+    // exposed area in device pixels, relative to the scene origin
+    const QRectF deviceRect(rect.topLeft() * scale, rect.bottomRight() * scale);
+    const QPainter::RenderHints hints = painter->renderHints();
+
+    painter->save();
+    painter->setRenderHint(QPainter::SmoothPixmapTransform, false);
+    painter->setWorldTransform(QTransform(1 / ratio, 0, 0, 1 / ratio, transform.dx(), transform.dy()));
+
+    for (int row = qFloor(deviceRect.top() / sStripLength); row <= qFloor(deviceRect.bottom() / sStripLength); ++row)
+    {
+        const QImage& image = strip(strips, Qt::Horizontal, row, scale, hints);
+
+        if (!image.isNull())
+            painter->drawImage(QRectF(deviceRect.left(), row * sStripLength, deviceRect.width(), sStripLength), image);
+    }
+
+    for (int column = qFloor(deviceRect.left() / sStripLength); column <= qFloor(deviceRect.right() / sStripLength); ++column)
+    {
+        const QImage& image = strip(strips, Qt::Vertical, column, scale, hints);
+
+        if (!image.isNull())
+            painter->drawImage(QRectF(column * sStripLength, deviceRect.top(), sStripLength, deviceRect.height()), image);
+    }
+
+    painter->restore();
+}
+
+
+/**
+ * @brief Draw the lines of the pattern in the given scene rect
+ * @param orientations the horizontal lines, the vertical lines or both
+ */
+void UBBackgroundRenderer::drawLines(QPainter* painter, const Pattern& pattern, const QRectF& rect, Qt::Orientations orientations)
+{
+    const bool horizontal = orientations.testFlag(Qt::Horizontal);
+    const bool vertical = orientations.testFlag(Qt::Vertical);
+    const qreal gridSize = pattern.gridSize;
+
+    painter->setPen (pattern.color);
+
+    if (pattern.background == UBPageBackground::crossed)
+    {
+        qreal firstY = ((int) (rect.y () / gridSize)) * gridSize;
+        qreal firstX = ((int) (rect.x () / gridSize)) * gridSize;
+
+        if (horizontal)
+        {
+            for (qreal yPos = firstY; yPos < rect.y () + rect.height (); yPos += gridSize)
+            {
+                drawHorizontalLine(painter, rect, yPos);
+            }
+        }
+
+        if (vertical)
+        {
+            for (qreal xPos = firstX; xPos < rect.x () + rect.width (); xPos += gridSize)
+            {
+                drawVerticalLine(painter, rect, xPos);
+            }
+        }
+
+        if (pattern.intermediateLines)
+        {
+            QColor intermediateColor = pattern.color;
+            intermediateColor.setAlphaF(0.5 * pattern.color.alphaF());
+            painter->setPen(intermediateColor);
+
+            if (horizontal)
+            {
+                for (qreal yPos = firstY - gridSize/2; yPos < rect.y () + rect.height (); yPos += gridSize)
+                {
+                    drawHorizontalLine(painter, rect, yPos);
+                }
+            }
+
+            if (vertical)
+            {
+                for (qreal xPos = firstX - gridSize/2; xPos < rect.x () + rect.width (); xPos += gridSize)
+                {
+                    drawVerticalLine(painter, rect, xPos);
+                }
+            }
+        }
+    }
+    else if (pattern.background == UBPageBackground::ruled)
+    {
+        if (pattern.seyes)
+        {
+            qreal gridSizeSeyes = gridSize * 2; // The grid size must be bigger
+            int nbMarginCase = 1; // a small left margin of one gridSize
+
+            QPen seyesSquare ("#8e7cc3");
+            seyesSquare.setWidthF (2.);
+
+            QColor interlineColor("#6fa8dc");
+            interlineColor.setAlphaF(0.6);
+            QPen interlinePen(interlineColor);
+            interlinePen.setWidthF(2.);
+
+            QPen redLineMargin(QColor("red"));
+            redLineMargin.setWidthF(2.);
+
+            // Horizontal lines
+
+            if (horizontal)
+            {
+                qreal firstY = ((int) (rect.y () / gridSizeSeyes)) * gridSizeSeyes;
+
+                for (qreal yPos = firstY; yPos < rect.y () + rect.height (); yPos += gridSizeSeyes)
+                {
+                    painter->setPen (seyesSquare);
+                    drawHorizontalLine(painter, rect, yPos);
+                    painter->setPen (interlinePen);
+                    drawHorizontalLine(painter, rect, yPos+gridSizeSeyes/4);
+                    drawHorizontalLine(painter, rect, yPos+2*gridSizeSeyes/4);
+                    drawHorizontalLine(painter, rect, yPos+3*gridSizeSeyes/4);
+                }
+            }
+
+            if (vertical)
+            {
+                // Vertical margin
+
+                qreal firstX = nbMarginCase * gridSizeSeyes + pattern.pageLeft;
+
+                painter->setPen(redLineMargin);
+                drawVerticalLine(painter, rect, firstX);
+
+                // Vertical lines
+
+                firstX = (nbMarginCase + 1) * gridSizeSeyes + pattern.pageLeft;
+
+                painter->setPen (seyesSquare);
+                for (qreal xPos = firstX; xPos < rect.x () + rect.width (); xPos += gridSizeSeyes)
+                {
+                    drawVerticalLine(painter, rect, xPos);
+                }
+            }
+        }
+        else if (horizontal)
+        {
+            qreal firstY = ((int) (rect.y () / gridSize)) * gridSize;
+
+            for (qreal yPos = firstY; yPos < rect.y () + rect.height (); yPos += gridSize)
+            {
+                drawHorizontalLine(painter, rect, yPos);
+            }
+
+            if (pattern.intermediateLines) {
+                QColor intermediateColor = pattern.color;
+                intermediateColor.setAlphaF(0.5 * pattern.color.alphaF());
+                painter->setPen(intermediateColor);
+
+                for (qreal yPos = firstY - gridSize/2; yPos < rect.y () + rect.height (); yPos += gridSize)
+                {
+                    drawHorizontalLine(painter, rect, yPos);
+                }
+            }
+        }
+    }
+}
+
+
+/**
+ * @brief The strip of horizontal lines of a band of device rows, or of vertical lines of a band of columns
+ *
+ * A null image is returned for bands without lines.
+ */
+const QImage& UBBackgroundRenderer::strip(Strips& strips, Qt::Orientation orientation, int index, qreal scale, QPainter::RenderHints hints)
+{
+    QHash<int, QImage>& images = orientation == Qt::Horizontal ? strips.rows : strips.columns;
+    QHash<int, QImage>::iterator it = images.find(index);
+
+    if (it != images.end())
+        return it.value();
+
+    const bool horizontal = orientation == Qt::Horizontal;
+    const QSize size = horizontal ? QSize(sStripThickness, sStripLength) : QSize(sStripLength, sStripThickness);
+
+    QImage image(size, QImage::Format_ARGB32_Premultiplied);
+    image.fill(Qt::transparent);
+
+    // the band in scene coordinates, with room for the antialiasing of the lines just outside of it
+    const qreal margin = 4 / scale;
+    const qreal start = index * sStripLength / scale - margin;
+    const qreal length = sStripLength / scale + 2 * margin;
+    const qreal thickness = sStripThickness / scale + 2 * margin;
+
+    const QRectF bandRect = horizontal
+            ? QRectF(-margin, start, thickness, length)
+            : QRectF(start, -margin, length, thickness);
+
+    QPainter painter(&image);
+    painter.setRenderHints(hints);
+
+    if (horizontal)
+        painter.translate(0, -index * sStripLength);
+    else
+        painter.translate(-index * sStripLength, 0);
+
+    painter.scale(scale, scale);
+    drawLines(&painter, mPattern, bandRect, orientation);
+    painter.end();
+
+    // most bands of a ruled page have no vertical line, keep them as null images
+    bool empty = true;
+
+    for (int y = 0; y < image.height() && empty; ++y)
+    {
+        const QRgb* line = reinterpret_cast<const QRgb*>(image.constScanLine(y));
+
+        for (int x = 0; x < image.width(); ++x)
+        {
+            if (qAlpha(line[x]))
+            {
+                empty = false;
+                break;
+            }
+        }
+    }
+
+    return images.insert(index, empty ? QImage() : image).value();
+}
@@ -0,0 +1,95 @@
+/*
+ * Copyright (C) 2015-2022 Département de l'Instruction Publique (DIP-SEM)
+ *
+ * Copyright (C) 2013 Open Education Foundation
+ *
+ * Copyright (C) 2010-2013 Groupement d'Intérêt Public pour
+ * l'Education Numérique en Afrique (GIP ENA)
+ *
+ * This file is part of OpenBoard.
+ *
+ * OpenBoard is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3 of the License,
+ * with a specific linking exception for the OpenSSL project's
+ * "OpenSSL" library (or with modified versions of it that use the
+ * same license as the "OpenSSL" library).
+ *
+ * OpenBoard is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with OpenBoard. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+
+
+
+
+
+#ifndef UBBACKGROUNDRENDERER_H
+#define UBBACKGROUNDRENDERER_H
+
+#include <QtGui>
+
+#include "core/UB.h"
+
+/**
+ * Draws the crossed, ruled and Seyès page backgrounds.
+ *
+ * All these patterns are made of lines spanning the whole page, so the
+ * horizontal lines of a band of device rows look the same at any x, and the
+ * vertical lines of a band of columns at any y. Each band is rendered once, in
+ * device pixels, into a thin strip that is then stretched across the exposed
+ * area. The strips are kept per device scale and dropped when the pattern
+ * changes.
+ */
+class UBBackgroundRenderer
+{
+    public:
+
+        struct Pattern
+        {
+            UBPageBackground background = UBPageBackground::plain;
+            bool seyes = false;
+            bool intermediateLines = false;
+            qreal gridSize = 0;
+            QColor color;
+            // left edge of the page, the Seyès margin is drawn from there
+            qreal pageLeft = 0;
+
+            bool operator==(const Pattern& other) const;
+            bool operator!=(const Pattern& other) const { return !(*this == other); }
+        };
+
+        UBBackgroundRenderer();
+
+        void draw(QPainter* painter, const Pattern& pattern, const QRectF& rect);
+
+        static void drawLines(QPainter* painter, const Pattern& pattern, const QRectF& rect,
+                              Qt::Orientations orientations = Qt::Horizontal | Qt::Vertical);
+
+    private:
+
+        struct Strips
+        {
+            QHash<int, QImage> rows;
+            QHash<int, QImage> columns;
+        };
+
+        const QImage& strip(Strips& strips, Qt::Orientation orientation, int index, qreal scale, QPainter::RenderHints hints);
+
+        static const int sStripLength;
+        static const int sStripThickness;
+        static const int sMaxScales;
+        static const int sMaxStrips;
+
+        Pattern mPattern;
+        // strips by device scale, one per view showing the page
+        QMap<qint64, Strips> mStrips;
+};
+
+#endif // UBBACKGROUNDRENDERER_H
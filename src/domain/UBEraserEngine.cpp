@@ -0,0 +1,521 @@
+/*
+ * Copyright (C) 2015-2022 Département de l'Instruction Publique (DIP-SEM)
+ *
+ * Copyright (C) 2013 Open Education Foundation
+ *
+ * Copyright (C) 2010-2013 Groupement d'Intérêt Public pour
+ * l'Education Numérique en Afrique (GIP ENA)
+ *
+ * This file is part of OpenBoard.
+ *
+ * OpenBoard is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3 of the License,
+ * with a specific linking exception for the OpenSSL project's
+ * "OpenSSL" library (or with modified versions of it that use the
+ * same license as the "OpenSSL" library).
+ *
+ * OpenBoard is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with OpenBoard. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+
+
+
+
+
+#include "UBEraserEngine.h"
+
+#include <QtConcurrent>
+#include <QtMath>
+#include <limits>
+
+#include "domain/UBGraphicsScene.h"
+#include "domain/UBGraphicsPolygonItem.h"
+#include "domain/UBGraphicsStrokeItem.h"
+#include "domain/UBGraphicsStroke.h"
+
+#include "core/memcheck.h"
+
+const int UBEraserEngine::sFrameInterval = 16;
+const int UBEraserEngine::sCellSize = 32;
+const int UBEraserEngine::sMinIndexedSize = 64;
+
+static quint64 cellKey(int column, int row)
+{
+    return (quint64(quint32(column)) << 32) | quint32(row);
+}
+
+static qreal cross(const QPointF& o, const QPointF& a, const QPointF& b)
+{
+    return (a.x() - o.x()) * (b.y() - o.y()) - (a.y() - o.y()) * (b.x() - o.x());
+}
+
+static bool segmentsIntersect(const QPointF& p1, const QPointF& p2, const QPointF& q1, const QPointF& q2)
+{
+    const qreal d1 = cross(q1, q2, p1);
+    const qreal d2 = cross(q1, q2, p2);
+    const qreal d3 = cross(p1, p2, q1);
+    const qreal d4 = cross(p1, p2, q2);
+
+    return ((d1 > 0) != (d2 > 0)) && ((d3 > 0) != (d4 > 0));
+}
+
+static bool segmentTouchesPolygon(const QPointF& p1, const QPointF& p2, const QPolygonF& polygon)
+{
+    if (polygon.containsPoint(p1, Qt::WindingFill) || polygon.containsPoint(p2, Qt::WindingFill))
+        return true;
+
+    const int count = polygon.size();
+
+    for (int i = 0; i < count; ++i)
+    {
+        if (segmentsIntersect(p1, p2, polygon.at(i), polygon.at((i + 1) % count)))
+            return true;
+    }
+
+    return false;
+}
+
+static qreal distanceToSegment(const QPointF& p, const QPointF& a, const QPointF& b)
+{
+    const QPointF ab = b - a;
+    const qreal lengthSquared = QPointF::dotProduct(ab, ab);
+    const qreal t = lengthSquared > 0 ? qBound(0., QPointF::dotProduct(p - a, ab) / lengthSquared, 1.) : 0.;
+
+    return QLineF(p, a + t * ab).length();
+}
+
+static qreal distanceToPolygon(const QPointF& p1, const QPointF& p2, const QPolygonF& polygon)
+{
+    if (segmentTouchesPolygon(p1, p2, polygon))
+        return 0;
+
+    qreal distance = std::numeric_limits<qreal>::max();
+    const int count = polygon.size();
+
+    for (int i = 0; i < count; ++i)
+    {
+        const QPointF& q1 = polygon.at(i);
+        const QPointF& q2 = polygon.at((i + 1) % count);
+
+        distance = qMin(distance, qMin(distanceToSegment(p1, q1, q2), distanceToSegment(p2, q1, q2)));
+        distance = qMin(distance, qMin(distanceToSegment(q1, p1, p2), distanceToSegment(q2, p1, p2)));
+    }
+
+    return distance;
+}
+
+UBEraserEngine::UBEraserEngine(UBGraphicsScene* scene)
+    : QObject(scene)
+    , mScene(scene)
+    , mMode(ClipMode)
+    , mClipping(false)
+{
+    mFrameTimer.setSingleShot(true);
+    mFrameTimer.setInterval(sFrameInterval);
+
+    connect(&mFrameTimer, &QTimer::timeout, this, &UBEraserEngine::flush);
+    connect(&mClipWatcher, &QFutureWatcher<ClipResult>::finished, this, &UBEraserEngine::clipped);
+}
+
+
+UBEraserEngine::~UBEraserEngine()
+{
+    mClipWatcher.waitForFinished();
+}
+
+
+/**
+ * @brief Set how the eraser works until the next call to finish()
+ */
+void UBEraserEngine::setMode(Mode mode)
+{
+    if (mode != mMode)
+        finish();
+
+    mMode = mode;
+}
+
+
+void UBEraserEngine::erase(const QPolygonF& eraserPolygon)
+{
+    mPendingPolygons << eraserPolygon;
+
+    if (!mFrameTimer.isActive() && !mClipping)
+        mFrameTimer.start();
+}
+
+
+/**
+ * @brief Apply all the eraser motion received so far, the index is dropped afterwards
+ */
+void UBEraserEngine::finish()
+{
+    mFrameTimer.stop();
+
+    if (mClipping)
+    {
+        mClipWatcher.waitForFinished();
+        clipped();
+    }
+
+    if (!mPendingPolygons.isEmpty())
+    {
+        const QList<QPolygonF> eraserPolygons = mPendingPolygons;
+        mPendingPolygons.clear();
+
+        QRectF eraserRect;
+
+        foreach (const QPolygonF& polygon, eraserPolygons)
+            eraserRect |= polygon.boundingRect();
+
+        if (mMode == StrokeMode)
+        {
+            eraseStrokes(eraserPolygons, eraserRect);
+        }
+        else
+        {
+            const QPainterPath path = eraserPath(eraserPolygons);
+            QList<ClipResult> results;
+
+            foreach (const ClipJob& job, jobsFor(eraserPolygons, eraserRect))
+                results << clip(job, path);
+
+            apply(results);
+        }
+    }
+
+    mIndex.clear();
+    mMode = ClipMode;
+}
+
+
+void UBEraserEngine::flush()
+{
+    if (mClipping || mPendingPolygons.isEmpty())
+        return;
+
+    const QList<QPolygonF> eraserPolygons = mPendingPolygons;
+    mPendingPolygons.clear();
+
+    QRectF eraserRect;
+
+    foreach (const QPolygonF& polygon, eraserPolygons)
+        eraserRect |= polygon.boundingRect();
+
+    if (mMode == StrokeMode)
+    {
+        eraseStrokes(eraserPolygons, eraserRect);
+        return;
+    }
+
+    const QList<ClipJob> jobs = jobsFor(eraserPolygons, eraserRect);
+
+    if (jobs.isEmpty())
+        return;
+
+    const QPainterPath path = eraserPath(eraserPolygons);
+
+    std::function<ClipResult (const ClipJob& job)> clipLambda = [path](const ClipJob& job) {
+        return clip(job, path);
+    };
+
+    mClipping = true;
+    mClipWatcher.setFuture(QtConcurrent::mapped(jobs, clipLambda));
+}
+
+
+void UBEraserEngine::clipped()
+{
+    // finish() may already have collected the results
+    if (!mClipping)
+        return;
+
+    mClipping = false;
+    apply(mClipWatcher.future().results());
+
+    if (!mPendingPolygons.isEmpty() && !mFrameTimer.isActive())
+        mFrameTimer.start();
+}
+
+
+QList<UBEraserEngine::ClipJob> UBEraserEngine::jobsFor(const QList<QPolygonF>& eraserPolygons, const QRectF& eraserRect)
+{
+    QList<ClipJob> jobs;
+
+    foreach (QGraphicsItem* item, mScene->items(eraserRect, Qt::IntersectsItemBoundingRect))
+    {
+        UBGraphicsPolygonItem* polygonItem = qgraphicsitem_cast<UBGraphicsPolygonItem*>(item);
+
+        if (!polygonItem || !isUnderEraser(polygonItem, eraserPolygons, eraserRect))
+            continue;
+
+        ClipJob job;
+        job.item = polygonItem;
+        job.polygon = mIndex.value(polygonItem).polygon;
+        job.inverted = polygonItem->sceneTransform().inverted();
+        jobs << job;
+    }
+
+    return jobs;
+}
+
+
+bool UBEraserEngine::isUnderEraser(UBGraphicsPolygonItem* item, const QList<QPolygonF>& eraserPolygons, const QRectF& eraserRect)
+{
+    const IndexedPolygon& indexed = indexedPolygon(item);
+
+    if (!indexed.bounds.intersects(eraserRect))
+        return false;
+
+    // small polygons are left to the clipping
+    if (indexed.cells.isEmpty())
+        return true;
+
+    const QRectF rect = indexed.bounds & eraserRect;
+    const int count = indexed.polygon.size();
+
+    for (int row = qFloor(rect.top() / sCellSize); row <= qFloor(rect.bottom() / sCellSize); ++row)
+    {
+        for (int column = qFloor(rect.left() / sCellSize); column <= qFloor(rect.right() / sCellSize); ++column)
+        {
+            foreach (int edge, indexed.cells.value(cellKey(column, row)))
+            {
+                const QPointF& p1 = indexed.polygon.at(edge);
+                const QPointF& p2 = indexed.polygon.at((edge + 1) % count);
+
+                foreach (const QPolygonF& eraserPolygon, eraserPolygons)
+                {
+                    if (segmentTouchesPolygon(p1, p2, eraserPolygon))
+                        return true;
+                }
+            }
+        }
+    }
+
+    // no edge under the eraser, it is either completely inside or outside of the polygon
+    foreach (const QPolygonF& eraserPolygon, eraserPolygons)
+    {
+        if (!eraserPolygon.isEmpty() && indexed.polygon.containsPoint(eraserPolygon.first(), Qt::WindingFill))
+            return true;
+    }
+
+    return false;
+}
+
+
+const UBEraserEngine::IndexedPolygon& UBEraserEngine::indexedPolygon(UBGraphicsPolygonItem* item)
+{
+    QHash<UBGraphicsPolygonItem*, IndexedPolygon>::iterator it = mIndex.find(item);
+
+    if (it != mIndex.end())
+        return it.value();
+
+    IndexedPolygon& indexed = mIndex[item];
+    indexed.polygon = item->sceneTransform().map(item->polygon());
+    indexed.bounds = indexed.polygon.boundingRect();
+
+    const int count = indexed.polygon.size();
+
+    if (count < sMinIndexedSize)
+        return indexed;
+
+    for (int i = 0; i < count; ++i)
+    {
+        const QPointF& p1 = indexed.polygon.at(i);
+        const QPointF& p2 = indexed.polygon.at((i + 1) % count);
+
+        const int firstColumn = qFloor(qMin(p1.x(), p2.x()) / sCellSize);
+        const int lastColumn = qFloor(qMax(p1.x(), p2.x()) / sCellSize);
+        const int firstRow = qFloor(qMin(p1.y(), p2.y()) / sCellSize);
+        const int lastRow = qFloor(qMax(p1.y(), p2.y()) / sCellSize);
+
+        for (int row = firstRow; row <= lastRow; ++row)
+        {
+            for (int column = firstColumn; column <= lastColumn; ++column)
+                indexed.cells[cellKey(column, row)] << i;
+        }
+    }
+
+    return indexed;
+}
+
+
+void UBEraserEngine::apply(const QList<ClipResult>& results)
+{
+    foreach (const ClipResult& result, results)
+    {
+        if (!result.erased)
+            continue;
+
+        mIndex.remove(result.item);
+        mScene->replaceErasedPolygonItem(result.item, result.remains);
+    }
+}
+
+
+void UBEraserEngine::eraseStrokes(const QList<QPolygonF>& eraserPolygons, const QRectF& eraserRect)
+{
+    QSet<UBGraphicsStroke*> erasedStrokes;
+    QList<UBGraphicsPolygonItem*> erasedItems;
+
+    foreach (QGraphicsItem* item, mScene->items(eraserRect, Qt::IntersectsItemBoundingRect))
+    {
+        UBGraphicsPolygonItem* polygonItem = qgraphicsitem_cast<UBGraphicsPolygonItem*>(item);
+
+        if (!polygonItem)
+            continue;
+
+        UBGraphicsStroke* stroke = polygonItem->stroke();
+
+        if (stroke && erasedStrokes.contains(stroke))
+            continue;
+
+        if (!isStrokeUnderEraser(polygonItem, eraserPolygons, eraserRect))
+            continue;
+
+        if (stroke)
+        {
+            erasedStrokes.insert(stroke);
+            erasedItems << stroke->polygons();
+        }
+        else
+        {
+            erasedItems << polygonItem;
+        }
+    }
+
+    foreach (UBGraphicsPolygonItem* polygonItem, erasedItems)
+    {
+        // polygons erased before are still part of their stroke, for undo
+        if (polygonItem->scene() != mScene)
+            continue;
+
+        mIndex.remove(polygonItem);
+        mScene->replaceErasedPolygonItem(polygonItem, QList<QPolygonF>());
+    }
+}
+
+
+bool UBEraserEngine::isStrokeUnderEraser(UBGraphicsPolygonItem* item, const QList<QPolygonF>& eraserPolygons, const QRectF& eraserRect)
+{
+    UBGraphicsStrokeItem* strokeItem = dynamic_cast<UBGraphicsStrokeItem*>(item);
+
+    if (strokeItem && strokeItem->hasCentreline())
+        return isCentrelineUnderEraser(strokeItem->centreline(), strokeItem->sceneTransform(), eraserPolygons, eraserRect);
+
+    // the drawn points of other strokes still cover what the clipping eraser
+    // removed from them, so their current outline is tested instead
+    return isOutlineUnderEraser(item, eraserPolygons, eraserRect);
+}
+
+
+bool UBEraserEngine::isOutlineUnderEraser(UBGraphicsPolygonItem* item, const QList<QPolygonF>& eraserPolygons, const QRectF& eraserRect)
+{
+    const IndexedPolygon& indexed = indexedPolygon(item);
+
+    // indexed outlines are tested exactly already
+    if (!indexed.cells.isEmpty() || !indexed.bounds.intersects(eraserRect))
+        return isUnderEraser(item, eraserPolygons, eraserRect);
+
+    // small outlines are not left to the clipping here, test all their edges
+    const int count = indexed.polygon.size();
+
+    for (int i = 0; i < count; ++i)
+    {
+        const QPointF& p1 = indexed.polygon.at(i);
+        const QPointF& p2 = indexed.polygon.at((i + 1) % count);
+
+        foreach (const QPolygonF& eraserPolygon, eraserPolygons)
+        {
+            if (segmentTouchesPolygon(p1, p2, eraserPolygon))
+                return true;
+        }
+    }
+
+    foreach (const QPolygonF& eraserPolygon, eraserPolygons)
+    {
+        if (!eraserPolygon.isEmpty() && indexed.polygon.containsPoint(eraserPolygon.first(), Qt::WindingFill))
+            return true;
+    }
+
+    return false;
+}
+
+
+bool UBEraserEngine::isCentrelineUnderEraser(const QVector<QPair<QPointF, qreal> >& centreline, const QTransform& transform,
+                                             const QList<QPolygonF>& eraserPolygons, const QRectF& eraserRect)
+{
+    const int count = centreline.size();
+    const qreal scale = qSqrt(qAbs(transform.determinant()));
+
+    for (int i = 0; i < count; ++i)
+    {
+        const int next = qMin(i + 1, count - 1);
+        const QPointF p1 = transform.map(centreline.at(i).first);
+        const QPointF p2 = transform.map(centreline.at(next).first);
+        const qreal halfWidth = qMax(centreline.at(i).second, centreline.at(next).second) * scale / 2;
+
+        if (!QRectF(p1, p2).normalized().adjusted(-halfWidth, -halfWidth, halfWidth, halfWidth).intersects(eraserRect))
+            continue;
+
+        foreach (const QPolygonF& eraserPolygon, eraserPolygons)
+        {
+            if (distanceToPolygon(p1, p2, eraserPolygon) <= halfWidth)
+                return true;
+        }
+
+        if (next == count - 1)
+            break;
+    }
+
+    return false;
+}
+
+
+QPainterPath UBEraserEngine::eraserPath(const QList<QPolygonF>& eraserPolygons)
+{
+    QPainterPath path;
+    path.setFillRule(Qt::WindingFill);
+
+    foreach (const QPolygonF& polygon, eraserPolygons)
+        path.addPolygon(polygon);
+
+    // one outline for the whole frame, the overlapping eraser positions would cancel each other out otherwise
+    return eraserPolygons.size() > 1 ? path.simplified() : path;
+}
+
+
+UBEraserEngine::ClipResult UBEraserEngine::clip(const ClipJob& job, const QPainterPath& eraserPath)
+{
+    ClipResult result;
+    result.item = job.item;
+    result.erased = false;
+
+    QPainterPath itemPainterPath;
+    itemPainterPath.addPolygon(job.polygon);
+
+    if (eraserPath.contains(itemPainterPath))
+    {
+        // Completely remove item
+        result.erased = true;
+    }
+    else if (eraserPath.intersects(itemPainterPath))
+    {
+        itemPainterPath.setFillRule(Qt::WindingFill);
+        // reverse eraserPath so that it has the opposite orientation of the stroke
+        // necessary for punching a hole with WindingFill rule
+        QPainterPath newPath = itemPainterPath.subtracted(eraserPath.toReversed());
+        result.erased = true;
+        result.remains = newPath.simplified().toFillPolygons(job.inverted);
+    }
+
+    return result;
+}
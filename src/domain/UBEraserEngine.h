@@ -0,0 +1,136 @@
+/*
+ * Copyright (C) 2015-2022 Département de l'Instruction Publique (DIP-SEM)
+ *
+ * Copyright (C) 2013 Open Education Foundation
+ *
+ * Copyright (C) 2010-2013 Groupement d'Intérêt Public pour
+ * l'Education Numérique en Afrique (GIP ENA)
+ *
+ * This file is part of OpenBoard.
+ *
+ * OpenBoard is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3 of the License,
+ * with a specific linking exception for the OpenSSL project's
+ * "OpenSSL" library (or with modified versions of it that use the
+ * same license as the "OpenSSL" library).
+ *
+ * OpenBoard is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with OpenBoard. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+
+
+
+
+
+#ifndef UBERASERENGINE_H
+#define UBERASERENGINE_H
+
+#include <QtGui>
+#include <QFutureWatcher>
+
+class UBGraphicsScene;
+class UBGraphicsPolygonItem;
+
+/**
+ * Erases polygon items of a scene along the eraser path.
+ *
+ * Eraser motion is accumulated over a frame and clipped in one batch, on the
+ * global thread pool. Only items whose outline actually lies under the eraser
+ * are clipped: their outlines are indexed on a grid the first time the eraser
+ * comes close, and the index lives as long as the eraser gesture.
+ *
+ * In stroke mode, the eraser removes every stroke whose centreline it touches
+ * instead of clipping outlines, which is cheap enough to stay on the GUI thread.
+ * Strokes without a centreline of their own are tested against their outline.
+ *
+ * The results are applied by the scene, so that the erased and added items of
+ * a gesture end up in a single undo command.
+ */
+class UBEraserEngine : public QObject
+{
+    Q_OBJECT
+
+    public:
+
+        enum Mode
+        {
+            ClipMode = 0,
+            StrokeMode
+        };
+
+        UBEraserEngine(UBGraphicsScene* scene);
+        virtual ~UBEraserEngine();
+
+        void setMode(Mode mode);
+
+        void erase(const QPolygonF& eraserPolygon);
+        void finish();
+
+    private slots:
+
+        void flush();
+        void clipped();
+
+    private:
+
+        struct IndexedPolygon
+        {
+            QPolygonF polygon;
+            QRectF bounds;
+            // edges of the polygon by grid cell, empty for small polygons
+            QHash<quint64, QVector<int> > cells;
+        };
+
+        struct ClipJob
+        {
+            UBGraphicsPolygonItem* item;
+            QPolygonF polygon;
+            QTransform inverted;
+        };
+
+        struct ClipResult
+        {
+            UBGraphicsPolygonItem* item;
+            bool erased;
+            QList<QPolygonF> remains;
+        };
+
+        QList<ClipJob> jobsFor(const QList<QPolygonF>& eraserPolygons, const QRectF& eraserRect);
+        bool isUnderEraser(UBGraphicsPolygonItem* item, const QList<QPolygonF>& eraserPolygons, const QRectF& eraserRect);
+        const IndexedPolygon& indexedPolygon(UBGraphicsPolygonItem* item);
+        void apply(const QList<ClipResult>& results);
+
+        void eraseStrokes(const QList<QPolygonF>& eraserPolygons, const QRectF& eraserRect);
+        bool isStrokeUnderEraser(UBGraphicsPolygonItem* item, const QList<QPolygonF>& eraserPolygons, const QRectF& eraserRect);
+        bool isOutlineUnderEraser(UBGraphicsPolygonItem* item, const QList<QPolygonF>& eraserPolygons, const QRectF& eraserRect);
+        static bool isCentrelineUnderEraser(const QVector<QPair<QPointF, qreal> >& centreline, const QTransform& transform,
+                                            const QList<QPolygonF>& eraserPolygons, const QRectF& eraserRect);
+
+        static QPainterPath eraserPath(const QList<QPolygonF>& eraserPolygons);
+        static ClipResult clip(const ClipJob& job, const QPainterPath& eraserPath);
+
+        static const int sFrameInterval;
+        static const int sCellSize;
+        static const int sMinIndexedSize;
+
+        UBGraphicsScene* mScene;
+        Mode mMode;
+
+        QList<QPolygonF> mPendingPolygons;
+        QTimer mFrameTimer;
+
+        QFutureWatcher<ClipResult> mClipWatcher;
+        bool mClipping;
+
+        QHash<UBGraphicsPolygonItem*, IndexedPolygon> mIndex;
+};
+
+#endif // UBERASERENGINE_H
@@ -0,0 +1,217 @@
+/*
+ * Copyright (C) 2015-2022 Département de l'Instruction Publique (DIP-SEM)
+ *
+ * Copyright (C) 2013 Open Education Foundation
+ *
+ * Copyright (C) 2010-2013 Groupement d'Intérêt Public pour
+ * l'Education Numérique en Afrique (GIP ENA)
+ *
+ * This file is part of OpenBoard.
+ *
+ * OpenBoard is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3 of the License,
+ * with a specific linking exception for the OpenSSL project's
+ * "OpenSSL" library (or with modified versions of it that use the
+ * same license as the "OpenSSL" library).
+ *
+ * OpenBoard is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with OpenBoard. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+
+
+
+
+
+#include "UBGraphicsMarkerLayerItem.h"
+
+#include <QStyleOptionGraphicsItem>
+#include <QtMath>
+
+#include "domain/UBGraphicsPolygonItem.h"
+
+#include "core/memcheck.h"
+
+const int UBGraphicsMarkerLayerItem::sTileSize = 256;
+const int UBGraphicsMarkerLayerItem::sMaxScales = 3;
+
+static quint64 tileKey(int column, int row)
+{
+    return (quint64(quint32(column)) << 32) | quint32(row);
+}
+
+UBGraphicsMarkerLayerItem::UBGraphicsMarkerLayerItem(const QColor& color, QGraphicsItem* parent)
+    : QGraphicsItem(parent)
+    , mOpaqueColor(color)
+    , mOpacity(color.alphaF())
+{
+    mOpaqueColor.setAlphaF(1.0);
+
+    // paint only reads the tiles under the exposed rect
+    setFlag(QGraphicsItem::ItemUsesExtendedStyleOption, true);
+    setAcceptedMouseButtons(Qt::NoButton);
+}
+
+
+UBGraphicsMarkerLayerItem::~UBGraphicsMarkerLayerItem()
+{
+    qDeleteAll(mPolygonItems);
+}
+
+
+void UBGraphicsMarkerLayerItem::addPolygonItem(UBGraphicsPolygonItem* polygonItem)
+{
+    mPolygonItems << polygonItem;
+
+    const QPolygonF polygon = polygonItem->polygon();
+    const QRectF rect = polygon.boundingRect();
+
+    if (!mBounds.contains(rect))
+    {
+        prepareGeometryChange();
+        mBounds = mBounds.isNull() ? rect : mBounds.united(rect);
+    }
+
+    QMap<int, Tiles>::iterator it;
+
+    for (it = mTiles.begin(); it != mTiles.end(); ++it)
+        rasterize(it.value(), it.key() / 1000.0, polygon);
+
+    update(rect);
+}
+
+
+QList<UBGraphicsPolygonItem*> UBGraphicsMarkerLayerItem::takePolygonItems()
+{
+    QList<UBGraphicsPolygonItem*> polygonItems = mPolygonItems;
+
+    mPolygonItems.clear();
+    mTiles.clear();
+    update();
+
+    return polygonItems;
+}
+
+
+QRectF UBGraphicsMarkerLayerItem::boundingRect() const
+{
+    return mBounds;
+}
+
+
+void UBGraphicsMarkerLayerItem::paint(QPainter* painter, const QStyleOptionGraphicsItem* option, QWidget* widget)
+{
+    Q_UNUSED(widget);
+
+    const QTransform transform = painter->worldTransform();
+
+    painter->save();
+    painter->setCompositionMode(QPainter::CompositionMode_SourceOver);
+    painter->setOpacity(painter->opacity() * mOpacity);
+
+    if (transform.type() > QTransform::TxScale || transform.m11() != transform.m22())
+    {
+        // rotated or sheared views do not map tiles to pixels, draw the segments as one path
+        QPainterPath path;
+        path.setFillRule(Qt::WindingFill);
+
+        foreach (UBGraphicsPolygonItem* polygonItem, mPolygonItems)
+            path.addPolygon(polygonItem->polygon());
+
+        painter->setRenderHint(QPainter::Antialiasing);
+        painter->setPen(Qt::NoPen);
+        painter->setBrush(mOpaqueColor);
+        painter->drawPath(path);
+        painter->restore();
+        return;
+    }
+
+    const qreal scale = transform.m11();
+    const Tiles& tiles = tilesForScale(scale);
+
+    const QRectF exposed(option->exposedRect.topLeft() * scale, option->exposedRect.bottomRight() * scale);
+    const int firstColumn = qFloor(exposed.left() / sTileSize);
+    const int lastColumn = qFloor(exposed.right() / sTileSize);
+    const int firstRow = qFloor(exposed.top() / sTileSize);
+    const int lastRow = qFloor(exposed.bottom() / sTileSize);
+
+    // back to device pixels, so that tiles are drawn one to one
+    painter->scale(1 / scale, 1 / scale);
+
+    for (int row = firstRow; row <= lastRow; ++row)
+    {
+        for (int column = firstColumn; column <= lastColumn; ++column)
+        {
+            Tiles::const_iterator tile = tiles.constFind(tileKey(column, row));
+
+            if (tile != tiles.constEnd())
+                painter->drawImage(QPointF(column * sTileSize, row * sTileSize), tile.value());
+        }
+    }
+
+    painter->restore();
+}
+
+
+void UBGraphicsMarkerLayerItem::rasterize(Tiles& tiles, qreal scale, const QPolygonF& polygon) const
+{
+    // one extra pixel for the antialiased edges
+    const QRectF rect = polygon.boundingRect();
+    const QRectF deviceRect = QRectF(rect.topLeft() * scale, rect.bottomRight() * scale).adjusted(-1, -1, 1, 1);
+
+    const int firstColumn = qFloor(deviceRect.left() / sTileSize);
+    const int lastColumn = qFloor(deviceRect.right() / sTileSize);
+    const int firstRow = qFloor(deviceRect.top() / sTileSize);
+    const int lastRow = qFloor(deviceRect.bottom() / sTileSize);
+
+    for (int row = firstRow; row <= lastRow; ++row)
+    {
+        for (int column = firstColumn; column <= lastColumn; ++column)
+        {
+            QImage& tile = tiles[tileKey(column, row)];
+
+            if (tile.isNull())
+            {
+                tile = QImage(sTileSize, sTileSize, QImage::Format_ARGB32_Premultiplied);
+                tile.fill(Qt::transparent);
+            }
+
+            QPainter painter(&tile);
+            painter.setRenderHint(QPainter::Antialiasing);
+            painter.setPen(Qt::NoPen);
+            painter.setBrush(mOpaqueColor);
+            painter.translate(-column * sTileSize, -row * sTileSize);
+            painter.scale(scale, scale);
+            painter.drawPolygon(polygon, Qt::WindingFill);
+        }
+    }
+}
+
+
+UBGraphicsMarkerLayerItem::Tiles& UBGraphicsMarkerLayerItem::tilesForScale(qreal scale)
+{
+    const int key = qRound(scale * 1000);
+
+    QMap<int, Tiles>::iterator it = mTiles.find(key);
+
+    if (it != mTiles.end())
+        return it.value();
+
+    // a new view scale, typically after zooming: render the stroke so far once
+    while (mTiles.size() >= sMaxScales)
+        mTiles.erase(mTiles.begin());
+
+    Tiles& tiles = mTiles[key];
+
+    foreach (UBGraphicsPolygonItem* polygonItem, mPolygonItems)
+        rasterize(tiles, key / 1000.0, polygonItem->polygon());
+
+    return tiles;
+}
@@ -0,0 +1,86 @@
+/*
+ * Copyright (C) 2015-2022 Département de l'Instruction Publique (DIP-SEM)
+ *
+ * Copyright (C) 2013 Open Education Foundation
+ *
+ * Copyright (C) 2010-2013 Groupement d'Intérêt Public pour
+ * l'Education Numérique en Afrique (GIP ENA)
+ *
+ * This file is part of OpenBoard.
+ *
+ * OpenBoard is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3 of the License,
+ * with a specific linking exception for the OpenSSL project's
+ * "OpenSSL" library (or with modified versions of it that use the
+ * same license as the "OpenSSL" library).
+ *
+ * OpenBoard is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with OpenBoard. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+
+
+
+
+
+#ifndef UBGRAPHICSMARKERLAYERITEM_H
+#define UBGRAPHICSMARKERLAYERITEM_H
+
+#include <QtGui>
+#include <QGraphicsItem>
+
+class UBGraphicsPolygonItem;
+
+/**
+ * Layer showing a translucent marker stroke while it is drawn.
+ *
+ * Each segment is rasterised once, at full opacity, into device pixel tiles and the
+ * tiles are composited with the marker alpha when painted. Overlapping segments thus
+ * never darken each other and adding a segment costs the same however long the
+ * stroke is. The layer owns the segment polygons, which are not added to the scene.
+ */
+class UBGraphicsMarkerLayerItem : public QGraphicsItem
+{
+    public:
+
+        UBGraphicsMarkerLayerItem(const QColor& color, QGraphicsItem* parent = 0);
+        virtual ~UBGraphicsMarkerLayerItem();
+
+        void addPolygonItem(UBGraphicsPolygonItem* polygonItem);
+        QList<UBGraphicsPolygonItem*> takePolygonItems();
+
+        virtual QRectF boundingRect() const;
+
+    protected:
+
+        virtual void paint(QPainter* painter, const QStyleOptionGraphicsItem* option, QWidget* widget);
+
+    private:
+
+        // tiles by column and row, packed into one key
+        typedef QHash<quint64, QImage> Tiles;
+
+        void rasterize(Tiles& tiles, qreal scale, const QPolygonF& polygon) const;
+        Tiles& tilesForScale(qreal scale);
+
+        static const int sTileSize;
+        static const int sMaxScales;
+
+        QColor mOpaqueColor;
+        qreal mOpacity;
+
+        QList<UBGraphicsPolygonItem*> mPolygonItems;
+        QRectF mBounds;
+
+        // one set of tiles per device scale the layer is painted at, e.g. control and display views
+        QMap<int, Tiles> mTiles;
+};
+
+#endif // UBGRAPHICSMARKERLAYERITEM_H
@@ -126,6 +126,7 @@ void UBGraphicsPolygonItem::setStroke(UBGraphicsStroke* stroke)
 
         mStroke = stroke;
         mStroke->addPolygon(this);
+        markChanged();
     }
 }
 
@@ -141,6 +142,25 @@ void UBGraphicsPolygonItem::setColor(const QColor& pColor)
     setPen(Qt::NoPen);
 
     mHasAlpha = (pColor.alphaF() < 1.0);
+    markChanged();
+}
+
+
+QVariant UBGraphicsPolygonItem::itemChange(GraphicsItemChange change, const QVariant &value)
+{
+    switch (change)
+    {
+        case ItemZValueHasChanged:
+        case ItemVisibleHasChanged:
+        case ItemTransformHasChanged:
+        case ItemPositionHasChanged:
+            markChanged();
+            break;
+        default:
+            break;
+    }
+
+    return QGraphicsPolygonItem::itemChange(change, value);
 }
 
 
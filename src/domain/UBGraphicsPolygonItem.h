@@ -71,8 +71,7 @@ class UBGraphicsPolygonItem : public QGraphicsPolygonItem, public UBItem
 
                 if (polygon() != subtractedPolygon)
                 {
-                    mIsNominalLine = false;
-                    QGraphicsPolygonItem::setPolygon(subtractedPolygon);
+                    setPolygon(subtractedPolygon);
                 }
             }
         }
@@ -83,8 +82,7 @@ class UBGraphicsPolygonItem : public QGraphicsPolygonItem, public UBItem
 
             if (polygon() != subtractedPolygon)
             {
-                mIsNominalLine = false;
-                QGraphicsPolygonItem::setPolygon(subtractedPolygon);
+                setPolygon(subtractedPolygon);
             }
         }
 
@@ -95,10 +93,17 @@ class UBGraphicsPolygonItem : public QGraphicsPolygonItem, public UBItem
             return Type;
         }
 
-        void setPolygon(const QPolygonF pPolygon)
+        virtual void setPolygon(const QPolygonF pPolygon)
         {
             mIsNominalLine = false;
             QGraphicsPolygonItem::setPolygon(pPolygon);
+            markChanged();
+        }
+
+        // finished strokes (UBGraphicsStrokeItem) tessellate their outline on demand
+        virtual QPolygonF polygon() const
+        {
+            return QGraphicsPolygonItem::polygon();
         }
 
         virtual UBItem* deepCopy() const;
@@ -109,7 +114,7 @@ class UBGraphicsPolygonItem : public QGraphicsPolygonItem, public UBItem
         qreal originalWidth() { return mOriginalWidth;}
         bool isNominalLine() {return mIsNominalLine;}
 
-        void setNominalLine(bool isNominalLine) { mIsNominalLine = isNominalLine; }
+        void setNominalLine(bool isNominalLine) { mIsNominalLine = isNominalLine; markChanged(); }
 
         QColor colorOnDarkBackground() const
         {
@@ -119,6 +124,7 @@ class UBGraphicsPolygonItem : public QGraphicsPolygonItem, public UBItem
         void setColorOnDarkBackground(QColor pColorOnDarkBackground)
         {
             mColorOnDarkBackground = pColorOnDarkBackground;
+            markChanged();
         }
 
         QColor colorOnLightBackground() const
@@ -129,6 +135,7 @@ class UBGraphicsPolygonItem : public QGraphicsPolygonItem, public UBItem
         void setColorOnLightBackground(QColor pColorOnLightBackground)
         {
             mColorOnLightBackground = pColorOnLightBackground;
+            markChanged();
         }
 
         void setStroke(UBGraphicsStroke* stroke);
@@ -136,6 +143,16 @@ class UBGraphicsPolygonItem : public QGraphicsPolygonItem, public UBItem
 
     protected:
         void paint ( QPainter * painter, const QStyleOptionGraphicsItem * option, QWidget * widget);
+        virtual QVariant itemChange(GraphicsItemChange change, const QVariant &value);
+
+        // tells the strokes group that this stroke has to be saved again
+        void markChanged()
+        {
+            UBGraphicsStrokesGroup* group = qgraphicsitem_cast<UBGraphicsStrokesGroup*>(parentItem());
+
+            if (group)
+                group->markChanged();
+        }
 
 
     private:
@@ -66,6 +66,11 @@
 #include "UBGraphicsPixmapItem.h"
 #include "UBGraphicsSvgItem.h"
 #include "UBGraphicsPolygonItem.h"
+#include "UBGraphicsStrokeItem.h"
+#include "UBGraphicsMarkerLayerItem.h"
+#include "UBEraserEngine.h"
+#include "UBWetInkStroke.h"
+#include "UBBackgroundRenderer.h"
 #include "UBGraphicsMediaItem.h"
 #include "UBGraphicsWidgetItem.h"
 #include "UBGraphicsPDFItem.h"
@@ -322,6 +327,8 @@ UBGraphicsScene::UBGraphicsScene(std::shared_ptr<UBDocumentProxy> document, bool
     , mDocument(document)
     , mDarkBackground(false)
     , mPageBackground(UBPageBackground::plain)
+    , mSeyesRuledBackground(false)
+    , mBackgroundRenderer(new UBBackgroundRenderer)
     , mIsDesktopMode(false)
     , mZoomFactor(1)
     , mBackgroundObject(0)
@@ -338,10 +345,17 @@ UBGraphicsScene::UBGraphicsScene(std::shared_ptr<UBDocumentProxy> document, bool
     , mZLayerController(new UBZLayerController(this))
     , mpLastPolygon(NULL)
     , mTempPolygon(NULL)
+    , mMarkerLayer(NULL)
+    , mDrawIntoMarkerLayer(false)
+    , mWetInkStroke(NULL)
+    , mDrawWetInk(false)
     , mDrawWithCompass(false)
     , mCurrentPolygon(0)
     , mSelectionFrame(0)
     , mGraphicsCache(nullptr)
+    , mEraserEngine(new UBEraserEngine(this))
+    , mFragmentCache(std::make_shared<UBSvgFragmentCache>())
+    , mIsPersistenceCopy(false)
 {
     UBCoreGraphicsScene::setObjectName("BoardScene");
     setItemIndexMethod(BspTreeIndex);
@@ -362,6 +376,16 @@ UBGraphicsScene::UBGraphicsScene(std::shared_ptr<UBDocumentProxy> document, bool
 
     mBackgroundGridSize = UBSettings::settings()->crossSize;
     mIntermediateLines = UBSettings::settings()->intermediateLines;
+    readBackgroundSettings();
+
+    connect(UBSettings::settings()->boardCrossColorDarkBackground, &UBSetting::changed, this, [this](){
+        readBackgroundSettings();
+        updateBackground();
+    });
+    connect(UBSettings::settings()->boardCrossColorLightBackground, &UBSetting::changed, this, [this](){
+        readBackgroundSettings();
+        updateBackground();
+    });
 
 //    Just for debug. Do not delete please
 //    connect(this, SIGNAL(selectionChanged()), this, SLOT(selectionChangedProcessing()));
@@ -383,6 +407,9 @@ UBGraphicsScene::~UBGraphicsScene()
     if (mZLayerController)
         delete mZLayerController;
 
+    delete mWetInkStroke;
+    delete mBackgroundRenderer;
+
     if (mGraphicsCache)
     {
         delete mGraphicsCache;
@@ -433,6 +460,13 @@ bool UBGraphicsScene::inputDevicePress(const QPointF& scenePos, const qreal& pre
                 mCurrentStroke = NULL;
             }
 
+            // a previous stroke that was not released properly keeps its segments
+            if (mWetInkStroke)
+                removeWetInkStroke(true);
+
+            if (mMarkerLayer)
+                removeMarkerLayer(true);
+
             // hide the marker preview circle
             if (currentTool == UBStylusTool::Marker)
                 hideMarkerCircle();
@@ -461,6 +495,16 @@ bool UBGraphicsScene::inputDevicePress(const QPointF& scenePos, const qreal& pre
             mAddedItems.clear();
             mRemovedItems.clear();
 
+            // translucent marker segments go to a single layer until the stroke is finished
+            mDrawIntoMarkerLayer = currentTool == UBStylusTool::Marker
+                    && !UBDrawingController::drawingController()->activeRuler()
+                    && UBSettings::settings()->boardMarkerStrokeLayer->get().toBool();
+
+            // pen and marker strokes are painted by the views until the stroke is finished
+            mDrawWetInk = (currentTool == UBStylusTool::Pen || currentTool == UBStylusTool::Marker)
+                    && !UBDrawingController::drawingController()->activeRuler()
+                    && UBSettings::settings()->boardWetInk->get().toBool();
+
             if (UBDrawingController::drawingController()->activeRuler())
                 UBDrawingController::drawingController()->activeRuler()->StartLine(scenePos, width);
             else {
@@ -484,6 +528,9 @@ bool UBGraphicsScene::inputDevicePress(const QPointF& scenePos, const qreal& pre
             mRemovedItems.clear();
             moveTo(scenePos);
 
+            mEraserEngine->setMode(UBDrawingController::drawingController()->isWholeStrokeEraser()
+                                   ? UBEraserEngine::StrokeMode : UBEraserEngine::ClipMode);
+
             qreal eraserWidth = UBSettings::settings()->currentEraserWidth();
             eraserWidth /= UBApplication::boardController->systemScaleFactor();
             eraserWidth /= UBApplication::boardController->currentZoom();
@@ -663,8 +710,7 @@ bool UBGraphicsScene::inputDeviceMove(const QPointF& scenePos, const qreal& pres
                     // added to the stroke. (Or it is added to the stroke when we stop drawing)
 
                     if (mTempPolygon) {
-                        removeItem(mTempPolygon);
-                        mTempPolygon = NULL;
+                        removeTempPolygon();
                     }
 
                     if (!mCurrentStroke->points().empty())
@@ -672,7 +718,16 @@ bool UBGraphicsScene::inputDeviceMove(const QPointF& scenePos, const qreal& pres
                         QPointF lastDrawnPoint = mCurrentStroke->points().last().first;
 
                         mTempPolygon = lineToPolygonItem(QLineF(lastDrawnPoint, scenePos), mPreviousWidth, width);
-                        addItem(mTempPolygon);
+
+                        if (mWetInkStroke)
+                        {
+                            mWetInkStroke->setTempPolygon(mTempPolygon->polygon());
+                            updateWetInk(mTempPolygon->boundingRect());
+                        }
+                        else
+                        {
+                            addItem(mTempPolygon);
+                        }
                     }
                 }
             }
@@ -745,16 +800,45 @@ bool UBGraphicsScene::inputDeviceRelease(int tool, Qt::KeyboardModifiers modifie
             mDrawWithCompass = false;
         }
         else if (mCurrentStroke){
+            bool simplify = (currentTool == UBStylusTool::Pen && UBSettings::settings()->boardSimplifyPenStrokes->get().toBool())
+                    || (currentTool == UBStylusTool::Marker && UBSettings::settings()->boardSimplifyMarkerStrokes->get().toBool());
+
+            // pen and marker strokes carry their centreline, they are replaced by a single stroke item
+            bool consolidate = (currentTool == UBStylusTool::Pen || currentTool == UBStylusTool::Marker)
+                    && mCurrentStroke->points().size() > 1 && !mCurrentStroke->polygons().empty();
+
+            if (consolidate)
+            {
+                QList<QPair<QPointF, qreal> > points = simplify ? mCurrentStroke->simplifiedPoints() : mCurrentStroke->points();
+
+                if (mTempPolygon) {
+                    points << qMakePair(mTempPolygon->originalLine().p2(), mTempPolygon->originalWidth());
+                    removeTempPolygon();
+                }
+
+                consolidateCurrentStroke(QVector<QPair<QPointF, qreal> >(points.begin(), points.end()));
+            }
+
+            // the segments of the layer were either consolidated or are put back in the scene
+            if (mMarkerLayer)
+                removeMarkerLayer(!consolidate);
+
+            mDrawIntoMarkerLayer = false;
+
             if (mTempPolygon) {
                 UBGraphicsPolygonItem * poly = dynamic_cast<UBGraphicsPolygonItem*>(mTempPolygon->deepCopy());
-                removeItem(mTempPolygon);
-                mTempPolygon = NULL;
+                removeTempPolygon();
                 addPolygonItemToCurrentStroke(poly);
             }
 
+            // the segments of the wet ink were either consolidated or are put in the scene
+            if (mWetInkStroke)
+                removeWetInkStroke(!consolidate);
+
+            mDrawWetInk = false;
+
             // replace the stroke by a simplified version of it
-            if ((currentTool == UBStylusTool::Pen && UBSettings::settings()->boardSimplifyPenStrokes->get().toBool())
-                || (currentTool == UBStylusTool::Marker && UBSettings::settings()->boardSimplifyMarkerStrokes->get().toBool()))
+            if (simplify && !consolidate)
             {
                 simplifyCurrentStroke();
             }
@@ -785,6 +869,9 @@ bool UBGraphicsScene::inputDeviceRelease(int tool, Qt::KeyboardModifiers modifie
         }
     }
 
+    // the rest of the eraser motion belongs to this gesture
+    mEraserEngine->finish();
+
     if (mRemovedItems.size() > 0 || mAddedItems.size() > 0)
     {
         if (mUndoRedoStackEnabled) { //should be deleted after scene own undo stack implemented
@@ -1015,6 +1102,47 @@ void UBGraphicsScene::drawCurve(const QList<QPointF>& points, qreal startWidth,
 
 void UBGraphicsScene::addPolygonItemToCurrentStroke(UBGraphicsPolygonItem* polygonItem)
 {
+    if (mDrawWetInk)
+    {
+        // the segments are painted by the views, without going through the scene index
+        if (!mWetInkStroke)
+            mWetInkStroke = new UBWetInkStroke(polygonItem->brush().color());
+
+        mWetInkStroke->addPolygonItem(polygonItem);
+        updateWetInk(polygonItem->sceneBoundingRect());
+
+        if (!mCurrentStroke)
+            mCurrentStroke = new UBGraphicsStroke(shared_from_this());
+
+        polygonItem->setStroke(mCurrentStroke);
+
+        mpLastPolygon = polygonItem;
+        mPreviousPolygonItems.append(polygonItem);
+        return;
+    }
+
+    if (mDrawIntoMarkerLayer && !polygonItem->brush().isOpaque())
+    {
+        // the layer composites the segments itself, no need to subtract the previous ones
+        if (!mMarkerLayer)
+        {
+            mMarkerLayer = new UBGraphicsMarkerLayerItem(polygonItem->brush().color());
+            mMarkerLayer->setZValue(mZLayerController->generateZLevel(polygonItem));
+            UBCoreGraphicsScene::addItem(mMarkerLayer);
+        }
+
+        mMarkerLayer->addPolygonItem(polygonItem);
+
+        if (!mCurrentStroke)
+            mCurrentStroke = new UBGraphicsStroke(shared_from_this());
+
+        polygonItem->setStroke(mCurrentStroke);
+
+        mpLastPolygon = polygonItem;
+        mPreviousPolygonItems.append(polygonItem);
+        return;
+    }
+
     if (!polygonItem->brush().isOpaque())
     {
         // -------------------------------------------------------------------------------------
@@ -1046,94 +1174,11 @@ void UBGraphicsScene::eraseLineTo(const QPointF &pEndPoint, const qreal &pWidth)
     const QLineF line(mPreviousPoint, pEndPoint);
     mPreviousPoint = pEndPoint;
 
-    const QPolygonF eraserPolygon = UBGeometryUtils::lineToPolygon(line, pWidth);
-    const QRectF eraserBoundingRect = eraserPolygon.boundingRect();
-
-    QPainterPath eraserPath;
-    eraserPath.addPolygon(eraserPolygon);
-
-    // Get all the items that are intersecting with the eraser path, except the eraser itself
-    QList<QGraphicsItem*> collidItems = items(eraserBoundingRect, Qt::IntersectsItemBoundingRect);
-    collidItems.removeOne(mEraser);
-
-    QList<UBGraphicsPolygonItem*> intersectedItems;
-
-    typedef QList<QPolygonF> POLYGONSLIST;
-    QList<POLYGONSLIST> intersectedPolygons;
-
-    for(int i=0; i<collidItems.size(); i++)
-    {
-        UBGraphicsPolygonItem *pi = qgraphicsitem_cast<UBGraphicsPolygonItem*>(collidItems[i]);
-        if(pi == NULL)
-            continue;
-
-        QPainterPath itemPainterPath;
-        itemPainterPath.addPolygon(pi->sceneTransform().map(pi->polygon()));
+    // the clipping is batched per frame while the eraser is moved
+    mEraserEngine->erase(UBGeometryUtils::lineToPolygon(line, pWidth));
 
-        if (eraserPath.contains(itemPainterPath))
-        {
-            // Completely remove item
-            intersectedItems << pi;
-            intersectedPolygons << QList<QPolygonF>();
-        }
-        else if (eraserPath.intersects(itemPainterPath))
-        {
-            itemPainterPath.setFillRule(Qt::WindingFill);
-            // reverse eraserPath so that it has the opposite orientation of the stroke
-            // necessary for punching a hole with WindingFill rule
-            QPainterPath newPath = itemPainterPath.subtracted(eraserPath.toReversed());
-            intersectedItems << pi;
-            intersectedPolygons << newPath.simplified().toFillPolygons(pi->sceneTransform().inverted());
-        }
-    }
-
-    for(int i=0; i<intersectedItems.size(); i++)
-    {
-        // item which intersects with eraser
-        UBGraphicsPolygonItem *intersectedPolygonItem = intersectedItems[i];
-
-        if (!intersectedPolygons[i].empty())
-        {
-            // intersected polygons generated as QList<QPolygon> QPainterPath::toFillPolygons(),
-            // so each intersectedPolygonItem has one or couple of QPolygons who should be removed from it.
-            for(int j = 0; j < intersectedPolygons[i].size(); j++)
-            {
-                // create small polygon from couple of polygons to replace particular erased polygon
-                UBGraphicsPolygonItem* polygonItem = new UBGraphicsPolygonItem(intersectedPolygons[i][j], intersectedPolygonItem->parentItem());
-
-                intersectedPolygonItem->copyItemParameters(polygonItem);
-                polygonItem->setNominalLine(false);
-                polygonItem->setStroke(intersectedPolygonItem->stroke());
-                if (intersectedPolygonItem->strokesGroup())
-                {
-                    polygonItem->setStrokesGroup(intersectedPolygonItem->strokesGroup());
-                    intersectedPolygonItem->strokesGroup()->addToGroup(polygonItem);
-                }
-                mAddedItems << polygonItem;
-            }
-        }
-
-        //remove full polygon item and replace it by a couple of polygons which create the same stroke without the part that intersects with the eraser
-         mRemovedItems << intersectedPolygonItem;
-
-        QTransform t;
-        bool bApplyTransform = false;
-        if (intersectedPolygonItem->strokesGroup())
-        {
-            if (intersectedPolygonItem->strokesGroup()->parentItem())
-            {
-                bApplyTransform = true;
-                t = intersectedPolygonItem->sceneTransform();
-            }
-            intersectedPolygonItem->strokesGroup()->removeFromGroup(intersectedPolygonItem);
-        }
-        removeItem(intersectedPolygonItem);
-        if (bApplyTransform)
-            intersectedPolygonItem->setTransform(t);
-    }
-
-    if (!intersectedItems.empty())
-        setModified(true);
+    if (!mInputDeviceIsPressed)
+        mEraserEngine->finish();
 }
 
 void UBGraphicsScene::drawArcTo(const QPointF& pCenterPoint, qreal pSpanAngle)
@@ -1180,6 +1225,12 @@ void UBGraphicsScene::setBackground(bool pIsDark, UBPageBackground pBackground)
         needRepaint = true;
     }
 
+    if (mSeyesRuledBackground != UBSettings::settings()->isSeyesRuledBackground())
+    {
+        mSeyesRuledBackground = !mSeyesRuledBackground;
+        needRepaint = true;
+    }
+
     if (needRepaint)
     {
         updateBackground();
@@ -1408,6 +1459,16 @@ void UBGraphicsScene::leaveEvent(QEvent * event)
 }
 
 std::shared_ptr<UBGraphicsScene> UBGraphicsScene::sceneDeepCopy() const
+{
+    return deepCopyScene(false);
+}
+
+std::shared_ptr<UBGraphicsScene> UBGraphicsScene::scenePersistenceCopy() const
+{
+    return deepCopyScene(true);
+}
+
+std::shared_ptr<UBGraphicsScene> UBGraphicsScene::deepCopyScene(bool reuseFragments) const
 {
     std::shared_ptr<UBGraphicsScene> copy = std::make_shared<UBGraphicsScene>(this->document(), this->mUndoRedoStackEnabled);
 
@@ -1425,6 +1486,33 @@ std::shared_ptr<UBGraphicsScene> UBGraphicsScene::sceneDeepCopy() const
         // copy visible top-level items
         if (ubItem && item->isVisible() && !item->parentItem())
         {
+            UBGraphicsStrokesGroup* strokesGroup = qgraphicsitem_cast<UBGraphicsStrokesGroup*>(item);
+
+            if (reuseFragments && strokesGroup)
+            {
+                // write unchanged strokes from the fragment of the last save instead of copying them
+                QByteArray fingerprint = UBSvgFragmentCache::fingerprint(strokesGroup);
+                UBSvgFragmentCache::Fragment fragment = mFragmentCache->fragment(strokesGroup->uuid());
+                std::optional<qreal> zValue;
+
+                foreach (QGraphicsItem* child, strokesGroup->childItems())
+                {
+                    if (child->type() == UBGraphicsPolygonItem::Type)
+                    {
+                        qreal childZValue = child->data(UBGraphicsItemData::ItemOwnZValue).toReal();
+                        zValue = zValue ? qMin(*zValue, childZValue) : childZValue;
+                    }
+                }
+
+                if (zValue && fragment.fingerprint == fingerprint)
+                {
+                    copy->mReusedFragments << UBSvgFragmentCache::ReusedFragment{strokesGroup->uuid(), *zValue, fragment};
+                    continue;
+                }
+
+                copy->mFragmentFingerprints.insert(strokesGroup->uuid(), fingerprint);
+            }
+
             QGraphicsItem* cloneItem = nullptr;
             UBGraphicsGroupContainerItem* group = dynamic_cast<UBGraphicsGroupContainerItem*>(item);
 
@@ -1474,6 +1562,12 @@ std::shared_ptr<UBGraphicsScene> UBGraphicsScene::sceneDeepCopy() const
         }
     }
 
+    if (reuseFragments)
+    {
+        copy->mFragmentCache = mFragmentCache;
+        copy->mIsPersistenceCopy = true;
+    }
+
     // TODO UB 4.7 ... complete all members ?
 
     return copy;
@@ -2947,128 +3041,36 @@ void UBGraphicsScene::drawBackground(QPainter *painter, const QRectF &rect)
 
     if (mZoomFactor > 0.5)
     {
-        QColor bgCrossColor;
+        QColor bgCrossColor = darkBackground ? mCrossColorDarkBackground : mCrossColorLightBackground;
 
-        if (darkBackground)
-            bgCrossColor = QColor(UBSettings::settings()->boardCrossColorDarkBackground->get().toString());
-        else
-            bgCrossColor = QColor(UBSettings::settings()->boardCrossColorLightBackground->get().toString());
         if (mZoomFactor < 0.7)
         {
             int alpha = 255 * mZoomFactor / 2;
             bgCrossColor.setAlpha (alpha); // fade the crossing on small zooms
         }
 
-        qreal gridSize = backgroundGridSize();
-        painter->setPen (bgCrossColor);
-
-        if (mPageBackground == UBPageBackground::crossed)
-        {
-            qreal firstY = ((int) (rect.y () / gridSize)) * gridSize;
-
-            for (qreal yPos = firstY; yPos < rect.y () + rect.height (); yPos += gridSize)
-            {
-                painter->drawLine (rect.x (), yPos, rect.x () + rect.width (), yPos);
-            }
-
-            qreal firstX = ((int) (rect.x () / gridSize)) * gridSize;
-
-            for (qreal xPos = firstX; xPos < rect.x () + rect.width (); xPos += gridSize)
-            {
-                painter->drawLine (xPos, rect.y (), xPos, rect.y () + rect.height ());
-            }
+        UBBackgroundRenderer::Pattern pattern;
+        pattern.background = mPageBackground;
+        pattern.seyes = mSeyesRuledBackground;
+        pattern.intermediateLines = mIntermediateLines;
+        pattern.gridSize = backgroundGridSize();
+        pattern.color = bgCrossColor;
+        pattern.pageLeft = - mNominalSize.width() / 2.;
 
-            if (mIntermediateLines)
-            {
-                QColor intermediateColor = bgCrossColor;
-                intermediateColor.setAlphaF(0.5 * bgCrossColor.alphaF());
-                painter->setPen(intermediateColor);
-
-                for (qreal yPos = firstY - gridSize/2; yPos < rect.y () + rect.height (); yPos += gridSize)
-                {
-                    painter->drawLine (rect.x (), yPos, rect.x () + rect.width (), yPos);
-                }
-
-                for (qreal xPos = firstX - gridSize/2; xPos < rect.x () + rect.width (); xPos += gridSize)
-                {
-                    painter->drawLine (xPos, rect.y (), xPos, rect.y () + rect.height ());
-                }
-            }
-        }
-
-        else if (mPageBackground == UBPageBackground::ruled)
-        {
-            if(UBSettings::settings()->isSeyesRuledBackground())
-            {
-                qreal gridSizeSeyes = gridSize * 2; // The grid size must be bigger
-                int nbMarginCase = 1; // a small left margin of one gridSize
-
-                QPen seyesSquare ("#8e7cc3");
-                seyesSquare.setWidthF (2.);
-
-                QColor interlineColor("#6fa8dc");
-                interlineColor.setAlphaF(0.6);
-                QPen interlinePen(interlineColor);
-                interlinePen.setWidthF(2.);
-
-                QPen redLineMargin(QColor("red"));
-                redLineMargin.setWidthF(2.);
-
-                // Horizontal lines
-
-                qreal firstY = ((int) (rect.y () / gridSizeSeyes)) * gridSizeSeyes;
-
-                for (qreal yPos = firstY; yPos < rect.y () + rect.height (); yPos += gridSizeSeyes)
-                {
-                    painter->setPen (seyesSquare);
-                    painter->drawLine (rect.x (), yPos, rect.x () + rect.width (), yPos);
-                    painter->setPen (interlinePen);
-                    painter->drawLine (rect.x (), yPos+gridSizeSeyes/4, rect.x () + rect.width (), yPos+gridSizeSeyes/4);
-                    painter->drawLine (rect.x (), yPos+2*gridSizeSeyes/4, rect.x () + rect.width (), yPos+2*gridSizeSeyes/4);
-                    painter->drawLine (rect.x (), yPos+3*gridSizeSeyes/4, rect.x () + rect.width (), yPos+3*gridSizeSeyes/4);
-                }
-
-                // Vertical margin
-
-                qreal firstX = ((int) nbMarginCase * gridSizeSeyes) - mNominalSize.width() / 2.;
-
-                painter->setPen(redLineMargin);
-                painter->drawLine (firstX, rect.y (), firstX, rect.y () + rect.height ());
-
-                // Vertical lines
-
-                firstX = ((int) (nbMarginCase + 1) * gridSizeSeyes) - mNominalSize.width() / 2.;
-
-                painter->setPen (seyesSquare);
-                for (qreal xPos = firstX; xPos < rect.x () + rect.width (); xPos += gridSizeSeyes)
-                {
-                    painter->drawLine (xPos, rect.y (), xPos, rect.y () + rect.height ());
-                }
-            }
-            else
-            {
-                qreal firstY = ((int) (rect.y () / backgroundGridSize())) * backgroundGridSize();
-
-                for (qreal yPos = firstY; yPos < rect.y () + rect.height (); yPos += backgroundGridSize())
-                {
-                    painter->drawLine (rect.x (), yPos, rect.x () + rect.width (), yPos);
-                }
-
-                if (mIntermediateLines) {
-                    QColor intermediateColor = bgCrossColor;
-                    intermediateColor.setAlphaF(0.5 * bgCrossColor.alphaF());
-                    painter->setPen(intermediateColor);
-
-                    for (qreal yPos = firstY - gridSize/2; yPos < rect.y () + rect.height (); yPos += gridSize)
-                    {
-                        painter->drawLine (rect.x (), yPos, rect.x () + rect.width (), yPos);
-                    }
-                }
-            }
-        }
+        mBackgroundRenderer->draw(painter, pattern, rect);
     }
 }
 
+/**
+ * @brief Read the background settings used on every paint, so that they are not looked up each time
+ */
+void UBGraphicsScene::readBackgroundSettings()
+{
+    mCrossColorDarkBackground = QColor(UBSettings::settings()->boardCrossColorDarkBackground->get().toString());
+    mCrossColorLightBackground = QColor(UBSettings::settings()->boardCrossColorLightBackground->get().toString());
+    mSeyesRuledBackground = UBSettings::settings()->isSeyesRuledBackground();
+}
+
 void UBGraphicsScene::keyReleaseEvent(QKeyEvent * keyEvent)
 {
     // let's propagate the event through the scene's children to
@@ -3161,6 +3163,159 @@ void UBGraphicsScene::simplifyCurrentStroke()
 
 }
 
+/**
+ * @brief Replace the polygons of the current stroke by a single stroke item built from its centreline
+ */
+void UBGraphicsScene::consolidateCurrentStroke(const QVector<QPair<QPointF, qreal> >& centreline)
+{
+    UBGraphicsPolygonItem* firstPolygon = mCurrentStroke->polygons().first();
+
+    UBGraphicsStrokeItem* strokeItem = new UBGraphicsStrokeItem(centreline);
+    firstPolygon->copyItemParameters(strokeItem);
+    strokeItem->setNominalLine(false);
+    strokeItem->setFillRule(Qt::WindingFill);
+
+    QList<UBGraphicsPolygonItem*> polygons = mCurrentStroke->polygons();
+
+    mCurrentStroke = new UBGraphicsStroke(shared_from_this());
+    strokeItem->setStroke(mCurrentStroke);
+
+    // the segments are not needed anymore, the last one deletes the previous stroke
+    foreach(UBGraphicsPolygonItem* poly, polygons){
+        mPreviousPolygonItems.removeAll(poly);
+        mAddedItems.remove(poly);
+
+        // segments held by the marker layer are deleted with it
+        if (poly->scene() == this)
+        {
+            removeItem(poly);
+            UBCoreGraphicsScene::deleteItem(poly);
+        }
+    }
+
+    addItem(strokeItem);
+    mAddedItems.insert(strokeItem);
+    mpLastPolygon = NULL;
+}
+
+/**
+ * @brief Remove the marker layer of the stroke being drawn
+ * @param keepPolygons if true, the segments of the layer are added to the scene, otherwise they are deleted with the layer
+ */
+void UBGraphicsScene::removeMarkerLayer(bool keepPolygons)
+{
+    if (keepPolygons)
+    {
+        foreach(UBGraphicsPolygonItem* poly, mMarkerLayer->takePolygonItems()){
+            addItem(poly);
+            mAddedItems.insert(poly);
+        }
+    }
+
+    UBCoreGraphicsScene::removeItem(mMarkerLayer);
+    UBCoreGraphicsScene::deleteItem(mMarkerLayer);
+
+    mMarkerLayer = NULL;
+}
+
+/**
+ * @brief Remove the wet ink stroke, once the stroke being drawn is finished
+ * @param keepPolygons if true, the segments of the stroke are added to the scene, otherwise they are deleted with it
+ */
+void UBGraphicsScene::removeWetInkStroke(bool keepPolygons)
+{
+    const QRectF bounds = mWetInkStroke->boundingRect();
+
+    if (keepPolygons)
+    {
+        foreach(UBGraphicsPolygonItem* poly, mWetInkStroke->takePolygonItems()){
+            addItem(poly);
+            mAddedItems.insert(poly);
+        }
+    }
+
+    delete mWetInkStroke;
+    mWetInkStroke = NULL;
+
+    updateWetInk(bounds);
+}
+
+void UBGraphicsScene::removeTempPolygon()
+{
+    if (mTempPolygon->scene() == this)
+    {
+        removeItem(mTempPolygon);
+    }
+    else
+    {
+        // only shown as wet ink
+        if (mWetInkStroke)
+        {
+            mWetInkStroke->setTempPolygon(QPolygonF());
+            updateWetInk(mTempPolygon->boundingRect());
+        }
+
+        delete mTempPolygon;
+    }
+
+    mTempPolygon = NULL;
+}
+
+/**
+ * @brief Repaint the wet ink in the given scene area, straight on the viewports of the views
+ */
+void UBGraphicsScene::updateWetInk(const QRectF& sceneRect)
+{
+    foreach(QGraphicsView* view, views())
+        view->viewport()->update(view->mapFromScene(sceneRect).boundingRect().adjusted(-2, -2, 2, 2));
+}
+
+/**
+ * @brief Replace a polygon item touched by the eraser by the polygons that remain of it
+ * @param erasedItem the item to remove from the scene
+ * @param remains the remaining polygons, in item coordinates; empty if the item was erased completely
+ */
+void UBGraphicsScene::replaceErasedPolygonItem(UBGraphicsPolygonItem* erasedItem, const QList<QPolygonF>& remains)
+{
+    // intersected polygons generated as QList<QPolygon> QPainterPath::toFillPolygons(),
+    // so each erased item has one or couple of QPolygons who should be removed from it.
+    foreach(const QPolygonF& remain, remains)
+    {
+        // create small polygon from couple of polygons to replace particular erased polygon
+        UBGraphicsPolygonItem* polygonItem = new UBGraphicsPolygonItem(remain, erasedItem->parentItem());
+
+        erasedItem->copyItemParameters(polygonItem);
+        polygonItem->setNominalLine(false);
+        polygonItem->setStroke(erasedItem->stroke());
+        if (erasedItem->strokesGroup())
+        {
+            polygonItem->setStrokesGroup(erasedItem->strokesGroup());
+            erasedItem->strokesGroup()->addToGroup(polygonItem);
+        }
+        mAddedItems << polygonItem;
+    }
+
+    //remove full polygon item and replace it by a couple of polygons which create the same stroke without the part that intersects with the eraser
+    mRemovedItems << erasedItem;
+
+    QTransform t;
+    bool bApplyTransform = false;
+    if (erasedItem->strokesGroup())
+    {
+        if (erasedItem->strokesGroup()->parentItem())
+        {
+            bApplyTransform = true;
+            t = erasedItem->sceneTransform();
+        }
+        erasedItem->strokesGroup()->removeFromGroup(erasedItem);
+    }
+    removeItem(erasedItem);
+    if (bApplyTransform)
+        erasedItem->setTransform(t);
+
+    setModified(true);
+}
+
 void UBGraphicsScene::setDocumentUpdated()
 {
     if (document())
@@ -37,6 +37,8 @@
 
 #include "UBItem.h"
 
+#include "adaptors/UBSvgFragmentCache.h"
+
 class UBGraphicsPixmapItem;
 class UBGraphicsSvgItem;
 class UBGraphicsPolygonItem;
@@ -53,6 +55,10 @@ class UBGraphicsCompass;
 class UBDocumentProxy;
 class UBGraphicsCurtainItem;
 class UBGraphicsStroke;
+class UBGraphicsMarkerLayerItem;
+class UBEraserEngine;
+class UBWetInkStroke;
+class UBBackgroundRenderer;
 class UBMagnifierParams;
 class UBMagnifier;
 class UBGraphicsCache;
@@ -113,6 +119,8 @@ class UBGraphicsScene: public UBCoreGraphicsScene, public UBItem, public std::en
 {
     Q_OBJECT
 
+    friend class UBEraserEngine;
+
     public:
 
     enum clearCase {
@@ -136,6 +144,29 @@ class UBGraphicsScene: public UBCoreGraphicsScene, public UBItem, public std::en
 
         std::shared_ptr<UBGraphicsScene> sceneDeepCopy() const;
 
+        // copy for the persistence worker, strokes unchanged since the last save are not copied
+        std::shared_ptr<UBGraphicsScene> scenePersistenceCopy() const;
+
+        bool isPersistenceCopy() const
+        {
+            return mIsPersistenceCopy;
+        }
+
+        std::shared_ptr<UBSvgFragmentCache> fragmentCache() const
+        {
+            return mFragmentCache;
+        }
+
+        const QList<UBSvgFragmentCache::ReusedFragment>& reusedFragments() const
+        {
+            return mReusedFragments;
+        }
+
+        QByteArray fragmentFingerprint(const QUuid& uuid) const
+        {
+            return mFragmentFingerprints.value(uuid);
+        }
+
         void clearContent(clearCase pCase = clearItemsAndAnnotations);
         void saveWidgetSnapshots();
 
@@ -249,6 +280,11 @@ class UBGraphicsScene: public UBCoreGraphicsScene, public UBItem, public std::en
         void addCache();
         UBGraphicsCache* graphicsCache();
 
+        const UBWetInkStroke* wetInkStroke() const
+        {
+            return mWetInkStroke;
+        }
+
         bool isSnapping() const;
         QPointF snap(const QPointF& point, double* force = nullptr, std::optional<QPointF> proposedPoint = {}, QPointF* gridSnapPoint = nullptr) const;
         QPointF snap(const std::vector<QPointF>& corners, int* snapIndex = nullptr) const;
@@ -440,6 +476,7 @@ signals:
 
 
     private:
+        std::shared_ptr<UBGraphicsScene> deepCopyScene(bool reuseFragments) const;
         void setDocumentUpdated();
         void updateBackground();
         void createEraiser();
@@ -451,6 +488,13 @@ signals:
         void updatePenCircleColor();
         bool hasTextItemWithFocus(UBGraphicsGroupContainerItem* item);
         void simplifyCurrentStroke();
+        void consolidateCurrentStroke(const QVector<QPair<QPointF, qreal> >& centreline);
+        void removeMarkerLayer(bool keepPolygons);
+        void removeWetInkStroke(bool keepPolygons);
+        void removeTempPolygon();
+        void updateWetInk(const QRectF& sceneRect);
+        void readBackgroundSettings();
+        void replaceErasedPolygonItem(UBGraphicsPolygonItem* erasedItem, const QList<QPolygonF>& remains);
 
         QGraphicsEllipseItem* mEraser;
         QGraphicsEllipseItem* mPointer; // "laser" pointer
@@ -466,6 +510,10 @@ signals:
         UBPageBackground mPageBackground;
         int mBackgroundGridSize;
         bool mIntermediateLines;
+        bool mSeyesRuledBackground;
+        QColor mCrossColorDarkBackground;
+        QColor mCrossColorLightBackground;
+        UBBackgroundRenderer* mBackgroundRenderer;
 
         bool mIsDesktopMode;
         qreal mZoomFactor;
@@ -505,12 +553,22 @@ signals:
         UBZLayerController *mZLayerController;
         UBGraphicsPolygonItem* mpLastPolygon;
         UBGraphicsPolygonItem* mTempPolygon;
+        UBGraphicsMarkerLayerItem* mMarkerLayer;
+        bool mDrawIntoMarkerLayer;
+        UBWetInkStroke* mWetInkStroke;
+        bool mDrawWetInk;
 
         bool mDrawWithCompass;
         UBGraphicsPolygonItem *mCurrentPolygon;
         UBSelectionFrame *mSelectionFrame;
 
         UBGraphicsCache* mGraphicsCache;
+        UBEraserEngine* mEraserEngine;
+
+        std::shared_ptr<UBSvgFragmentCache> mFragmentCache;
+        bool mIsPersistenceCopy;
+        QList<UBSvgFragmentCache::ReusedFragment> mReusedFragments;
+        QHash<QUuid, QByteArray> mFragmentFingerprints;
 };
 
 
@@ -198,19 +198,15 @@ void UBGraphicsStroke::clear()
 }
 
 /**
- * @brief Return a simplified version of the stroke, with less points and polygons.
+ * @brief Return the drawn points of the stroke, without the points that are aligned with their neighbours.
  *
  */
-UBGraphicsStroke* UBGraphicsStroke::simplify()
+QList<QPair<QPointF, qreal> > UBGraphicsStroke::simplifiedPoints() const
 {
-    if (mDrawnPoints.size() < 3)
-        return NULL;
-
-    UBGraphicsStroke* newStroke = new UBGraphicsStroke();
-    newStroke->mDrawnPoints = QList<strokePoint>(mDrawnPoints);
+    QList<strokePoint> points(mDrawnPoints);
 
-    QList<strokePoint>& points = newStroke->mDrawnPoints;
-    //qDebug() << "Simplifying. Before: " << points.size() << " points and " << polygons().size() << " polygons";
+    if (points.size() < 3)
+        return points;
 
     /* Basic simplifying algorithm: consider A, B and C the current point and the two following ones.
      * If the angle between (AB) and (BC) is lower than a certain threshold,
@@ -233,7 +229,6 @@ UBGraphicsStroke* UBGraphicsStroke::simplify()
     qreal thresholdWidthDifference = UBSettings::settings()->boardSimplifyPenStrokesThresholdWidthDifference->get().toReal();
 
     QList<strokePoint>::iterator it = points.begin();
-    QList<QList<strokePoint>::iterator> toDelete;
 
     while (it+2 != points.end()) {
         // it, b_it and (b_it+1) correspond to A, B and C respectively
@@ -255,6 +250,24 @@ UBGraphicsStroke* UBGraphicsStroke::simplify()
             it = b_it;
     }
 
+    return points;
+}
+
+/**
+ * @brief Return a simplified version of the stroke, with less points and polygons.
+ *
+ */
+UBGraphicsStroke* UBGraphicsStroke::simplify()
+{
+    if (mDrawnPoints.size() < 3)
+        return NULL;
+
+    UBGraphicsStroke* newStroke = new UBGraphicsStroke();
+    newStroke->mDrawnPoints = simplifiedPoints();
+
+    QList<strokePoint>& points = newStroke->mDrawnPoints;
+    //qDebug() << "Simplifying. Before: " << points.size() << " points and " << polygons().size() << " polygons";
+
     // Next, we iterate over the new points to build the polygons that make up the stroke.
     // A new polygon is created every time drawCurve is true.
 
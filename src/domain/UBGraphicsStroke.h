@@ -63,6 +63,7 @@ class UBGraphicsStroke
 
         const QList<QPair<QPointF, qreal> >& points() { return mDrawnPoints; }
 
+        QList<QPair<QPointF, qreal> > simplifiedPoints() const;
         UBGraphicsStroke* simplify();
 
     protected:
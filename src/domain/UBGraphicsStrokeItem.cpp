@@ -0,0 +1,231 @@
+/*
+ * Copyright (C) 2015-2022 Département de l'Instruction Publique (DIP-SEM)
+ *
+ * Copyright (C) 2013 Open Education Foundation
+ *
+ * Copyright (C) 2010-2013 Groupement d'Intérêt Public pour
+ * l'Education Numérique en Afrique (GIP ENA)
+ *
+ * This file is part of OpenBoard.
+ *
+ * OpenBoard is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3 of the License,
+ * with a specific linking exception for the OpenSSL project's
+ * "OpenSSL" library (or with modified versions of it that use the
+ * same license as the "OpenSSL" library).
+ *
+ * OpenBoard is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with OpenBoard. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+
+
+
+
+
+#include "UBGraphicsStrokeItem.h"
+
+#include "frameworks/UBGeometryUtils.h"
+#include "domain/UBGraphicsScene.h"
+
+#include "core/memcheck.h"
+
+UBGraphicsStrokeItem::UBGraphicsStrokeItem(const QVector<QPair<QPointF, qreal> >& centreline, QGraphicsItem * parent)
+    : UBGraphicsPolygonItem(parent)
+    , mMaxWidth(0)
+    , mIsTessellated(false)
+{
+    mCentreline.reserve(centreline.size());
+
+    qreal left = 0, top = 0, right = 0, bottom = 0;
+
+    for (int i = 0; i < centreline.size(); ++i)
+    {
+        const QPointF& point = centreline.at(i).first;
+
+        // consecutive duplicates add nothing to the outline and would break the normals
+        if (!mCentreline.isEmpty() && mCentreline.last().first == point)
+        {
+            mCentreline.last().second = qMax(mCentreline.last().second, centreline.at(i).second);
+            continue;
+        }
+
+        if (mCentreline.isEmpty())
+        {
+            left = right = point.x();
+            top = bottom = point.y();
+        }
+        else
+        {
+            left = qMin(left, point.x());
+            right = qMax(right, point.x());
+            top = qMin(top, point.y());
+            bottom = qMax(bottom, point.y());
+        }
+
+        mCentreline.append(centreline.at(i));
+        mMaxWidth = qMax(mMaxWidth, centreline.at(i).second);
+    }
+
+    // the outline never goes further than half the width from the centreline
+    const qreal margin = mMaxWidth / 2.0;
+    mBounds = QRectF(QPointF(left, top), QPointF(right, bottom)).adjusted(-margin, -margin, margin, margin);
+
+    setFillRule(Qt::WindingFill);
+}
+
+
+bool UBGraphicsStrokeItem::hasConstantWidth() const
+{
+    for (int i = 1; i < mCentreline.size(); ++i)
+    {
+        if (mCentreline.at(i).second != mCentreline.at(0).second)
+            return false;
+    }
+
+    return true;
+}
+
+
+QPolygonF UBGraphicsStrokeItem::polygon() const
+{
+    if (!mIsTessellated)
+        tessellate();
+
+    return mOutline;
+}
+
+
+void UBGraphicsStrokeItem::setPolygon(const QPolygonF pPolygon)
+{
+    prepareGeometryChange();
+
+    mCentreline.clear();
+    mOutline = pPolygon;
+    mIsTessellated = true;
+    mBounds = pPolygon.boundingRect();
+
+    // keep the polygon of the base class in sync for its own users
+    UBGraphicsPolygonItem::setPolygon(pPolygon);
+}
+
+
+QRectF UBGraphicsStrokeItem::boundingRect() const
+{
+    return mBounds;
+}
+
+
+QPainterPath UBGraphicsStrokeItem::shape() const
+{
+    QPainterPath path;
+    path.setFillRule(Qt::WindingFill);
+    path.addPolygon(polygon());
+
+    return path;
+}
+
+
+bool UBGraphicsStrokeItem::contains(const QPointF& point) const
+{
+    return mBounds.contains(point) && polygon().containsPoint(point, Qt::WindingFill);
+}
+
+
+UBItem* UBGraphicsStrokeItem::deepCopy() const
+{
+    UBGraphicsStrokeItem* copy = new UBGraphicsStrokeItem(mCentreline, 0);
+    copyItemParameters(copy);
+
+    if (hasCentreline())
+    {
+        copy->mOutline = mOutline;
+        copy->mIsTessellated = mIsTessellated;
+    }
+    else
+    {
+        copy->setPolygon(mOutline);
+    }
+
+    return copy;
+}
+
+
+void UBGraphicsStrokeItem::paint(QPainter * painter, const QStyleOptionGraphicsItem * option, QWidget * widget)
+{
+    Q_UNUSED(option);
+    Q_UNUSED(widget);
+
+    if (color().alphaF() < 1.0 && scene() && scene()->isLightBackground())
+        painter->setCompositionMode(QPainter::CompositionMode_SourceOver);
+
+    painter->setRenderHints(QPainter::Antialiasing);
+    painter->setPen(pen());
+    painter->setBrush(brush());
+    painter->drawPolygon(polygon(), Qt::WindingFill);
+}
+
+
+/**
+ * @brief Build the outline of the stroke
+ *
+ * The centreline is split where it turns sharply, as a single outline would fold over
+ * itself there. The pieces are closed one after the other into the same polygon and
+ * the walk back over their first points encloses no area, so the whole stroke is
+ * filled in one pass and a translucent stroke does not darken where pieces overlap.
+ */
+void UBGraphicsStrokeItem::tessellate() const
+{
+    const int count = mCentreline.size();
+
+    QList<QPair<QPointF, qreal> > piece;
+    QList<QPointF> pieceStarts;
+
+    mOutline.clear();
+
+    auto closePiece = [&]()
+    {
+        const QPolygonF polygon = UBGeometryUtils::curveToPolygon(piece, true, true);
+
+        if (polygon.isEmpty())
+            return;
+
+        pieceStarts << polygon.first();
+        mOutline << polygon;
+
+        if (polygon.last() != polygon.first())
+            mOutline << polygon.first();
+    };
+
+    for (int i = 0; i < count; ++i)
+    {
+        piece << mCentreline.at(i);
+
+        if (piece.size() > 1 && i < count - 1)
+        {
+            qreal angle = qFabs(UBGeometryUtils::angle(mCentreline.at(i - 1).first, mCentreline.at(i).first, mCentreline.at(i + 1).first));
+
+            if (angle < 150) // same threshold as UBGraphicsStroke::simplify
+            {
+                closePiece();
+                piece.clear();
+                piece << mCentreline.at(i);
+            }
+        }
+    }
+
+    if (!piece.isEmpty())
+        closePiece();
+
+    for (int i = pieceStarts.size() - 2; i >= 0; --i)
+        mOutline << pieceStarts.at(i);
+
+    mIsTessellated = true;
+}
@@ -0,0 +1,89 @@
+/*
+ * Copyright (C) 2015-2022 Département de l'Instruction Publique (DIP-SEM)
+ *
+ * Copyright (C) 2013 Open Education Foundation
+ *
+ * Copyright (C) 2010-2013 Groupement d'Intérêt Public pour
+ * l'Education Numérique en Afrique (GIP ENA)
+ *
+ * This file is part of OpenBoard.
+ *
+ * OpenBoard is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3 of the License,
+ * with a specific linking exception for the OpenSSL project's
+ * "OpenSSL" library (or with modified versions of it that use the
+ * same license as the "OpenSSL" library).
+ *
+ * OpenBoard is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with OpenBoard. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+
+
+
+
+
+#ifndef UBGRAPHICSSTROKEITEM_H
+#define UBGRAPHICSSTROKEITEM_H
+
+#include <QtGui>
+
+#include "UBGraphicsPolygonItem.h"
+
+/**
+ * A finished pen or marker stroke held as a single item.
+ *
+ * The centreline points and their widths are kept in one array; the outline is
+ * only tessellated when it is first painted, hit-tested or asked for through
+ * polygon(). The item keeps the polygon item type so that the eraser, the
+ * undo stack and the strokes group treat it like any other polygon.
+ *
+ * Setting a polygon, e.g. through subtract(), replaces the outline. The
+ * centreline no longer describes the item then and is dropped, so the item is
+ * saved and erased like a plain polygon from that point on.
+ */
+class UBGraphicsStrokeItem : public UBGraphicsPolygonItem
+{
+    public:
+
+        UBGraphicsStrokeItem(const QVector<QPair<QPointF, qreal> >& centreline, QGraphicsItem * parent = 0);
+
+        const QVector<QPair<QPointF, qreal> >& centreline() const { return mCentreline; }
+        bool hasCentreline() const { return !mCentreline.isEmpty(); }
+
+        qreal maxWidth() const { return mMaxWidth; }
+        bool hasConstantWidth() const;
+
+        virtual QPolygonF polygon() const;
+        virtual void setPolygon(const QPolygonF pPolygon);
+
+        virtual QRectF boundingRect() const;
+        virtual QPainterPath shape() const;
+        virtual bool contains(const QPointF& point) const;
+
+        virtual UBItem* deepCopy() const;
+
+    protected:
+
+        void paint(QPainter * painter, const QStyleOptionGraphicsItem * option, QWidget * widget);
+
+    private:
+
+        void tessellate() const;
+
+        QVector<QPair<QPointF, qreal> > mCentreline;
+        QRectF mBounds;
+        qreal mMaxWidth;
+
+        mutable QPolygonF mOutline;
+        mutable bool mIsTessellated;
+};
+
+#endif // UBGRAPHICSSTROKEITEM_H
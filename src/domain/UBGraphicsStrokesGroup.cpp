@@ -34,11 +34,14 @@
 
 #include "core/memcheck.h"
 
+quint64 UBGraphicsStrokesGroup::sLastRevision = 0;
+
 UBGraphicsStrokesGroup::UBGraphicsStrokesGroup(QGraphicsItem *parent)
     : QGraphicsItemGroup(parent)
     , UBGraphicsItem()
     , debugTextEnabled(false) // set to true to get a graphical display of strokes' Z-levels
     , mDebugText(nullptr)
+    , mRevision(++sLastRevision)
 {
     setDelegate(new UBGraphicsItemDelegate(this, 0, GF_COMMON
                                            | GF_RESPECT_RATIO
@@ -64,6 +67,11 @@ void UBGraphicsStrokesGroup::setUuid(const QUuid &pUuid)
     setData(UBGraphicsItemData::ItemUuid, QVariant(pUuid)); //store item uuid inside the QGraphicsItem to fast operations with Items on the scene
 }
 
+void UBGraphicsStrokesGroup::markChanged()
+{
+    mRevision = ++sLastRevision;
+}
+
 void UBGraphicsStrokesGroup::setColor(const QColor &color, colorType pColorType)
 {
     //TODO Implement common mechanism of managing groups, drop UBGraphicsStroke if it's obsolete
@@ -245,6 +253,20 @@ QVariant UBGraphicsStrokesGroup::itemChange(GraphicsItemChange change, const QVa
         }
     }
 
+    switch (change)
+    {
+        case ItemChildAddedChange:
+        case ItemChildRemovedChange:
+        case ItemZValueHasChanged:
+        case ItemVisibleHasChanged:
+        case ItemTransformHasChanged:
+        case ItemPositionHasChanged:
+            markChanged();
+            break;
+        default:
+            break;
+    }
+
     QVariant newValue = Delegate()->itemChange(change, value);
     return QGraphicsItemGroup::itemChange(change, newValue);
 }
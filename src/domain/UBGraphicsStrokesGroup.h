@@ -58,6 +58,11 @@ public:
     void setColor(const QColor &color, colorType pColorType = currentColor);
     QColor color(colorType pColorType = currentColor) const;
 
+    // changes whenever the group or one of its strokes is modified, unique among all groups,
+    // so that saving a page only copies the groups modified since the last save
+    quint64 revision() const { return mRevision; }
+    void markChanged();
+
 protected:
 
     virtual QPainterPath shape () const;
@@ -71,6 +76,11 @@ protected:
     // Graphical display of stroke Z-level
     bool debugTextEnabled;
     QGraphicsSimpleTextItem * mDebugText;
+
+private:
+    // only used on the GUI thread
+    static quint64 sLastRevision;
+    quint64 mRevision;
 };
 
 #endif // UBGRAPHICSSTROKESGROUP_H
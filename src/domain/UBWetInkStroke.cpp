@@ -0,0 +1,82 @@
+/*
+ * Copyright (C) 2015-2022 Département de l'Instruction Publique (DIP-SEM)
+ *
+ * Copyright (C) 2013 Open Education Foundation
+ *
+ * Copyright (C) 2010-2013 Groupement d'Intérêt Public pour
+ * l'Education Numérique en Afrique (GIP ENA)
+ *
+ * This file is part of OpenBoard.
+ *
+ * OpenBoard is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3 of the License,
+ * with a specific linking exception for the OpenSSL project's
+ * "OpenSSL" library (or with modified versions of it that use the
+ * same license as the "OpenSSL" library).
+ *
+ * OpenBoard is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with OpenBoard. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+
+
+
+
+
+#include "UBWetInkStroke.h"
+
+#include "domain/UBGraphicsPolygonItem.h"
+
+#include "core/memcheck.h"
+
+UBWetInkStroke::UBWetInkStroke(const QColor& color)
+    : mOpaqueColor(color)
+    , mOpacity(color.alphaF())
+{
+    static QAtomicInteger<quint64> sLastId;
+
+    mId = ++sLastId;
+    mOpaqueColor.setAlphaF(1.0);
+}
+
+
+UBWetInkStroke::~UBWetInkStroke()
+{
+    qDeleteAll(mPolygonItems);
+}
+
+
+void UBWetInkStroke::addPolygonItem(UBGraphicsPolygonItem* polygonItem)
+{
+    const QPolygonF polygon = polygonItem->sceneTransform().map(polygonItem->polygon());
+
+    mPolygonItems << polygonItem;
+    mPolygons << polygon;
+    mBounds |= polygon.boundingRect();
+}
+
+
+QList<UBGraphicsPolygonItem*> UBWetInkStroke::takePolygonItems()
+{
+    QList<UBGraphicsPolygonItem*> polygonItems = mPolygonItems;
+
+    mPolygonItems.clear();
+    mPolygons.clear();
+    mTempPolygon.clear();
+
+    return polygonItems;
+}
+
+
+void UBWetInkStroke::setTempPolygon(const QPolygonF& polygon)
+{
+    mTempPolygon = polygon;
+    mBounds |= polygon.boundingRect();
+}
@@ -0,0 +1,84 @@
+/*
+ * Copyright (C) 2015-2022 Département de l'Instruction Publique (DIP-SEM)
+ *
+ * Copyright (C) 2013 Open Education Foundation
+ *
+ * Copyright (C) 2010-2013 Groupement d'Intérêt Public pour
+ * l'Education Numérique en Afrique (GIP ENA)
+ *
+ * This file is part of OpenBoard.
+ *
+ * OpenBoard is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3 of the License,
+ * with a specific linking exception for the OpenSSL project's
+ * "OpenSSL" library (or with modified versions of it that use the
+ * same license as the "OpenSSL" library).
+ *
+ * OpenBoard is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with OpenBoard. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+
+
+
+
+
+#ifndef UBWETINKSTROKE_H
+#define UBWETINKSTROKE_H
+
+#include <QtGui>
+
+class UBGraphicsPolygonItem;
+
+/**
+ * Pen or marker stroke being drawn, shown by the board views on top of the scene.
+ *
+ * The segments are not added to the scene while the stroke is drawn. Each view
+ * rasterises the new segments into its own viewport sized image and paints it in
+ * drawForeground, so drawing does not go through the scene index. The stroke
+ * owns its segments until they are taken back or deleted with it.
+ */
+class UBWetInkStroke
+{
+    public:
+
+        UBWetInkStroke(const QColor& color);
+        virtual ~UBWetInkStroke();
+
+        quint64 id() const { return mId; }
+
+        QColor opaqueColor() const { return mOpaqueColor; }
+        qreal opacity() const { return mOpacity; }
+
+        void addPolygonItem(UBGraphicsPolygonItem* polygonItem);
+        QList<UBGraphicsPolygonItem*> takePolygonItems();
+
+        const QList<QPolygonF>& polygons() const { return mPolygons; }
+
+        void setTempPolygon(const QPolygonF& polygon);
+        const QPolygonF& tempPolygon() const { return mTempPolygon; }
+
+        QRectF boundingRect() const { return mBounds; }
+
+    private:
+
+        quint64 mId;
+
+        QColor mOpaqueColor;
+        qreal mOpacity;
+
+        QList<UBGraphicsPolygonItem*> mPolygonItems;
+        // segments in scene coordinates
+        QList<QPolygonF> mPolygons;
+        QPolygonF mTempPolygon;
+        QRectF mBounds;
+};
+
+#endif // UBWETINKSTROKE_H
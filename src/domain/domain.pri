@@ -7,12 +7,17 @@ HEADERS += src/domain/UBGraphicsScene.h \
     src/domain/UBPageSizeUndoCommand.h \
     src/domain/UBGraphicsSvgItem.h \
     src/domain/UBGraphicsPolygonItem.h \
+    src/domain/UBGraphicsMarkerLayerItem.h \
+    src/domain/UBEraserEngine.h \
+    src/domain/UBWetInkStroke.h \
+    src/domain/UBBackgroundRenderer.h \
     src/domain/UBItem.h \
     src/domain/UBGraphicsWidgetItem.h \
     src/domain/UBGraphicsPDFItem.h \
     src/domain/UBGraphicsTextItem.h \
     src/domain/UBResizableGraphicsItem.h \
     src/domain/UBGraphicsStroke.h \
+    src/domain/UBGraphicsStrokeItem.h \
     src/domain/UBGraphicsMediaItem.h \
     src/domain/UBGraphicsGroupContainerItem.h \
     src/domain/UBGraphicsGroupContainerItemDelegate.h \
@@ -36,12 +41,17 @@ SOURCES += src/domain/UBGraphicsScene.cpp \
     src/domain/UBPageSizeUndoCommand.cpp \
     src/domain/UBGraphicsSvgItem.cpp \
     src/domain/UBGraphicsPolygonItem.cpp \
+    src/domain/UBGraphicsMarkerLayerItem.cpp \
+    src/domain/UBEraserEngine.cpp \
+    src/domain/UBWetInkStroke.cpp \
+    src/domain/UBBackgroundRenderer.cpp \
     src/domain/UBItem.cpp \
     src/domain/UBGraphicsWidgetItem.cpp \
     src/domain/UBGraphicsPDFItem.cpp \
     src/domain/UBGraphicsTextItem.cpp \
     src/domain/UBResizableGraphicsItem.cpp \
     src/domain/UBGraphicsStroke.cpp \
+    src/domain/UBGraphicsStrokeItem.cpp \
     src/domain/UBGraphicsMediaItem.cpp \
     src/domain/UBGraphicsGroupContainerItem.cpp \
     src/domain/UBGraphicsGroupContainerItemDelegate.cpp \
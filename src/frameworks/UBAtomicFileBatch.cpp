@@ -0,0 +1,247 @@
+/*
+ * Copyright (C) 2015-2022 Département de l'Instruction Publique (DIP-SEM)
+ *
+ * Copyright (C) 2013 Open Education Foundation
+ *
+ * Copyright (C) 2010-2013 Groupement d'Intérêt Public pour
+ * l'Education Numérique en Afrique (GIP ENA)
+ *
+ * This file is part of OpenBoard.
+ *
+ * OpenBoard is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3 of the License,
+ * with a specific linking exception for the OpenSSL project's
+ * "OpenSSL" library (or with modified versions of it that use the
+ * same license as the "OpenSSL" library).
+ *
+ * OpenBoard is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with OpenBoard. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+
+
+
+
+#include "UBAtomicFileBatch.h"
+
+#include <QDateTime>
+#include <QDebug>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QRandomGenerator>
+#include <QSet>
+
+#ifdef Q_OS_WIN
+    #include <windows.h>
+#else
+    #include <fcntl.h>
+    #include <stdio.h>
+    #include <unistd.h>
+#endif
+
+#include "core/memcheck.h"
+
+namespace
+{
+    const QString sTemporarySuffix(".tmp");
+
+    // a temporary file older than this is not part of a running batch
+    const int sStaleTemporaryFileAge = 10 * 60;
+
+    bool syncFile(const QString& fileName)
+    {
+#ifdef Q_OS_WIN
+        HANDLE handle = CreateFileW(reinterpret_cast<LPCWSTR>(QDir::toNativeSeparators(fileName).utf16()),
+                                    GENERIC_WRITE, FILE_SHARE_READ | FILE_SHARE_WRITE, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+
+        if (handle == INVALID_HANDLE_VALUE)
+            return false;
+
+        bool synced = FlushFileBuffers(handle);
+        CloseHandle(handle);
+        return synced;
+#else
+        int fd = ::open(QFile::encodeName(fileName).constData(), O_RDONLY);
+
+        if (fd < 0)
+            return false;
+
+        bool synced = ::fsync(fd) == 0;
+        ::close(fd);
+        return synced;
+#endif
+    }
+
+    void syncDirectory(const QString& path)
+    {
+#ifdef Q_OS_WIN
+        // NTFS journals the rename, MOVEFILE_WRITE_THROUGH waits for it
+        Q_UNUSED(path);
+#else
+        // a renamed file only survives a power cut once its directory entry is on disk
+        syncFile(path);
+#endif
+    }
+
+    bool replaceFile(const QString& source, const QString& target)
+    {
+#ifdef Q_OS_WIN
+        return MoveFileExW(reinterpret_cast<LPCWSTR>(QDir::toNativeSeparators(source).utf16()),
+                           reinterpret_cast<LPCWSTR>(QDir::toNativeSeparators(target).utf16()),
+                           MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH);
+#else
+        return ::rename(QFile::encodeName(source).constData(), QFile::encodeName(target).constData()) == 0;
+#endif
+    }
+}
+
+UBAtomicFileBatch::UBAtomicFileBatch()
+    : mFailed(false)
+{
+    // NOOP
+}
+
+UBAtomicFileBatch::~UBAtomicFileBatch()
+{
+    discard();
+}
+
+bool UBAtomicFileBatch::write(const QString& fileName, const QByteArray& data)
+{
+    // each write gets its own temporary file, so that a batch saved on the GUI
+    // thread and one of the persistence worker never share it
+    QString temporaryFileName;
+    QFile file;
+    bool opened = false;
+
+    for (int attempt = 0; attempt < 3 && !opened; ++attempt)
+    {
+        temporaryFileName = QString("%1.%2%3")
+                .arg(fileName)
+                .arg(QRandomGenerator::global()->generate(), 8, 16, QChar('0'))
+                .arg(sTemporarySuffix);
+        file.setFileName(temporaryFileName);
+        opened = file.open(QIODevice::WriteOnly | QIODevice::NewOnly);
+
+        if (!opened && !file.exists())
+            break;
+    }
+
+    if (!opened)
+    {
+        qCritical() << "cannot open " << temporaryFileName << " for writing. Error : " << file.errorString();
+        mFailed = true;
+        return false;
+    }
+
+    if (file.write(data) != data.size())
+    {
+        qCritical() << "cannot write " << temporaryFileName << ". Error : " << file.errorString();
+        file.close();
+        file.remove();
+        mFailed = true;
+        return false;
+    }
+
+    file.close();
+    mFiles << qMakePair(temporaryFileName, fileName);
+
+    return true;
+}
+
+void UBAtomicFileBatch::sync(const QString& fileName)
+{
+    mSyncFiles << fileName;
+}
+
+bool UBAtomicFileBatch::commit(bool syncToDisk)
+{
+    if (mFailed)
+    {
+        // keep the previous version of all files of the batch
+        discard();
+        return false;
+    }
+
+    QSet<QString> directories;
+
+    if (syncToDisk)
+    {
+        // flush the data of all files before any of them replaces its target
+        for (const auto& file : std::as_const(mFiles))
+        {
+            syncFile(file.first);
+            directories << QFileInfo(file.second).absolutePath();
+        }
+
+        for (const QString& fileName : std::as_const(mSyncFiles))
+        {
+            if (QFile::exists(fileName) && syncFile(fileName))
+                directories << QFileInfo(fileName).absolutePath();
+        }
+    }
+
+    bool replaced = true;
+
+    for (const auto& file : std::as_const(mFiles))
+    {
+        if (!replaceFile(file.first, file.second))
+        {
+            qCritical() << "cannot replace " << file.second;
+            QFile::remove(file.first);
+            replaced = false;
+        }
+    }
+
+    mFiles.clear();
+    mSyncFiles.clear();
+
+    for (const QString& directory : std::as_const(directories))
+    {
+        syncDirectory(directory);
+    }
+
+    return replaced;
+}
+
+bool UBAtomicFileBatch::writeFile(const QString& fileName, const QByteArray& data, bool syncToDisk)
+{
+    UBAtomicFileBatch batch;
+    return batch.write(fileName, data) && batch.commit(syncToDisk);
+}
+
+void UBAtomicFileBatch::removeStaleFiles(const QString& directory)
+{
+    const QDateTime staleBefore = QDateTime::currentDateTime().addSecs(-sStaleTemporaryFileAge);
+    // only names made by write(), moving pages parks whole pages as "page%1.tmp"
+    const QFileInfoList temporaryFiles = QDir(directory).entryInfoList({"*.????????" + sTemporarySuffix}, QDir::Files);
+
+    for (const QFileInfo& temporaryFile : temporaryFiles)
+    {
+        if (temporaryFile.lastModified() < staleBefore)
+        {
+            qDebug() << "removing stale temporary file" << temporaryFile.fileName();
+            QFile::remove(temporaryFile.absoluteFilePath());
+        }
+    }
+}
+
+void UBAtomicFileBatch::discard()
+{
+    for (const auto& file : std::as_const(mFiles))
+    {
+        QFile::remove(file.first);
+    }
+
+    mFiles.clear();
+    mSyncFiles.clear();
+    mFailed = false;
+}
@@ -0,0 +1,75 @@
+/*
+ * Copyright (C) 2015-2022 Département de l'Instruction Publique (DIP-SEM)
+ *
+ * Copyright (C) 2013 Open Education Foundation
+ *
+ * Copyright (C) 2010-2013 Groupement d'Intérêt Public pour
+ * l'Education Numérique en Afrique (GIP ENA)
+ *
+ * This file is part of OpenBoard.
+ *
+ * OpenBoard is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3 of the License,
+ * with a specific linking exception for the OpenSSL project's
+ * "OpenSSL" library (or with modified versions of it that use the
+ * same license as the "OpenSSL" library).
+ *
+ * OpenBoard is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with OpenBoard. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+
+
+
+
+
+#ifndef UBATOMICFILEBATCH_H
+#define UBATOMICFILEBATCH_H
+
+#include <QByteArray>
+#include <QList>
+#include <QPair>
+#include <QString>
+#include <QStringList>
+
+/**
+ * Replaces a group of files so that a crash never leaves a partially written file.
+ *
+ * Each file is first written to a uniquely named temporary file next to it. On commit, all files
+ * of the batch are flushed to disk together, then the temporary files are renamed
+ * over the targets and the directories are flushed once.
+ */
+class UBAtomicFileBatch
+{
+    public:
+        UBAtomicFileBatch();
+        ~UBAtomicFileBatch();
+
+        bool write(const QString& fileName, const QByteArray& data);
+
+        // flush a file written by someone else together with this batch
+        void sync(const QString& fileName);
+
+        bool commit(bool syncToDisk = true);
+
+        static bool writeFile(const QString& fileName, const QByteArray& data, bool syncToDisk = true);
+
+        // remove temporary files left behind by a crash
+        static void removeStaleFiles(const QString& directory);
+
+    private:
+        void discard();
+
+        QList<QPair<QString, QString>> mFiles; // temporary file, target
+        QStringList mSyncFiles;
+        bool mFailed;
+};
+
+#endif // UBATOMICFILEBATCH_H
@@ -47,6 +47,7 @@
 #include "board/UBBoardPaletteManager.h"
 #include "core/UBApplicationController.h"
 #include "core/UBPersistenceManager.h"
+#include "core/UBThumbnailService.h"
 #include "UBThumbnailView.h"
 #include "gui/UBDocumentThumbnailsView.h"
 
@@ -71,6 +72,9 @@ UBBoardThumbnailsView::UBBoardThumbnailsView(QWidget *parent, const char *name)
     setHorizontalScrollBarPolicy(Qt::ScrollBarAlwaysOff);
     setFrameShadow(QFrame::Plain);
 
+    // hovering a thumbnail prefetches its page
+    setMouseTracking(true);
+
     mThumbnailWidth = width() - 2*mMargin;
 
     mLongPressTimer.setInterval(mLongPressInterval);
@@ -96,6 +100,8 @@ UBBoardThumbnailsView::UBBoardThumbnailsView(QWidget *parent, const char *name)
     connect(UBApplication::boardController->controlView(), &UBBoardView::mouseReleased, this, &UBBoardThumbnailsView::adjustThumbnail);
 
     connect(UBApplication::boardController->controlView(), &UBBoardView::painted, this, &UBBoardThumbnailsView::updateThumbnailPixmap);
+
+    connect(UBThumbnailService::service(), &UBThumbnailService::thumbnailReady, this, &UBBoardThumbnailsView::onThumbnailReady);
 }
 
 void UBBoardThumbnailsView::moveThumbnail(int from, int to)
@@ -139,9 +145,21 @@ void UBBoardThumbnailsView::removeThumbnail(int i)
 
 UBDraggableLivePixmapItem* UBBoardThumbnailsView::createThumbnail(std::shared_ptr<UBDocumentProxy> document, int i)
 {
-    QPixmap thumbnail = UBThumbnailAdaptor::get(document, i);
+    // the thumbnail is loaded when it gets near the viewport
+    QPixmap placeholder = UBThumbnailService::service()->placeholder(document);
+
+    return new UBDraggableLivePixmapItem(nullptr, document, i, placeholder);
+}
 
-    return new UBDraggableLivePixmapItem(nullptr, document, i, thumbnail);
+void UBBoardThumbnailsView::onThumbnailReady(std::shared_ptr<UBDocumentProxy> document, int i, const QPixmap& thumbnail)
+{
+    // replace the placeholder, unless the thumbnail has been scrolled away meanwhile
+    if (i < mThumbnails.size() && mThumbnails.at(i)->documentProxy() == document
+            && loadedSceneRect().intersects(mThumbnails.at(i)->sceneBoundingRect()))
+    {
+        mThumbnails.at(i)->setThumbnail(thumbnail);
+        mThumbnails.at(i)->updatePos(mThumbnailWidth, mThumbnailWidth / UBSettings::minScreenRatio);
+    }
 }
 
 void UBBoardThumbnailsView::addThumbnail(std::shared_ptr<UBDocumentProxy> document, int i)
@@ -271,9 +289,97 @@ void UBBoardThumbnailsView::updateExposure()
     QRect viewportRect(QPoint(0, 0), viewport()->size());
     QRectF visibleSceneRect = mapToScene(viewportRect).boundingRect();
 
+    QRectF loadedRect = loadedSceneRect();
+
     for (UBDraggableLivePixmapItem* thumbnail : std::as_const(mThumbnails))
     {
         thumbnail->setExposed(visibleSceneRect.intersects(thumbnail->sceneBoundingRect()));
+
+        if (!thumbnail->isThumbnailLoaded() && loadedRect.intersects(thumbnail->sceneBoundingRect()))
+        {
+            loadThumbnail(thumbnail);
+        }
+    }
+
+    releaseThumbnails(loadedRect);
+}
+
+QRectF UBBoardThumbnailsView::loadedSceneRect()
+{
+    // one viewport above and below the visible thumbnails, so that scrolling shows them at once
+    QRect viewportRect(QPoint(0, 0), viewport()->size());
+    QRectF visibleSceneRect = mapToScene(viewportRect).boundingRect();
+
+    return visibleSceneRect.adjusted(0, -visibleSceneRect.height(), 0, visibleSceneRect.height());
+}
+
+QSize UBBoardThumbnailsView::thumbnailSize()
+{
+    QSizeF size(mThumbnailWidth, mThumbnailWidth / UBSettings::minScreenRatio);
+
+    return (size * devicePixelRatioF()).toSize();
+}
+
+void UBBoardThumbnailsView::loadThumbnail(UBDraggableLivePixmapItem* thumbnail)
+{
+    // decoded at the displayed size, delivered later by onThumbnailReady if not available yet
+    QPixmap pixmap = UBThumbnailService::service()->thumbnail(thumbnail->documentProxy(), thumbnail->sceneIndex(), thumbnailSize());
+
+    if (!pixmap.isNull())
+    {
+        thumbnail->setThumbnail(pixmap);
+        thumbnail->updatePos(mThumbnailWidth, mThumbnailWidth / UBSettings::minScreenRatio);
+    }
+}
+
+void UBBoardThumbnailsView::releaseThumbnails(const QRectF& loadedRect)
+{
+    // thumbnails away from the viewport are kept as long as they fit into the budget
+    const qint64 budget = UBSettings::settings()->thumbnailMemoryBudget->get().toLongLong() * 1024 * 1024;
+    qint64 used = 0;
+
+    QList<UBDraggableLivePixmapItem*> releasable;
+
+    for (UBDraggableLivePixmapItem* thumbnail : std::as_const(mThumbnails))
+    {
+        if (thumbnail->isThumbnailLoaded())
+        {
+            used += qint64(thumbnail->pixmap().width()) * thumbnail->pixmap().height() * 4;
+
+            if (!loadedRect.intersects(thumbnail->sceneBoundingRect()))
+                releasable << thumbnail;
+        }
+    }
+
+    if (used <= budget)
+    {
+        return;
+    }
+
+    // release the farthest first
+    const qreal center = loadedRect.center().y();
+
+    std::sort(releasable.begin(), releasable.end(), [center](UBDraggableLivePixmapItem* a, UBDraggableLivePixmapItem* b){
+        return std::abs(a->sceneBoundingRect().center().y() - center) > std::abs(b->sceneBoundingRect().center().y() - center);
+    });
+
+    QPixmap placeholder;
+
+    for (UBDraggableLivePixmapItem* thumbnail : std::as_const(releasable))
+    {
+        if (used <= budget)
+            break;
+
+        const qint64 size = qint64(thumbnail->pixmap().width()) * thumbnail->pixmap().height() * 4;
+
+        if (placeholder.isNull())
+            placeholder = UBThumbnailService::service()->placeholder(thumbnail->documentProxy());
+
+        if (thumbnail->releaseThumbnail(placeholder))
+        {
+            used -= size;
+            thumbnail->updatePos(mThumbnailWidth, mThumbnailWidth / UBSettings::minScreenRatio);
+        }
     }
 }
 
@@ -317,6 +423,11 @@ void UBBoardThumbnailsView::mousePressEvent(QMouseEvent *event)
 void UBBoardThumbnailsView::mouseMoveEvent(QMouseEvent *event)
 {
     QGraphicsView::mouseMoveEvent(event);
+
+    if (event->buttons() == Qt::NoButton)
+    {
+        hintPrefetch(event->pos());
+    }
 }
 
 void UBBoardThumbnailsView::longPressTimeout()
@@ -366,6 +477,17 @@ void UBBoardThumbnailsView::scrollContentsBy(int dx, int dy)
 {
     QGraphicsView::scrollContentsBy(dx, dy);
     updateExposure();
+    hintPrefetch(viewport()->rect().center());
+}
+
+void UBBoardThumbnailsView::hintPrefetch(const QPoint& pos)
+{
+    UBDraggableLivePixmapItem* item = dynamic_cast<UBDraggableLivePixmapItem*>(itemAt(pos));
+
+    if (item)
+    {
+        UBPersistenceManager::persistenceManager()->prefetchHint(item->documentProxy(), item->sceneIndex());
+    }
 }
 
 void UBBoardThumbnailsView::dragEnterEvent(QDragEnterEvent *event)
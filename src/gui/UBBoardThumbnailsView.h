@@ -61,6 +61,7 @@ public slots:
     void longPressTimeout();
     void mousePressAndHoldEvent(QPoint pos);
     void updateThumbnailPixmap(const QRectF region);
+    void onThumbnailReady(std::shared_ptr<UBDocumentProxy> document, int i, const QPixmap& thumbnail);
 
 protected:
     virtual void resizeEvent(QResizeEvent *event);
@@ -85,6 +86,11 @@ signals:
 private:
     UBDraggableLivePixmapItem* createThumbnail(std::shared_ptr<UBDocumentProxy> document, int i);
     void updateExposure();
+    QRectF loadedSceneRect();
+    QSize thumbnailSize();
+    void loadThumbnail(UBDraggableLivePixmapItem* thumbnail);
+    void releaseThumbnails(const QRectF& loadedRect);
+    void hintPrefetch(const QPoint& pos);
 
     QList<UBDraggableLivePixmapItem*> mThumbnails;
 
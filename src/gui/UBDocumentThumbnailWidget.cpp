@@ -29,9 +29,12 @@
 
 #include "UBDocumentThumbnailWidget.h"
 
+#include <algorithm>
+
 #include "core/UBApplication.h"
 #include "core/UBMimeData.h"
 #include "core/UBSettings.h"
+#include "core/UBThumbnailService.h"
 
 #include "board/UBBoardController.h"
 
@@ -50,6 +53,17 @@ UBDocumentThumbnailWidget::UBDocumentThumbnailWidget(QWidget* parent)
     bCanDrag = false;
     mScrollTimer = new QTimer(this);
     connect(mScrollTimer, SIGNAL(timeout()), this, SLOT(autoScroll()));
+
+    // only the thumbnails near the viewport are loaded, changes are processed once per event loop iteration
+    mRefreshTimer.setSingleShot(true);
+    mRefreshTimer.setInterval(0);
+    connect(&mRefreshTimer, &QTimer::timeout, this, &UBDocumentThumbnailWidget::refreshScene);
+
+    mExposureTimer.setSingleShot(true);
+    mExposureTimer.setInterval(0);
+    connect(&mExposureTimer, &QTimer::timeout, this, &UBDocumentThumbnailWidget::updateExposure);
+
+    connect(UBThumbnailService::service(), &UBThumbnailService::thumbnailReady, this, &UBDocumentThumbnailWidget::onThumbnailReady);
 }
 
 
@@ -309,10 +323,128 @@ void UBDocumentThumbnailWidget::updateThumbnailPixmap(int index, const QPixmap&
         if (thumbnail)
         {
             thumbnail->setPixmap(newThumbnail);
+
+            // the size of the pixmap may have changed
+            mRefreshTimer.start();
+        }
+    }
+}
+
+void UBDocumentThumbnailWidget::appendGraphicsItems(const QList<QGraphicsItem*>& pGraphicsItems, const QList<QUrl>& pItemPaths, const QStringList& pLabels)
+{
+    UBDocumentThumbnailsView::appendGraphicsItems(pGraphicsItems, pItemPaths, pLabels);
+
+    mExposureTimer.start();
+}
+
+void UBDocumentThumbnailWidget::refreshScene()
+{
+    UBDocumentThumbnailsView::refreshScene();
+
+    mExposureTimer.start();
+}
+
+void UBDocumentThumbnailWidget::scrollContentsBy(int dx, int dy)
+{
+    UBDocumentThumbnailsView::scrollContentsBy(dx, dy);
+
+    mExposureTimer.start();
+}
+
+void UBDocumentThumbnailWidget::updateExposure()
+{
+    std::shared_ptr<UBDocumentProxy> proxy = currentThumbnailsDocument();
+
+    if (!proxy)
+        return;
+
+    const QRectF loadedRect = loadedSceneRect();
+    const QSize size = thumbnailSize();
+    const QPixmap placeholder = UBThumbnailService::service()->placeholder(proxy);
+
+    const qint64 budget = UBSettings::settings()->thumbnailMemoryBudget->get().toLongLong() * 1024 * 1024;
+    qint64 used = 0;
+
+    QList<UBSceneThumbnailPixmap*> releasable;
+
+    foreach (QGraphicsItem* item, mGraphicItems)
+    {
+        UBSceneThumbnailPixmap* thumbnail = dynamic_cast<UBSceneThumbnailPixmap*>(item);
+
+        if (!thumbnail)
+            continue;
+
+        const QPixmap pixmap = thumbnail->pixmap();
+        const bool loaded = pixmap.cacheKey() != placeholder.cacheKey();
+
+        if (loadedRect.intersects(thumbnail->sceneBoundingRect()))
+        {
+            // load it, or load it again at a larger size after zooming in
+            if (!loaded || (pixmap.width() < size.width() && pixmap.height() < size.height()))
+            {
+                QPixmap loadedPixmap = UBThumbnailService::service()->thumbnail(proxy, thumbnail->sceneIndex(), size);
+
+                if (!loadedPixmap.isNull() && (!loaded || loadedPixmap.size() != pixmap.size()))
+                {
+                    updateThumbnailPixmap(thumbnail->sceneIndex(), loadedPixmap);
+                }
+            }
+        }
+        else if (loaded)
+        {
+            releasable << thumbnail;
         }
+
+        if (loaded)
+            used += qint64(pixmap.width()) * pixmap.height() * 4;
+    }
+
+    if (used <= budget)
+        return;
+
+    // thumbnails away from the viewport are kept as long as they fit into the budget, the farthest are released first
+    const QPointF center = loadedRect.center();
+
+    std::sort(releasable.begin(), releasable.end(), [center](UBSceneThumbnailPixmap* a, UBSceneThumbnailPixmap* b){
+        return QLineF(a->sceneBoundingRect().center(), center).length() > QLineF(b->sceneBoundingRect().center(), center).length();
+    });
+
+    foreach (UBSceneThumbnailPixmap* thumbnail, releasable)
+    {
+        if (used <= budget)
+            break;
+
+        used -= qint64(thumbnail->pixmap().width()) * thumbnail->pixmap().height() * 4;
+        updateThumbnailPixmap(thumbnail->sceneIndex(), placeholder);
+    }
+}
+
+void UBDocumentThumbnailWidget::onThumbnailReady(std::shared_ptr<UBDocumentProxy> proxy, int index, const QPixmap& thumbnail)
+{
+    // replace the placeholder, unless the thumbnail has been scrolled away meanwhile
+    if (proxy == currentThumbnailsDocument() && index >= 0 && index < mGraphicItems.length()
+            && loadedSceneRect().intersects(mGraphicItems.at(index)->sceneBoundingRect()))
+    {
+        updateThumbnailPixmap(index, thumbnail);
     }
 }
 
+QRectF UBDocumentThumbnailWidget::loadedSceneRect()
+{
+    // one viewport above and below the visible thumbnails, so that scrolling shows them at once
+    QRect viewportRect(QPoint(0, 0), viewport()->size());
+    QRectF visibleSceneRect = mapToScene(viewportRect).boundingRect();
+
+    return visibleSceneRect.adjusted(0, -visibleSceneRect.height(), 0, visibleSceneRect.height());
+}
+
+QSize UBDocumentThumbnailWidget::thumbnailSize()
+{
+    QSizeF size(thumbnailWidth(), thumbnailWidth() / UBSettings::minScreenRatio);
+
+    return (size * devicePixelRatioF()).toSize();
+}
+
 void UBDocumentThumbnailWidget::removeThumbnail(int sceneIndex)
 {
     if (sceneIndex >= 0 && sceneIndex < mGraphicItems.length())
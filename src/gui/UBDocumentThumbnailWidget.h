@@ -30,6 +30,8 @@
 #ifndef UBDOCUMENTTHUMBNAILWIDGET_H_
 #define UBDOCUMENTTHUMBNAILWIDGET_H_
 
+#include <QTimer>
+
 #include "UBDocumentThumbnailsView.h"
 
 class UBGraphicsScene;
@@ -55,12 +57,16 @@ class UBDocumentThumbnailWidget: public UBDocumentThumbnailsView
             void moveThumbnail(int from, int to);
             void insertThumbnail(int index, QGraphicsPixmapItem *newThumbnail);
             virtual void setGraphicsItems(const QList<QGraphicsItem*>& pGraphicsItems, const QList<QUrl>& pItemPaths, const QStringList pLabels = QStringList(), const QString& pMimeType = QString(""));
+            virtual void appendGraphicsItems(const QList<QGraphicsItem*>& pGraphicsItems, const QList<QUrl>& pItemPaths, const QStringList& pLabels);
+            virtual void refreshScene();
 
     signals:
         void sceneDropped(std::shared_ptr<UBDocumentProxy> proxy, int source, int target);
 
     private slots:
         void autoScroll();
+        void updateExposure();
+        void onThumbnailReady(std::shared_ptr<UBDocumentProxy> proxy, int index, const QPixmap& thumbnail);
 
     protected:
 
@@ -71,8 +77,12 @@ class UBDocumentThumbnailWidget: public UBDocumentThumbnailsView
         virtual void dragMoveEvent(QDragMoveEvent *event);
         virtual void dropEvent(QDropEvent *event);
 
+        virtual void scrollContentsBy(int dx, int dy);
+
     private:
         void deleteDropCaret();
+        QRectF loadedSceneRect();
+        QSize thumbnailSize();
 
         QGraphicsRectItem *mDropCaretRectItem;
         UBThumbnailPixmap *mClosestDropItem;
@@ -80,6 +90,8 @@ class UBDocumentThumbnailWidget: public UBDocumentThumbnailsView
         bool mDragEnabled;
         QTimer* mScrollTimer;
         int mScrollMagnitude;
+        QTimer mRefreshTimer;
+        QTimer mExposureTimer;
 };
 
 #endif /* UBDOCUMENTTHUMBNAILWIDGET_H_ */
@@ -139,7 +139,42 @@ void UBDocumentThumbnailsView::insertThumbnailToScene(QGraphicsPixmapItem* newTh
 }
 
 
+void UBDocumentThumbnailsView::appendGraphicsItems(const QList<QGraphicsItem*>& pGraphicsItems, const QList<QUrl>& pItemsPaths, const QStringList& pLabels)
+{
+    Q_ASSERT(pItemsPaths.count() == pLabels.count());
+
+    const int firstIndex = mGraphicItems.size();
+
+    mGraphicItems << pGraphicsItems;
+    mItemsPaths << pItemsPaths;
+    mLabels << pLabels;
+
+    foreach (QGraphicsItem* item, pGraphicsItems)
+    {
+        if (item->scene() != &mThumbnailsScene){
+            mThumbnailsScene.addItem(item);
+        }
+    }
+
+    foreach (const QString label, pLabels)
+    {
+        UBThumbnailTextItem *labelItem =
+            new UBThumbnailTextItem(label); // deleted while replace or by the scene destruction
+
+        mThumbnailsScene.addItem(labelItem);
+        mLabelsItems << labelItem;
+    }
+
+    // the items before keep their place
+    layoutItems(firstIndex);
+}
+
 void UBDocumentThumbnailsView::refreshScene()
+{
+    layoutItems(0);
+}
+
+void UBDocumentThumbnailsView::layoutItems(int firstIndex)
 {
     int nbColumns = (geometry().width() - mSpacing) / (mThumbnailWidth + mSpacing);
 
@@ -154,7 +189,7 @@ void UBDocumentThumbnailsView::refreshScene()
 
     qreal thumbnailHeight = mThumbnailWidth / UBSettings::minScreenRatio;
 
-    for (int i = 0; i < mGraphicItems.size(); i++)
+    for (int i = firstIndex; i < mGraphicItems.size(); i++)
     {
         QGraphicsItem* item = mGraphicItems.at(i);
 
@@ -1074,6 +1109,7 @@ UBDraggableLivePixmapItem::UBDraggableLivePixmapItem(std::shared_ptr<UBGraphicsS
     , mScene(pageScene)
     , mPageNumber(new UBThumbnailTextItem(index))
     , mExposed(false)
+    , mThumbnailLoaded(false)
 {
     setFlag(QGraphicsItem::ItemIsSelectable, true);
     setAcceptDrops(true);
@@ -1163,6 +1199,35 @@ bool UBDraggableLivePixmapItem::isExposed()
     return mExposed;
 }
 
+void UBDraggableLivePixmapItem::setThumbnail(const QPixmap& thumbnail)
+{
+    // a live thumbnail renders its scene itself
+    if (!mScene)
+    {
+        setPixmap(thumbnail);
+    }
+
+    mThumbnailLoaded = true;
+}
+
+bool UBDraggableLivePixmapItem::releaseThumbnail(const QPixmap& placeholder)
+{
+    if (mScene || !mThumbnailLoaded)
+    {
+        return false;
+    }
+
+    setPixmap(placeholder);
+    mThumbnailLoaded = false;
+
+    return true;
+}
+
+bool UBDraggableLivePixmapItem::isThumbnailLoaded() const
+{
+    return mThumbnailLoaded;
+}
+
 void UBDraggableLivePixmapItem::updatePixmap(const QRectF &region)
 {
     if (mScene && mSize.isValid() && mExposed)
@@ -1247,6 +1312,7 @@ void UBDraggableLivePixmapItem::createPixmap()
             setPixmap(pixmap);
         }
 
+        mThumbnailLoaded = true;
         adjustThumbnail();
     }
 }
@@ -82,7 +82,9 @@ class UBDocumentThumbnailsView : public QGraphicsView
         void setSpacing(qreal pSpacing);
         virtual void setGraphicsItems(const QList<QGraphicsItem*>& pGraphicsItems, const QList<QUrl>& pItemPaths, const QStringList pLabels = QStringList(), const QString& pMimeType = QString(""));
         void insertThumbnailToScene(QGraphicsPixmapItem* newThumbnail, UBThumbnailTextItem* thumbnailTextItem);
-        void refreshScene();
+        // only lays out the new items, e.g. for pages appended while a file is imported
+        virtual void appendGraphicsItems(const QList<QGraphicsItem*>& pGraphicsItems, const QList<QUrl>& pItemPaths, const QStringList& pLabels);
+        virtual void refreshScene();
         void sceneSelectionChanged();
 
     signals:
@@ -115,6 +117,7 @@ class UBDocumentThumbnailsView : public QGraphicsView
         bool bCanDrag;
 
     private:
+        void layoutItems(int firstIndex);
         void selectAll();
         void selectItems(int startIndex, int count);
         int rowCount() const;
@@ -609,6 +612,10 @@ class UBDraggableLivePixmapItem : public UBDraggableThumbnailItem
 
         bool isExposed();
 
+        void setThumbnail(const QPixmap& thumbnail);
+        bool releaseThumbnail(const QPixmap& placeholder);
+        bool isThumbnailLoaded() const;
+
     public slots:
         void updatePixmap(const QRectF &region = QRectF());
         void setScene(std::shared_ptr<UBGraphicsScene> scene);
@@ -624,6 +631,7 @@ class UBDraggableLivePixmapItem : public UBDraggableThumbnailItem
         QRectF mSceneRect;
         UBThumbnailTextItem* mPageNumber;
         bool mExposed;
+        bool mThumbnailLoaded;
         QSizeF mSize;
         QTransform mTransform;
 };
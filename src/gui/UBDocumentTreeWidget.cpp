@@ -295,14 +295,9 @@ void UBDocumentTreeWidget::dropEvent(QDropEvent *event)
                                 }
                             }
 
-                            UBPersistenceManager::persistenceManager()->insertDocumentSceneAt(targetDocProxy, sceneClone, targetDocProxy->pageCount());
-
-                            //due to incorrect generation of thumbnails of invisible scene I've used direct copying of thumbnail files
-                            //it's not universal and good way but it's faster
-                            QString from = sourceItem.documentProxy()->persistencePath() + UBFileSystemUtils::digitFileFormat("/page%1.thumbnail.jpg", sourceItem.sceneIndex());
-                            QString to  = targetDocProxy->persistencePath() + UBFileSystemUtils::digitFileFormat("/page%1.thumbnail.jpg", targetDocProxy->pageCount());
-                            QFile::remove(to);
-                            QFile::copy(from, to);
+                            //due to incorrect generation of thumbnails of invisible scene the thumbnail file is copied
+                            UBPersistenceManager::persistenceManager()->insertCopiedSceneAt(targetDocProxy, sceneClone, targetDocProxy->pageCount(),
+                                                                                            sourceItem.documentProxy(), sourceItem.sceneIndex());
                           }
                     }
 
@@ -36,12 +36,14 @@
 #include <fstream>
 #include <iostream>
 #include <iomanip>
+#include <vector>
 
 #include "core/memcheck.h"
 
 using namespace merge_lib;
 const std::string firstObj("%PDF-1.4\n1 0 obj\n<<\n/Title ()/Creator ()/Producer (Qt 4.5.0 (C) 1992-2009 Nokia Corporation and/or its subsidiary(-ies))/CreationDate (D:20090424120829)\n>>\nendobj\n");
 const std::string zeroStr("0000000000");
+const unsigned int OUTPUT_BUFFER_SIZE = 1048576; // = 1 Mb
 Document::Document(const char * fileName):
     _root(0), _pages(), _documentName(fileName), _maxObjectNumber(0)
 {
@@ -88,7 +90,10 @@ void Document::saveAs(const char * newFileName)
    //key - object number
    //value - size of object
    std :: map < unsigned int, std::pair<unsigned long long, unsigned int > > sizesAndGenerationNumbers;
+   //streams are copied in large parts, write them in large parts too
+   std::vector<char> outBuffer(OUTPUT_BUFFER_SIZE);
    std::ofstream out;
+   out.rdbuf()->pubsetbuf(&outBuffer[0], outBuffer.size());
    out.open(newFileName, std::ios::binary);
    if(!out.is_open())
    {      
@@ -31,6 +31,8 @@
 #include <iostream>
 #include <map>
 #include <QtGlobal>
+#include <string.h>
+#include <stdlib.h>
 
 #include "FilterPredictor.h"
 #include "Utils.h"
@@ -149,13 +151,14 @@ void FilterPredictor::initialize(Object *objectWithStream)
 }
 //-----------------------------
 // Function perorms decoding of one row of data.
+// out may share the buffer with in, it never runs ahead of it, so each
+// input byte is read before it is overwritten. prev is NULL for first row.
 //-----------------------------
-bool FilterPredictor::decodeRow(const char *in,std::string & out,const std::string &prev,int curPrediction)
+bool FilterPredictor::decodeRow(const char *input, char *output, const char *previous, int curPrediction)
 {
-   std::string dec(_bytesPerPixel,'\0');
-   dec.append(in,_rowLen); // the buffer to decode
-   int start = _bytesPerPixel;
-   int end = _bytesPerPixel + _rowLen;
+   const unsigned char *in = (const unsigned char *)input;
+   unsigned char *out = (unsigned char *)output;
+   const unsigned char *prev = (const unsigned char *)previous;
    switch(curPrediction)
    {
    case 2: // TIFF predictor
@@ -165,31 +168,27 @@ bool FilterPredictor::decodeRow(const char *in,std::string & out,const std::stri
 
       break;
 
-   case 1: 
-   case 10: // PNG NONE prediction
-      // nothing to do, take as is
-      break;
-
    case 11: // PNG SUB on all raws
-      for(int i = start;i<end;i++)
+      for(int i = 0;i<_rowLen;i++)
       {
-         dec[i] += dec[ i - _bytesPerPixel ];
+         int left = (i < _bytesPerPixel)?0:out[i - _bytesPerPixel];
+         out[i] = (unsigned char)(in[i] + left);
       }
       break;
    case 12: // PNG UP on all raws
-      for(int i = start;i<end;i++)
+      for(int i = 0;i<_rowLen;i++)
       {
-         dec[i] += prev[i];
+         int above = prev?prev[i]:0;
+         out[i] = (unsigned char)(in[i] + above);
       }
       break;
    case 13: // PNG average on all raws
       //Average(x) + floor((Raw(x-bpp)+Prior(x))/2)
-      for(int i = start;i<end;i++)
+      for(int i = 0;i<_rowLen;i++)
       {
-         int leftV  = int(dec[i - _bytesPerPixel])&0xFF;
-         int   aboveV = int(prev[i - _bytesPerPixel])&0xFF;
-         unsigned char average = (unsigned char)( (((leftV+aboveV)>>1)&0xFF));
-         dec[i] += average;
+         int leftV  = (i < _bytesPerPixel)?0:out[i - _bytesPerPixel];
+         int aboveV = prev?prev[i]:0;
+         out[i] = (unsigned char)(in[i] + ((leftV+aboveV)>>1));
       }
       break;
    case 14: //PNG PAETH on all rows
@@ -206,12 +205,12 @@ bool FilterPredictor::decodeRow(const char *in,std::string & out,const std::stri
       else return c
       Paeth(x) + PaethPredictor(Raw(x-bpp), Prior(x), Prior(x-bpp))
       */
-      for(int i = start;i<end;i++)
+      for(int i = 0;i<_rowLen;i++)
       {
-         int left = int( dec[i - _bytesPerPixel]) & 0xFF;
-         int upperLeft = int( prev[i - _bytesPerPixel]) & 0xFF;
+         int left = (i < _bytesPerPixel)?0:out[i - _bytesPerPixel];
+         int upperLeft = (prev && i >= _bytesPerPixel)?prev[i - _bytesPerPixel]:0;
 
-         int above = int( prev[i]) & 0xFF;
+         int above = prev?prev[i]:0;
          int p = left + above - upperLeft;
          int pLeft = abs(p - left);
          int pAbove = abs(p - above);
@@ -229,18 +228,25 @@ bool FilterPredictor::decodeRow(const char *in,std::string & out,const std::stri
          {
             paeth = upperLeft;
          }
-         dec[i] += char (paeth & 0xFF);
+         out[i] = (unsigned char)(in[i] + paeth);
       }
       break;
+   case 1: 
+   case 10: // PNG NONE prediction
    default:
+      // nothing to do, take as is
+      if( out != in )
+      {
+         memmove(out,in,_rowLen);
+      }
       break;
 
    }
-   out = dec;
    return true;
 }
 
-// method performs prediction decoding
+// method performs prediction decoding in place, rows are compacted
+// towards the beginning of content as they are decoded
 
 bool FilterPredictor::decode(std::string &content)
 {
@@ -248,34 +254,26 @@ bool FilterPredictor::decode(std::string &content)
    int rowBits = _columns*_colors*_bits;
    _rowLen = (rowBits>>3) + (rowBits&7);
    _bytesPerPixel =  (_colors * _bits + 7) >> 3;
-   int rows = 0;
-
-   if( isPNG )
-   {
-      rows = content.size()/(_rowLen+1) + (content.size()% (_rowLen+1));
-   }
-   else
-   {
-      rows = content.size()/(_rowLen) + (content.size()% (_rowLen) );
-   }
 
-   int inSize = content.size();
-   std::string  out = "";
+   size_t inSize = content.size();
+   size_t inRowLen = _rowLen + (isPNG?1:0);
 
-   if( inSize%(isPNG?_rowLen+1:_rowLen) != 0 )
+   if( _rowLen <= 0 || inSize%inRowLen != 0 )
    {
       std::cerr<<"Warning : wrong PNG identation inSize "<<inSize<<" rowLen = "<<_rowLen<<" isPNG = "<<isPNG<<"\n";
-      content = out;
+      content.clear();
       return false;
    }
+   size_t rows = inSize/inRowLen;
 
-   const char *curRow  = NULL;
-   std::string prev(_bytesPerPixel+_rowLen,'\0');  //"previous" line
+   char *data = &content[0];
+   const char *prev = NULL;  //"previous" line
    int curPredictor  = 1;
 
-   for(int i = 0;i<rows;i++)
+   for(size_t i = 0;i<rows;i++)
    {
-      curRow = content.data() + (i* (_rowLen + (isPNG?1:0)) );            
+      const char *curRow = data + i*inRowLen;
+      char *outRow = data + i*_rowLen;
       if( isPNG )
       {
          // this is PNG predictor!
@@ -286,17 +284,15 @@ bool FilterPredictor::decode(std::string &content)
       {
          curPredictor = _predictor; // default NONE predictor
       }
-      std::string dec;
-      if( !decodeRow(curRow,dec,prev,curPredictor) )
+      if( !decodeRow(curRow,outRow,prev,curPredictor) )
       {
          std::cerr<<"Unable to process prediction"<<curPredictor<<"!\n";
-         content = out;
+         content.clear();
          return false;
       }
-      //trace_hex(dec.data()+_bytesPerPixel,_rowLen);
-      prev = dec;
-      out += std::string(dec.data()+_bytesPerPixel,_rowLen);
+      //trace_hex(outRow,_rowLen);
+      prev = outRow;
    }
-   content = out;
+   content.resize(rows*_rowLen);
    return true;
 }
@@ -53,7 +53,7 @@ namespace merge_lib
 
 
    private:
-      bool decodeRow(const char *input, std::string &out,const std::string &prev,int curPrediction);
+      bool decodeRow(const char *input, char *output, const char *previous, int curPrediction);
       void obtainDecodeParams(Object*objectWithStream,std::string &dictStr);
       std::string getDictionaryContentStr(std::string & in, size_t &pos );
       int _predictor;
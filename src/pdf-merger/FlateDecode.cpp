@@ -33,6 +33,7 @@
 #include "zlib.h"
 #include "Utils.h"
 #include <string.h>
+#include <climits>
 
 #include "core/memcheck.h"
 
@@ -43,6 +44,66 @@ using namespace merge_lib;
    std::cout<<msg<<" ZLIB error:"<<err<<std::endl; \
    }\
 
+namespace
+{
+   // zlib keeps its window and hash tables between streams, so a used
+   // state is reset for the next object instead of being created again
+   class ZlibState
+   {
+   public:
+      ZlibState(bool deflating): _deflating(deflating), _initialized(false)
+      {
+         memset(&_stream,0,sizeof(_stream));
+      }
+      ~ZlibState()
+      {
+         _end();
+      }
+      // returns state ready for a new stream or NULL on zlib error
+      z_stream * acquire()
+      {
+         if( _initialized )
+         {
+            int err = _deflating?deflateReset(&_stream):inflateReset(&_stream);
+            ZLIB_CHECK_ERR(err, "Reset");
+            if( err == Z_OK )
+            {
+               return &_stream;
+            }
+            _end();
+         }
+         memset(&_stream,0,sizeof(_stream));
+         _stream.zalloc = (alloc_func)0;
+         _stream.zfree = (free_func)0;
+         _stream.opaque = (voidpf)0;
+         int err = _deflating?deflateInit(&_stream, Z_DEFAULT_COMPRESSION):inflateInit(&_stream);
+         ZLIB_CHECK_ERR(err, (_deflating?"deflateInit":"inflateInit"));
+         _initialized = (err == Z_OK);
+         return _initialized?&_stream:NULL;
+      }
+   private:
+      void _end()
+      {
+         if( _initialized )
+         {
+            _deflating?deflateEnd(&_stream):inflateEnd(&_stream);
+            _initialized = false;
+         }
+      }
+      z_stream _stream;
+      bool _deflating;
+      bool _initialized;
+   };
+
+   thread_local ZlibState deflateState(true);
+   thread_local ZlibState inflateState(false);
+
+   // streams are inflated here and copied out, so the capacity grown by
+   // one stream serves the next ones; a huge stream does not pin memory
+   thread_local std::string inflateBuffer;
+   const size_t MAX_KEPT_INFLATE_BUFFER = 16 * 1024 * 1024;
+}
+
 FlateDecode::FlateDecode():_predict(NULL)
 {
 }
@@ -57,6 +118,13 @@ FlateDecode::~FlateDecode()
 
 void FlateDecode::initialize(Object * objectWithStream)
 {
+   // the decoder is shared by objects, so parameters of previous one
+   // must not be applied to the current
+   if( _predict )
+   {
+      delete _predict;
+      _predict = NULL;
+   }
    if( objectWithStream )
    {
       std::string head;
@@ -73,161 +141,116 @@ void FlateDecode::initialize(Object * objectWithStream)
 
 /** @brief encode
 *
-* @todo:
-document this function
+* Compresses decoded data with default compression level and replaces
+* it with the result.
 */
 bool FlateDecode::encode(std::string &decoded)
 {   
-   z_stream stream;
-
-   stream.zalloc = (alloc_func)0;
-   stream.zfree = (free_func)0;
-   stream.opaque = (voidpf)0;
-
-   size_t out_len = 0;
-   unsigned char *out_p = NULL;
-
-   stream.next_out = out_p;
-   stream.avail_out = (uInt)out_len;
-
-   stream.next_in = (unsigned char*)decoded.c_str();
-   stream.avail_in = (uInt)decoded.size();
-
-   int err = deflateInit(&stream, Z_DEFAULT_COMPRESSION);
-   ZLIB_CHECK_ERR(err, "deflateInit");
-   if ( err != Z_OK )
+   z_stream * stream = deflateState.acquire();
+   if( !stream )
    {
       return false;
    }
-   bool toContinue = false;
-   int flush = Z_NO_FLUSH;
-   do
+   // deflateBound gives room for whole compressed data, so it is written
+   // by one call without any reallocation
+   std::string encoded;
+   encoded.resize(deflateBound(stream, (uLong)decoded.size()));
+
+   stream->next_in = (unsigned char*)decoded.data();
+   stream->avail_in = (uInt)decoded.size();
+   stream->next_out = (unsigned char*)&encoded[0];
+   stream->avail_out = (uInt)encoded.size();
+
+   int err = deflate(stream, Z_FINISH);
+   if( err != Z_STREAM_END )
    {
-      toContinue = false;
-      flush = (stream.avail_in == 0)?Z_FINISH:Z_NO_FLUSH;
-
-      if ( !stream.avail_out )
-      {
-         // increase the space
-         out_p = (unsigned char*)realloc(out_p,out_len + ZLIB_MEM_DELTA);
-
-         // init new memory
-         unsigned char *new_out_start = out_p + out_len;
-         memset(new_out_start,0,ZLIB_MEM_DELTA);
-
-         // Point next_out to the next unused byte
-         stream.next_out = new_out_start;
-
-         // Update the size of the buffer
-         stream.avail_out = (uInt)ZLIB_MEM_DELTA;
-         out_len += ZLIB_MEM_DELTA;
-      }
-
-      err = deflate(&stream,flush);
-      if ( err == Z_OK && stream.avail_out == 0 )
-      {
-         toContinue = true;
-      }
-
-   }
-   while ( toContinue || flush == Z_NO_FLUSH );
-
-   err = deflateEnd(&stream);
-   ZLIB_CHECK_ERR(err, "deflateEnd");
-   if( err != Z_OK )
-   {
-      free(out_p);
+      std::cout<<"Deflate ZLIB error:"<<err<<std::endl;
       return false;
    }
-
-   decoded = std::string((char*)out_p,stream.total_out);
-   free(out_p);
+   encoded.resize(stream->total_out);
+   decoded.swap(encoded);
    return true;
 }
 
 /** @brief decode
 *
-* @todo: document this function
+* Inflates encoded data and replaces it with the result. Predictor is
+* applied in place if object defines it.
 */
 bool FlateDecode::decode(std::string & encoded)
 {
-   z_stream stream;
-
-   //some initialization of ZLIB stuff
-   stream.zalloc = (alloc_func)0;
-   stream.zfree = (free_func)0;
-   stream.opaque = (voidpf)0;
-
-   //trace_hex((char*)encoded.c_str(),encoded.size());
+   if( !decode(std::string_view(encoded), inflateBuffer) )
+   {
+      return false;
+   }
+   encoded.assign(inflateBuffer);
+   if( inflateBuffer.capacity() > MAX_KEPT_INFLATE_BUFFER )
+   {
+      std::string().swap(inflateBuffer);
+   }
+   // if predictor exists for that object, then lets decode it
+   if( _predict )
+   {
+      _predict->decode(encoded);
+   }
 
-   stream.next_in  = (unsigned char*)encoded.c_str();
-   stream.avail_in = (uInt)encoded.size();
+   return true;
+}
 
-   int err = inflateInit(&stream);
-   ZLIB_CHECK_ERR(err,"InflateInit");
-   if ( err != Z_OK )
+bool FlateDecode::decode(std::string_view encoded, std::string & decoded)
+{
+   z_stream * stream = inflateState.acquire();
+   if( !stream )
    {
       return false;
    }
-   unsigned char *out_p = NULL;
-   int out_len = 0;
 
-   stream.next_out = out_p;
-   stream.avail_out = out_len;
+   //trace_hex(encoded.data(),encoded.size());
+
+   stream->next_in  = (unsigned char*)encoded.data();
+   stream->avail_in = (uInt)encoded.size();
+
+   // start from the usual compression ratio and double the buffer when
+   // it is full, so big streams are not copied over for every 64K
+   size_t outLen = 0;
+   size_t capacity = encoded.size() * 4;
+   if( capacity < ZLIB_MEM_DELTA )
+   {
+      capacity = ZLIB_MEM_DELTA;
+   }
+   // resizing within the capacity of a reused buffer does not allocate,
+   // it is not resized to its whole capacity to avoid clearing it
+   decoded.resize(capacity);
 
    for (;;)
    {
-      if ( !stream.avail_out)
+      if( outLen == decoded.size() )
       {
-         // there is no more space for deallocation - increase the space
-         out_p = (unsigned char*)realloc(out_p,out_len + ZLIB_MEM_DELTA);
-
-         // init new memory
-         unsigned char *new_out_start = out_p + out_len;
-         memset(new_out_start,0,ZLIB_MEM_DELTA);
-
-         // Point next_out to the next unused byte
-         stream.next_out = new_out_start;
-
-         // Update the size of the uncompressed buffer
-         stream.avail_out = (uInt)ZLIB_MEM_DELTA;
-         out_len += ZLIB_MEM_DELTA;
+         decoded.resize(decoded.size() * 2);
       }
-      err = inflate(&stream,Z_NO_FLUSH);
+      size_t chunk = decoded.size() - outLen;
+      if( chunk > UINT_MAX )
+      {
+         chunk = UINT_MAX;
+      }
+      stream->next_out = (unsigned char*)&decoded[outLen];
+      stream->avail_out = (uInt)chunk;
+
+      int err = inflate(stream,Z_NO_FLUSH);
+      outLen += chunk - stream->avail_out;
 
       if ( err == Z_STREAM_END)
       {
          break;
       }
-      ZLIB_CHECK_ERR(err,"Deflate");
+      ZLIB_CHECK_ERR(err,"Inflate");
       if ( err != Z_OK )
       {         
-         if( out_p )
-         {
-            free(out_p);
-         }
+         decoded.clear();
          return false;
       }
    }
-   err = inflateEnd(&stream);
-   ZLIB_CHECK_ERR(err,"InflateEnd");
-   if( err != Z_OK )
-   {
-      if( out_p )
-      {
-         free(out_p);
-      }
-      return false;
-   }
-   encoded = std::string((char*)out_p,stream.total_out);
-   free(out_p);
-   //    trace_hex((char*)encoded.c_str(),encoded.size());
-   // if predictor exists for that object, then lets decode it
-   if( _predict )
-   {
-      _predict->decode(encoded);
-   }
-
+   decoded.resize(outLen);
+   //    trace_hex(decoded.data(),decoded.size());
    return true;
 }
-
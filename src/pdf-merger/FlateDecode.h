@@ -32,6 +32,7 @@
 
 #include "Decoder.h"
 #include <string>
+#include <string_view>
 
 #include "Decoder.h"
 #include "FilterPredictor.h"
@@ -46,6 +47,9 @@ namespace merge_lib
          virtual ~FlateDecode();
          bool encode(std::string & decoded);
          bool decode(std::string & encoded);
+         // inflates encoded data into the caller's buffer, its capacity is
+         // reused and grown geometrically; no predictor is applied
+         bool decode(std::string_view encoded, std::string & decoded);
          void initialize(Object * objectWithStream);
       private:
          FilterPredictor *_predict;
@@ -28,17 +28,20 @@
 
 
 #include "Object.h"
+#include "ObjectSource.h"
 #include "Parser.h"
 #include "Exception.h"
 #include <string.h>
 #include <algorithm>
 #include <fstream>
+#include <vector>
 
 #include "core/memcheck.h"
 
 using namespace merge_lib;
 
 std::string NUMBERANDWHITESPACE(" 0123456789");
+const unsigned int STREAM_COPY_BUFFER_SIZE = 1048576; // = 1 Mb
 
 
 Object::~Object()
@@ -63,9 +66,12 @@ Object * Object::getClone(std::vector<Object *> & clones)
 Object * Object::_getClone(std::map<unsigned int, Object *> & clones)
 {
    _isPassed = true;
+   _load();
    unsigned int objectNumber = this->getObjectNumber();   
    Object * clone = new Object(objectNumber, this->_generationNumber, this->getObjectContent(), _fileName, _streamBounds, _hasStream);
    clone->_hasStreamInContent = _hasStreamInContent;
+   //the stream is still read from the source
+   clone->_source = _source;
    clones.insert(std::pair<unsigned int, Object *>(objectNumber, clone));
    Children::iterator currentChild = _children.begin();
 
@@ -97,6 +103,7 @@ Object * Object::_getClone(std::map<unsigned int, Object *> & clones)
 }
 void Object::addChild(Object * child, const std::vector<unsigned int> childPositionsInContent)
 {
+   _load();
    child->_addParent(this);
    _addChild(child, childPositionsInContent);
 }
@@ -104,6 +111,7 @@ void Object::addChild(Object * child, const std::vector<unsigned int> childPosit
 
 Object::ReferencePositionsInContent Object::removeChild(Object * child)
 {
+   _load();
    ReferencePositionsInContent positions = _children[child->getObjectNumber()].second;
    _children.erase(child->getObjectNumber());
    return positions;
@@ -121,12 +129,14 @@ void Object::forgetAboutChildren(unsigned int leftBound, unsigned int rightBound
 
 Object * Object::getChild(unsigned int objectNumber)
 {
+   _load();
    //TODO: check object before returning
    return _children[objectNumber].first;
 }
 
 std::vector<Object *> Object::getChildrenByBounds(unsigned int leftBound, unsigned int rightBound)
 {
+   _load();
    std::vector<Object *> result;
    for(Children::iterator currentChild = _children.begin(); currentChild != _children.end(); ++currentChild)
    {
@@ -147,6 +157,7 @@ std::vector<Object *> Object::getChildrenByBounds(unsigned int leftBound, unsign
 
 std::vector<Object *> Object::getSortedByPositionChildren(unsigned int leftBound, unsigned int rightBound)
 {
+   _load();
    std::vector<Object *> result;
    for(Children::iterator currentChild = _children.begin(); currentChild != _children.end(); ++currentChild)
    {
@@ -172,6 +183,7 @@ std::vector<Object *> Object::getSortedByPositionChildren(unsigned int leftBound
 
 unsigned int Object::getChildPosition(const Object * child)//throw (Exception)
 {
+   _load();
    const ReferencePositionsInContent & childrenPostion = _children[child->getObjectNumber()].second;
    if(
       (childrenPostion.size() != 1) ||
@@ -193,6 +205,7 @@ void Object::removeChildrenByBounds(unsigned int leftBound, unsigned int rightBo
 
 const Object::Children & Object::getChildren()
 {
+   _load();
    return _children;
 }
 
@@ -219,6 +232,7 @@ unsigned int Object::getgenerationNumber() const
 
 std::string & Object::getObjectContent()
 {
+   _load();
    return _content;
 }
 
@@ -234,16 +248,19 @@ void Object::_setObjectNumber(unsigned int objectNumber)
 
 void Object::setObjectContent(const std::string & objectContent)
 {
+   _load();
    _content = objectContent;
 }
 
 void Object::appendContent(const std::string & addToContent)
 {
+   _load();
    _content.append(addToContent);
 }
 
 void Object::eraseContent(unsigned int from, unsigned int size)
 {
+   _load();
    int iSize = size;
    _recalculateReferencePositions(from + size, -iSize);
    _content.erase(from, size);
@@ -251,12 +268,14 @@ void Object::eraseContent(unsigned int from, unsigned int size)
 
 void Object::insertToContent(unsigned int position, const std::string & insertedStr)
 {
+   _load();
    _recalculateReferencePositions(position, insertedStr.size());
    _content.insert(position, insertedStr);
 }
 
 void Object::insertToContent(unsigned int position, const char * insertedStr, unsigned int length)
 {    
+   _load();
    _recalculateReferencePositions(position, length);
    _content.insert(position, insertedStr, length);    
 }
@@ -267,20 +286,29 @@ void Object::serialize(std::ofstream & out, std::map< unsigned int, std::pair<un
    //is this element already printed
    if(sizesAndGenerationNumbers.find(_number) != sizesAndGenerationNumbers.end()) return;
 
-   std::string stream;
-   if(_hasStream && !_hasStreamInContent)
-   {       
-      getStream(stream);
-      stream.append("endstream\n");       
+   _load();
+
+   //the stream is copied from the file to the output, it is not read into memory
+   bool hasStreamInFile = _hasStream && !_hasStreamInContent;
+   unsigned long long streamSize = 0;
+   if(hasStreamInFile)
+   {
+      streamSize = (_streamBounds.second - _streamBounds.first) + strlen("endstream\n");
    }
-   // xxxx + " " + "0" + " " + "obj" + "\n" + _content.size() + "endobj\n", where x - is a digit
-   unsigned long long objectSizeForXref = (static_cast<unsigned int>(std::log10(static_cast<double>(_number))) + 1) + 14 + _content.size() + stream.size();    
+
+   // "<number> <generation> obj\n" + _content + stream + "endobj\n"
+   std::string header = Utils::uIntToStr(_number) + " " + Utils::uIntToStr(_generationNumber) + " obj\n";
+   unsigned long long objectSizeForXref = header.size() + _content.size() + streamSize + strlen("endobj\n");
 
    sizesAndGenerationNumbers.insert(std::pair<unsigned int, std::pair<unsigned long long, unsigned int > >(_number, std::make_pair(objectSizeForXref, _generationNumber)));
 
-   serialize(out, stream);
-   stream.clear();
-   stream.shrink_to_fit();
+   out << header << _content;
+   if(hasStreamInFile)
+   {
+      _serializeStream(out);
+      out << "endstream\n";
+   }
+   out << "endobj\n";
 
    //call serialize of each child
    Children::iterator it;
@@ -298,6 +326,7 @@ void Object::recalculateObjectNumbers(unsigned int & newNumber)
 
 void Object::_recalculateObjectNumbers(unsigned int & newNumber)
 {    
+   _load();
    _setObjectNumber(newNumber);
 
    Children::iterator childIterator;
@@ -372,6 +401,7 @@ void Object::_retrieveMaxObjectNumber(unsigned int & maxNumber)
 
    if(isPassed())  return;
    _isPassed = true;
+   _load();
    if(maxNumber < _number)
       maxNumber = _number;
    Children::iterator it;
@@ -382,6 +412,7 @@ void Object::_retrieveMaxObjectNumber(unsigned int & maxNumber)
 //TODO add check for absent token
 bool Object::_findObject(const std::string & token, Object* & foundObject, unsigned int & tokenPositionInContent)
 {
+   _load();
    _isPassed = true;
    tokenPositionInContent = Parser::findToken(_content,token);
    if((int)tokenPositionInContent != -1)
@@ -429,10 +460,36 @@ void Object::_addParent(Object * child)
 {
    _parents.insert(child);
 }
-void Object::serialize(std::ofstream  & out, const std::string & stream)
+//copies the stream from the mapped file, or in parts from the file
+void Object::_serializeStream(std::ofstream & out)
 {
-    out << _number << " " << _generationNumber << " obj\n" << _content << stream << "endobj\n";
-   out.flush();
+   unsigned int length = _streamBounds.second - _streamBounds.first;
+   if(_source)
+   {
+      std::string_view stream = _source->getFileContent().substr(_streamBounds.first, length);
+      out.write(stream.data(), stream.size());
+      return;
+   }
+
+   std::ifstream pdfFile;
+   pdfFile.open (_fileName.c_str(), std::ios::binary );
+   if (pdfFile.fail())
+   {
+      std::stringstream errorMessage("File ");
+      errorMessage << _fileName << " is absent" << "\0";
+      throw Exception(errorMessage);
+   }
+   pdfFile.seekg (_streamBounds.first, std::ios_base::beg);
+
+   std::vector<char> buffer(std::min(length, STREAM_COPY_BUFFER_SIZE));
+   while(length > 0)
+   {
+      unsigned int partLength = std::min(length, (unsigned int)buffer.size());
+      pdfFile.read(&buffer[0], partLength);
+      out.write(&buffer[0], partLength);
+      length -= partLength;
+   }
+   pdfFile.close();
 }
 
 /** @brief getStream
@@ -441,6 +498,7 @@ void Object::serialize(std::ofstream  & out, const std::string & stream)
 */
 bool Object::getStream(std::string & stream)
 {
+   _load();
    if(!_hasStream && !_hasStreamInContent)
       return false;
    if( _hasStream && _hasStreamInContent)
@@ -451,6 +509,12 @@ bool Object::getStream(std::string & stream)
          return false;
    }
 
+   if(_source)
+   {
+      stream.assign(_source->getFileContent().substr(_streamBounds.first, _streamBounds.second - _streamBounds.first));
+      return true;
+   }
+
    std::ifstream pdfFile;
    pdfFile.open (_fileName.c_str(), std::ios::binary );
    if (pdfFile.fail())
@@ -502,6 +566,7 @@ bool Object::_getStreamFromContent(std::string & stream)
 */
 bool Object::getHeader(std::string &content)
 {
+   _load();
    if( !hasStream() )
    {
       content = _content;
@@ -519,6 +584,7 @@ bool Object::getHeader(std::string &content)
 */
 bool Object::hasStream()
 {
+   _load();
    return _hasStream;
 }
 
@@ -607,3 +673,24 @@ Object* Object::findPatternInObjOrParents(const std::string &pattern)
    return foundObj;
 }
 
+//reads the content and the stream bounds from the file and looks up the referenced objects
+void Object::_load()
+{
+   if(_isLoaded)
+      return;
+   _isLoaded = true;
+
+   std::string_view fileContent = _source->getFileContent();
+   unsigned int endOfContent = Parser::findObjectBounds(fileContent, _contentStart, _streamBounds, _hasStream);
+   _content.assign(fileContent.substr(_contentStart, endOfContent - _contentStart));
+
+   //key - object number :  value - positions in object content of this reference
+   const std::map<unsigned int, ReferencePositionsInContent> refs = Parser::getReferences(_content);
+   std::map<unsigned int, ReferencePositionsInContent>::const_iterator refsIterator = refs.begin();
+   for(; refsIterator != refs.end(); ++refsIterator)
+   {
+      Object * child = _source->getObject((*refsIterator).first);
+      if(child)
+         addChild(child, (*refsIterator).second);
+   }
+}
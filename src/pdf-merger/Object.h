@@ -36,12 +36,15 @@
 #include <string>
 #include <fstream>
 #include <map>
+#include <memory>
 #include <set>
 #include <vector>
 #include <utility>
 
 namespace merge_lib
 {
+    class ObjectSource;
+
     //This class represents pdf objects, and defines methods for performing 
     //all necessary operations on pdf objects
     //Each object consists of two parts: content and object's number
@@ -52,6 +55,8 @@ namespace merge_lib
     //Each reference (child object) should be kept with it position(s) in object's content.
     //After each content modification, all references should be changed too.
     //This convention lighten the recalculation object numbers work.
+    //Objects of a parsed file keep only the bounds of their content in the file.
+    //The content and the children are read when the object is used first.
     class Object
     {
     public:
@@ -63,7 +68,16 @@ namespace merge_lib
            std::string fileName = "", std::pair<unsigned int, unsigned int> streamBounds = std::make_pair ((unsigned int)0,(unsigned int)0), bool hasStream = false
                   ):
        _number(objectNumber), _generationNumber(generationNumber), _oldNumber(objectNumber), _content(objectContent),_parents(),_children(),_isPassed(false),
-           _streamBounds(streamBounds), _fileName(fileName), _hasStream(hasStream), _hasStreamInContent(false)
+           _streamBounds(streamBounds), _fileName(fileName), _hasStream(hasStream), _hasStreamInContent(false),
+           _source(), _contentStart(0), _isLoaded(true)
+       {
+       }
+       Object(unsigned int objectNumber, unsigned int generationNumber, std::shared_ptr<ObjectSource> source,
+           unsigned int contentStart, std::string fileName
+                  ):
+       _number(objectNumber), _generationNumber(generationNumber), _oldNumber(objectNumber), _content(),_parents(),_children(),_isPassed(false),
+           _streamBounds(0, 0), _fileName(fileName), _hasStream(false), _hasStreamInContent(false),
+           _source(source), _contentStart(contentStart), _isLoaded(false)
        {
        }
        virtual ~Object();
@@ -130,6 +144,7 @@ namespace merge_lib
        bool getHeader(std::string &content);
        void forgetStreamInFile()
        {
+            _load();
             _hasStreamInContent = true;
             _hasStream = true;
        }
@@ -152,12 +167,13 @@ namespace merge_lib
        void _setObjectNumber(unsigned int objectNumber);       
        void _addParent(Object * child);
        bool _findObject(const std::string & token, Object* & foundObject, unsigned int & tokenPositionInContent);
-       void serialize(std::ofstream  & out, const std::string & stream);
+       void _serializeStream(std::ofstream & out);
        void _recalculateObjectNumbers(unsigned int & maxNumber);
        void _recalculateReferencePositions(unsigned int changedReference, int displacement);
        void _retrieveMaxObjectNumber(unsigned int & maxNumber);
        void serialize(std::ofstream & out, std::map<unsigned int, unsigned long long> & sizes);
        bool _getStreamFromContent(std::string & stream);
+       void _load();
 
        //members
        unsigned int                          _number;
@@ -171,6 +187,9 @@ namespace merge_lib
        std::string                           _fileName;
        bool                                  _hasStream;
        bool                                  _hasStreamInContent;
+       std::shared_ptr<ObjectSource>         _source;
+       unsigned int                          _contentStart;
+       bool                                  _isLoaded;
 
     };
 }
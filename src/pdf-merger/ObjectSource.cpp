@@ -0,0 +1,91 @@
+/*
+ * Copyright (C) 2015-2022 Département de l'Instruction Publique (DIP-SEM)
+ *
+ * Copyright (C) 2013 Open Education Foundation
+ *
+ * Copyright (C) 2010-2013 Groupement d'Intérêt Public pour
+ * l'Education Numérique en Afrique (GIP ENA)
+ *
+ * This file is part of OpenBoard.
+ *
+ * OpenBoard is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3 of the License,
+ * with a specific linking exception for the OpenSSL project's
+ * "OpenSSL" library (or with modified versions of it that use the
+ * same license as the "OpenSSL" library).
+ *
+ * OpenBoard is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with OpenBoard. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+
+
+
+
+
+#include "ObjectSource.h"
+#include "Exception.h"
+
+#include <QFile>
+
+#include <climits>
+
+#include "core/memcheck.h"
+
+using namespace merge_lib;
+
+ObjectSource::ObjectSource(const char * fileName):
+   _file(new QFile(QFile::decodeName(fileName))), _buffer(), _fileContent(), _objects()
+{
+   if(!_file->open(QIODevice::ReadOnly))
+   {
+      std::stringstream errorMessage;
+      errorMessage << "File " << fileName << " is absent";
+      throw Exception(errorMessage);
+   }
+
+   //offsets in the file are kept in 32 bits
+   qint64 size = _file->size();
+   if(size > UINT_MAX)
+   {
+      std::stringstream errorMessage;
+      errorMessage << "File " << fileName << " is too large for merge library";
+      throw Exception(errorMessage);
+   }
+
+   uchar * mapped = size > 0 ? _file->map(0, size) : NULL;
+   if(mapped)
+   {
+      _fileContent = std::string_view(reinterpret_cast<const char *>(mapped), size);
+      return;
+   }
+
+   //the file system does not support mapping
+   _buffer.resize(size);
+   if(size > 0 && _file->read(&_buffer[0], size) != size)
+   {
+      std::stringstream errorMessage;
+      errorMessage << "File " << fileName << " cannot be read";
+      throw Exception(errorMessage);
+   }
+   _file->close();
+   _fileContent = _buffer;
+}
+
+ObjectSource::~ObjectSource()
+{
+   _objects.clear();
+}
+
+Object * ObjectSource::getObject(unsigned int objectNumber) const
+{
+   std::map<unsigned int, Object *>::const_iterator it = _objects.find(objectNumber);
+   return it == _objects.end() ? NULL : (*it).second;
+}
@@ -0,0 +1,79 @@
+/*
+ * Copyright (C) 2015-2022 Département de l'Instruction Publique (DIP-SEM)
+ *
+ * Copyright (C) 2013 Open Education Foundation
+ *
+ * Copyright (C) 2010-2013 Groupement d'Intérêt Public pour
+ * l'Education Numérique en Afrique (GIP ENA)
+ *
+ * This file is part of OpenBoard.
+ *
+ * OpenBoard is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3 of the License,
+ * with a specific linking exception for the OpenSSL project's
+ * "OpenSSL" library (or with modified versions of it that use the
+ * same license as the "OpenSSL" library).
+ *
+ * OpenBoard is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with OpenBoard. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+
+
+
+
+
+#if !defined ObjectSource_h
+#define ObjectSource_h
+
+#include <map>
+#include <memory>
+#include <string>
+#include <string_view>
+
+class QFile;
+
+namespace merge_lib
+{
+   class Object;
+
+   //This class holds the content of a parsed pdf file.
+   //The file is memory-mapped when possible, otherwise it is read.
+   //Objects of the file keep the bounds of their content and read it,
+   //and look up the objects they refer to, only when the merger uses them.
+   class ObjectSource
+   {
+   public:
+      ObjectSource(const char * fileName); //throw (Exception)
+      ~ObjectSource();
+
+      std::string_view getFileContent() const
+      {
+         return _fileContent;
+      }
+
+      void setObjects(const std::map<unsigned int, Object *> & objects)
+      {
+         _objects = objects;
+      }
+      Object * getObject(unsigned int objectNumber) const;
+
+   private:
+      ObjectSource(const ObjectSource & copy);
+
+      //members
+      std::unique_ptr<QFile>           _file;
+      std::string                      _buffer;
+      std::string_view                 _fileContent;
+      //objects are owned by their document
+      std::map<unsigned int, Object *> _objects;
+   };
+}
+#endif
@@ -136,8 +136,9 @@ void OverlayDocumentParser::_getPartOfFileContent(long startOfPart, unsigned int
    else 
       dir = ios_base::end;
    pdfFile.seekg (startOfPart, dir);
-   _fileContent.resize(length);
-   pdfFile.read(&_fileContent[0], length);
+   _fileBuffer.resize(length);
+   pdfFile.read(&_fileBuffer[0], length);
+   _fileContent = _fileBuffer;
    pdfFile.close();
 }
 
@@ -147,21 +148,21 @@ void OverlayDocumentParser::_readXref(std::map<unsigned int, unsigned long> & ob
    unsigned int startOfStartxref = _fileContent.find("startxref");
    unsigned int startOfNumber = _fileContent.find_first_of(Parser::NUMBERS, startOfStartxref);
    unsigned int endOfNumber = _fileContent.find_first_not_of(Parser::NUMBERS, startOfNumber + 1);
-   std::string startXref = _fileContent.substr(startOfNumber, endOfNumber - startOfNumber);
+   std::string startXref(_fileContent.substr(startOfNumber, endOfNumber - startOfNumber));
    unsigned int strtXref = Utils::stringToInt(startXref);
 
    unsigned int sizeOfXref = Utils::getFileSize(_fileName.c_str()) - strtXref;
    _getPartOfFileContent(strtXref, sizeOfXref);
    unsigned int leftBoundOfObjectNumber = _fileContent.find("0 ") + strlen("0 ");
    unsigned int rightBoundOfObjectNumber = _fileContent.find_first_not_of(Parser::NUMBERS, leftBoundOfObjectNumber);
-   std::string objectNuberStr = _fileContent.substr(leftBoundOfObjectNumber, rightBoundOfObjectNumber - leftBoundOfObjectNumber);
+   std::string objectNuberStr(_fileContent.substr(leftBoundOfObjectNumber, rightBoundOfObjectNumber - leftBoundOfObjectNumber));
    unsigned long objectNumber = Utils::stringToInt(objectNuberStr);
    unsigned int startOfObjectPosition = _fileContent.find("0000000000 65535 f ") + strlen("0000000000 65535 f ");
    for(unsigned long i = 1; i < objectNumber; ++i)
    {
       startOfObjectPosition = _fileContent.find_first_of(Parser::NUMBERS, startOfObjectPosition);
       unsigned int endOfObjectPostion = _fileContent.find(" 00000 n", startOfObjectPosition);
-      std::string objectPostionStr = _fileContent.substr(startOfObjectPosition, endOfObjectPostion - startOfObjectPosition);
+      std::string objectPostionStr(_fileContent.substr(startOfObjectPosition, endOfObjectPostion - startOfObjectPosition));
       objectsAndSizes[i] = Utils::stringToInt(objectPostionStr);
       startOfObjectPosition = endOfObjectPostion + strlen(" 00000 n");
    }
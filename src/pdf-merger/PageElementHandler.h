@@ -45,7 +45,7 @@ namespace merge_lib
    {
    public:
 
-      PageElementHandler(Object * page): _page(page), _pageContent(page->_content), _nextHandler(0)
+      PageElementHandler(Object * page): _page(page), _pageContent(page->getObjectContent()), _nextHandler(0)
       {
          _createAllPageFieldsSet();
       }
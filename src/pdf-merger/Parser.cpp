@@ -36,6 +36,7 @@
 #include <string.h>
 #include "Parser.h"
 #include "Object.h"
+#include "ObjectSource.h"
 #include "Exception.h"
 #include "Utils.h"
 
@@ -105,39 +106,37 @@ void Parser::_createDocument(const char * docName)
       throw Exception("Some document is wrong");
    _retrieveAllPages(objectWithKids[0]);
 
-   _root->retrieveMaxObjectNumber(_document->_maxObjectNumber);
+   if(_source)
+   {
+      //the largest number in the xref, objects are not read for it
+      if(!_objects.empty())
+         _document->_maxObjectNumber = (*_objects.rbegin()).first;
+   }
+   else
+      _root->retrieveMaxObjectNumber(_document->_maxObjectNumber);
    _clearParser();
 }
 
 void Parser::_clearParser()
 {
    _root = 0;
-   _fileContent.clear();
-   _fileContent.shrink_to_fit();
+   _fileContent = std::string_view();
+   _fileBuffer.clear();
+   _fileBuffer.shrink_to_fit();
+   _source.reset();
    _objects.clear();
 }
 
 
 void Parser::_getFileContent(const char * fileName)
 {
-   ifstream pdfFile;
-   pdfFile.open (fileName, ios::binary );
-   if (pdfFile.fail())
-   {
-      stringstream errorMessage("File ");
-      errorMessage << fileName << " is absent" << "\0";
-      throw Exception(errorMessage);
-   }
-   // get length of file:
-   pdfFile.seekg (0, ios::end);
-   int length = pdfFile.tellg();
-   pdfFile.seekg (0, ios::beg);
-   _fileContent.resize(length);
-   pdfFile.read(&_fileContent[0], length);
+   //the objects keep the source, the file stays mapped as long as they are used
+   _source = std::make_shared<ObjectSource>(fileName);
+   _fileContent = _source->getFileContent();
 
    // check version
    const char *header = "%PDF-1.";
-   size_t verPos = _fileContent.find(header);
+   size_t verPos = _fileContent.substr(0, strlen(header)).find(header);
    if( verPos == 0 )
    {
       verPos += strlen(header);
@@ -160,7 +159,6 @@ void Parser::_getFileContent(const char * fileName)
    {
       throw Exception("Unrecognized header of PDF file");
    }
-   pdfFile.close();
 }
 
 
@@ -172,6 +170,8 @@ void Parser::_createObjectTree(const char * fileName)
       _getFileContent(fileName);
       _readXRefAndCreateObjects();
       rootObjectNumber = _readTrailerAndReturnRoot();
+      if(_source)
+         _source->setObjects(_objects);
    }
    catch (std::exception &)
    {
@@ -190,9 +190,12 @@ void Parser::_createObjectTree(const char * fileName)
    {
       Object * currentObject = (*objectsIterator).second;
       _document->_allObjects.push_back(currentObject);
+      //objects read from the source look up their children when they are used
+      if(_source)
+         continue;
       //key - object number :  value - positions in object content of this reference
       const std::map<unsigned int, Object::ReferencePositionsInContent> & refs = 
-         _getReferences(currentObject->getObjectContent());      
+         getReferences(currentObject->getObjectContent());      
       std::map<unsigned int, Object::ReferencePositionsInContent>::const_iterator refsIterator = refs.begin();
       for(; refsIterator !=  refs.end(); ++refsIterator)
       {        
@@ -204,7 +207,7 @@ void Parser::_createObjectTree(const char * fileName)
 
 }
 
-const std::map<unsigned int, Object::ReferencePositionsInContent> & Parser::_getReferences(const std::string & objectContent)
+const std::map<unsigned int, Object::ReferencePositionsInContent> & Parser::getReferences(const std::string & objectContent)
 {
    unsigned int currentPosition(0), startOfNextSearch(0);
    static std::map<unsigned int, std::vector<unsigned int> >  searchResult;
@@ -321,13 +324,12 @@ void Parser::_readXRefAndCreateObjects()
 
                   try               
                   {
-                     std::pair<unsigned int, unsigned int> streamBounds;
-                     bool hasObjectStream;
                      unsigned int generationNumber;
-                     const std::string content = _getObjectContent(first, objectNumber, generationNumber, streamBounds, hasObjectStream);
+                     //only the header is read, the object reads its content when it is used
+                     unsigned int contentStart = _getObjectContentStart(first, objectNumber, generationNumber);
                      if(!_objects.count(objectNumber))
                      {
-                        Object * newObject = new Object(objectNumber, generationNumber, content, _document->_documentName ,streamBounds, hasObjectStream);
+                        Object * newObject = new Object(objectNumber, generationNumber, _source, contentStart, _document->_documentName);
                         _objects[objectNumber] = newObject;
                      }
                   }
@@ -371,7 +373,7 @@ unsigned int Parser::_getStartOfXrefWithRoot()
 
    unsigned int rightBoundOfStartOfXref = _fileContent.find_first_not_of(NUMBERS, leftBoundOfStartOfXref + 1);
 
-   std::string  startOfXref = _fileContent.substr(leftBoundOfStartOfXref, rightBoundOfStartOfXref - leftBoundOfStartOfXref);
+   std::string  startOfXref(_fileContent.substr(leftBoundOfStartOfXref, rightBoundOfStartOfXref - leftBoundOfStartOfXref));
    int integerStartOfXref = Utils::stringToInt(startOfXref);
    return integerStartOfXref;
 }
@@ -454,7 +456,20 @@ unsigned int Parser::_skipWhiteSpacesFromContent(unsigned int fromPosition)
 
 const std::string & Parser::_getObjectContent(unsigned int objectPosition, unsigned int & objectNumber, unsigned int & generationNumber, std::pair<unsigned int, unsigned int> & streamBounds, bool & hasObjectStream)
 {
-   hasObjectStream = false;
+   unsigned int contentStart = _getObjectContentStart(objectPosition, objectNumber, generationNumber);
+   unsigned int endOfContent = findObjectBounds(_fileContent, contentStart, streamBounds, hasObjectStream);
+
+   static std::string objectContent;
+
+   unsigned int contentSize = endOfContent - contentStart;
+   objectContent.resize(contentSize);
+   memcpy(&objectContent[0], &_fileContent[contentStart], contentSize);
+   return objectContent;
+}
+
+//reads the "<number> <generation> obj" header, returns the position of the content
+unsigned int Parser::_getObjectContentStart(unsigned int objectPosition, unsigned int & objectNumber, unsigned int & generationNumber)
+{
    unsigned int currentPosition = objectPosition;
 
    std::string token = _getNextToken(currentPosition);  // number of object
@@ -472,8 +487,6 @@ const std::string & Parser::_getObjectContent(unsigned int objectPosition, unsig
       throw Exception(strOut.str());
    }
 
-   static std::string objectContent;
-
    size_t contentStart = _fileContent.find_first_not_of(Parser::WHITESPACES,currentPosition);
    if((int) contentStart == -1 )
    {
@@ -481,76 +494,108 @@ const std::string & Parser::_getObjectContent(unsigned int objectPosition, unsig
       strOut<<"Wrong object "<< objectNumber<< "in PDF, cannot find content for it\n";
       throw Exception(strOut.str());
    }
-   currentPosition = contentStart;
-   unsigned int endOfContent = _fileContent.find("endobj", contentStart);
+   return contentStart;
+}
+
+//Method returns the end of the object content, which is the beginning of the stream
+//for objects with a stream, and the bounds of the stream.
+//The stream data is not scanned when the stream has a direct /Length.
+unsigned int Parser::findObjectBounds(std::string_view fileContent, unsigned int contentStart, std::pair<unsigned int, unsigned int> & streamBounds, bool & hasObjectStream)
+{
+   hasObjectStream = false;
+   std::string stream("stream");
+   std::string endobj("endobj");
+
+   //the object has a stream if "stream" comes before "endobj"
+   unsigned int endOfContent = -1;
+   unsigned int currentPosition = contentStart;
+   while(1)
+   {
+      currentPosition = fileContent.find_first_of("se", currentPosition);
+      if((int) currentPosition == -1 )
+      {
+         break;
+      }
+      if( fileContent.compare(currentPosition, stream.size(), stream) == 0 )
+      {
+         hasObjectStream = true;
+         endOfContent = currentPosition;
+         break;
+      }
+      if( fileContent.compare(currentPosition, endobj.size(), endobj) == 0 )
+      {
+         endOfContent = currentPosition;
+         break;
+      }
+      ++currentPosition;
+   }
    if((int) endOfContent == -1 )
    {
       stringstream errorMessage("Corrupted PDF file, obj does not have matching endobj");
       throw Exception(errorMessage);
    }
-   unsigned int endOfStream = _fileContent.find("endstream", currentPosition);
-   if(((int)endOfStream != -1) && (endOfStream < endOfContent))
+   if( !hasObjectStream )
    {
-      std::string stream("stream");
-      unsigned int beginOfStream = _fileContent.find(stream, currentPosition) + stream.size();
-      while(_fileContent[beginOfStream] == '\r')
-      {
-         ++beginOfStream;
-      }
-      if( _fileContent[beginOfStream] == '\n')
-      {
-         ++beginOfStream;
-      }
-      streamBounds.first = beginOfStream;
+      return endOfContent;
+   }
+
+   unsigned int beginOfStream = endOfContent + stream.size();
+   while(beginOfStream < fileContent.size() && fileContent[beginOfStream] == '\r')
+   {
+      ++beginOfStream;
+   }
+   if(beginOfStream < fileContent.size() && fileContent[beginOfStream] == '\n')
+   {
+      ++beginOfStream;
+   }
+   streamBounds.first = beginOfStream;
 
-      // try to use Length field to determine end of stream.
-      std::string lengthToken = "/Length";
-      size_t lengthBegin = Parser::findTokenName(_fileContent,lengthToken,contentStart);
-      if ((int) lengthBegin != -1 )
+   unsigned int endOfStream = -1;
+   // try to use Length field to determine end of stream.
+   std::string_view dictionary = fileContent.substr(0, endOfContent);
+   std::string lengthToken = "/Length";
+   size_t lengthBegin = Parser::findTokenName(dictionary,lengthToken,contentStart);
+   if ((int) lengthBegin != -1 )
+   {
+      std::string lengthStr;
+      size_t lenPos = lengthBegin + lengthToken.size();
+      bool useContentLength = false;
+      if( Parser::getNextWord(lengthStr,dictionary,lenPos) )
       {
-         std::string lengthStr;
-         size_t lenPos = lengthBegin + lengthToken.size();
-         bool useContentLength = false;
-         if( Parser::getNextWord(lengthStr,_fileContent,lenPos) )
+         useContentLength = true;
+         std::string refStr;
+         if( Parser::getNextWord(refStr,dictionary,lenPos))
          {
-            useContentLength = true;
-            std::string refStr;
-            if( Parser::getNextWord(refStr,_fileContent,lenPos))
+            if( Parser::getNextWord(refStr,dictionary,lenPos))
             {
-               if( Parser::getNextWord(refStr,_fileContent,lenPos))
+               if( refStr == "R" )
                {
-                  if( refStr == "R" )
-                  {
-                     useContentLength = false;
-                     //it is reference
-                  }
+                  useContentLength = false;
+                  //it is reference
                }
             }
          }
-         if( useContentLength )
-         {
-            std::stringstream strin(lengthStr);
-            unsigned int streamEnd = 0;
-            strin>>streamEnd;
-            streamEnd += beginOfStream;
-            unsigned int streamEndBegin = _fileContent.find("endstream",streamEnd);
-            if((int) streamEndBegin != -1 )
-            {
-               endOfStream = streamEndBegin;
-            }
-         }
       }
-      streamBounds.second = endOfStream;
-      endOfContent = beginOfStream;
-      hasObjectStream = true;
-
+      if( useContentLength )
+      {
+         std::stringstream strin(lengthStr);
+         unsigned int streamEnd = 0;
+         strin>>streamEnd;
+         streamEnd += beginOfStream;
+         endOfStream = fileContent.find("endstream",streamEnd);
+      }
    }
-   unsigned int contentSize = endOfContent - currentPosition;
-
-   objectContent.resize(contentSize);
-   memcpy(&objectContent[0], &_fileContent[currentPosition], contentSize);
-   return objectContent;
-
+   if((int) endOfStream == -1 )
+   {
+      endOfStream = fileContent.find("endstream", beginOfStream);
+   }
+   if((int) endOfStream == -1 )
+   {
+      stringstream errorMessage("Corrupted PDF file, stream does not have matching endstream");
+      throw Exception(errorMessage);
+   }
+   streamBounds.second = endOfStream;
+   return beginOfStream;
 }
 
 unsigned int Parser::_readTrailerAndReturnRoot()
@@ -573,7 +618,7 @@ unsigned int Parser::_readTrailerAndReturnRoot()
    while((int)NUMBERS.find(_fileContent[endOfRoot++]) != -1)
    {}
    --endOfRoot;
-   return Utils::stringToInt(_fileContent.substr(startOfRoot, endOfRoot - startOfRoot));   
+   return Utils::stringToInt(std::string(_fileContent.substr(startOfRoot, endOfRoot - startOfRoot)));   
 }
 
 unsigned int Parser::_readTrailerAndRterievePrev(const unsigned int startPositionForSearch, unsigned int & previosXref)
@@ -584,8 +629,8 @@ unsigned int Parser::_readTrailerAndRterievePrev(const unsigned int startPositio
       throw Exception("Cannot find trailer!");
    }
 
-   unsigned int startOfPrev = _fileContent.find("Prev ", startOfTrailer);
    unsigned int startxref = _fileContent.find("startxref", startOfTrailer);
+   unsigned int startOfPrev = _fileContent.substr(0, startxref).find("Prev ", startOfTrailer);
    if((int)startOfPrev == -1 || (startOfPrev > startxref))
       return false;
    //"Prev "s length = 5
@@ -596,14 +641,14 @@ unsigned int Parser::_readTrailerAndRterievePrev(const unsigned int startPositio
    while((int)NUMBERS.find(_fileContent[endOfPrev++]) != -1)
    {}
    --endOfPrev;
-   previosXref = Utils::stringToInt(_fileContent.substr(startOfPrev, endOfPrev - startOfPrev));   
+   previosXref = Utils::stringToInt(std::string(_fileContent.substr(startOfPrev, endOfPrev - startOfPrev)));   
    return true;
 }
 
 //Method finds the token from current position from string
 // It uses PDF whitespaces and delimeters to recognize
 // Returned string without begin/end spaces
-std::string Parser::getNextToken(const std::string &str, unsigned int  &position)
+std::string Parser::getNextToken(std::string_view str, unsigned int  &position)
 {
    if( position >= str.size() )
    {
@@ -623,7 +668,7 @@ std::string Parser::getNextToken(const std::string &str, unsigned int  &position
    }
    position = end_pos;
 
-   std::string out = str.substr(beg_pos,end_pos - beg_pos);
+   std::string out(str.substr(beg_pos,end_pos - beg_pos));
    Parser::trim(out);
    return out;
 }
@@ -632,7 +677,7 @@ std::string Parser::getNextToken(const std::string &str, unsigned int  &position
 * method finds and returns next word from the string
 * For example: " 1 0 R \n" will return "1" , then "0" then "R"
 */
-bool Parser::getNextWord(std::string &out, const std::string &str, size_t &nextPosition, size_t  *found)
+bool Parser::getNextWord(std::string &out, std::string_view str, size_t &nextPosition, size_t  *found)
 {
    if( found )
    {
@@ -684,7 +729,7 @@ void Parser::trim(std::string &str)
 
 // Method tries to find the PDF token from the content 
 // The token is "/L 12 0R" or /Length 123
-std::string Parser::findTokenStr(const std::string &content, const std::string &pattern, size_t start, size_t &foundStart, size_t &foundEnd)
+std::string Parser::findTokenStr(std::string_view content, const std::string &pattern, size_t start, size_t &foundStart, size_t &foundEnd)
 {
    size_t cur_pos  = Parser::findToken(content,pattern,start);
    if((int) cur_pos == -1 )
@@ -699,7 +744,7 @@ std::string Parser::findTokenStr(const std::string &content, const std::string &
    {
       end_pos = content.size();
    }
-   std::string token = content.substr(cur_pos,end_pos-cur_pos);
+   std::string token(content.substr(cur_pos,end_pos-cur_pos));
    foundEnd = end_pos -1;
    return token;
 }
@@ -710,7 +755,7 @@ std::string Parser::findTokenStr(const std::string &content, const std::string &
 // contains token but not euqal to it
 // Example: content "/Transparency/ ..." pattern "/Trans
 //          will return npos.
-size_t Parser::findToken(const std::string &content, const std::string &keyword,size_t start)
+size_t Parser::findToken(std::string_view content, const std::string &keyword,size_t start)
 {
    size_t cur_pos  = start;
    // lets find pattern first
@@ -749,7 +794,7 @@ size_t Parser::findToken(const std::string &content, const std::string &keyword,
 // /H /P /P 12 0 R
 // the tag /P can be a name (and a value also), while 12 cannot
 // start defines the position of token content
-bool Parser::tokenIsAName(const std::string &content, size_t start )
+bool Parser::tokenIsAName(std::string_view content, size_t start )
 {
    std::string openBraces = "<[({";
    bool found = false;
@@ -796,7 +841,7 @@ bool Parser::tokenIsAName(const std::string &content, size_t start )
 // For example, the string contains /H /P /P 12 0 R.
 // If search for /P then it will return position of /P 12 0 R, not value of 
 // /H /P
-size_t Parser::findTokenName(const std::string &content, const std::string &keyword,size_t start)
+size_t Parser::findTokenName(std::string_view content, const std::string &keyword,size_t start)
 {
    size_t cur_pos  = start;
    // lets find pattern first
@@ -34,7 +34,9 @@
 #include "Document.h"
 #include "Page.h"
 
+#include <memory>
 #include <string>
+#include <string_view>
 #include <vector>
 
 
@@ -42,12 +44,16 @@ namespace merge_lib
 {
    class Document;
 
+   class ObjectSource;
+
    //This class parsed the pdf document and creates
    //an Document object
+   //The file is memory-mapped, objects are created from the xref
+   //and read their content when they are used.
    class Parser
    {
    public:   
-      Parser(): _root(0), _fileContent(), _objects(), _document(0)  {};
+      Parser(): _root(0), _fileContent(), _fileBuffer(), _source(), _objects(), _document(0)  {};
       Document * parseDocument(const char * fileName);
 
       static const std::string WHITESPACES;
@@ -55,17 +61,21 @@ namespace merge_lib
       static const std::string NUMBERS;
       static const std::string WHITESPACES_AND_DELIMETERS;
 
-      static bool getNextWord(std::string & out, const std::string &in, size_t &nextPosition,size_t *found = NULL);
-      static std::string getNextToken( const std::string &in, unsigned &position);
+      static bool getNextWord(std::string & out, std::string_view in, size_t &nextPosition,size_t *found = NULL);
+      static std::string getNextToken(std::string_view in, unsigned &position);
       static void trim(std::string &str);
-      static std::string findTokenStr(const std::string &content, const std::string &pattern, size_t start,size_t &foundStart, size_t &foundEnd); 
+      static std::string findTokenStr(std::string_view content, const std::string &pattern, size_t start,size_t &foundStart, size_t &foundEnd); 
 
-      static size_t findToken(const std::string &content, const std::string &keyword,size_t start = 0);
-      static size_t findTokenName(const std::string &content, const std::string &keyword,size_t start = 0);
+      static size_t findToken(std::string_view content, const std::string &keyword,size_t start = 0);
+      static size_t findTokenName(std::string_view content, const std::string &keyword,size_t start = 0);
       static unsigned int findEndOfElementContent(const std::string &content, unsigned int startOfPageElement);
-      static bool tokenIsAName(const std::string &content, size_t start );
+      static bool tokenIsAName(std::string_view content, size_t start );
+      //key - object number :  value - positions in object content of this reference
+      static const std::map<unsigned int, Object::ReferencePositionsInContent> & getReferences(const std::string & objectContent);
+      static unsigned int findObjectBounds(std::string_view fileContent, unsigned int contentStart, std::pair<unsigned int, unsigned int> & streamBounds, bool & hasObjectStream);
    protected:
       const std::string &                           _getObjectContent(unsigned int objectPosition, unsigned int & objectNumber, unsigned int & generationNumber, std::pair<unsigned int, unsigned int> &, bool &);
+      unsigned int                                  _getObjectContentStart(unsigned int objectPosition, unsigned int & objectNumber, unsigned int & generationNumber);
       virtual unsigned int                          _readTrailerAndReturnRoot();
    private:
       //methods
@@ -82,8 +92,7 @@ namespace merge_lib
       unsigned int                                  _countTokens(unsigned int leftBound, unsigned int rightBount);
       unsigned int                                  _skipWhiteSpaces(const std::string & str);
       unsigned int                                  _skipWhiteSpacesFromContent(unsigned int fromPosition);
-      const std::map<unsigned int, Object::ReferencePositionsInContent> & _getReferences(const std::string & objectContent);
-      unsigned int                                  _skipNumber(const std::string & str, unsigned int currentPosition);      
+      static unsigned int                           _skipNumber(const std::string & str, unsigned int currentPosition);      
       unsigned int                                  _skipWhiteSpaces(const std::string & str, unsigned int fromPosition);
       void                                          _createDocument(const char * docName);      
       virtual unsigned int                          _getStartOfXrefWithRoot();
@@ -95,7 +104,10 @@ namespace merge_lib
 
       //members
       Object *                         _root;
-      std::string                      _fileContent;
+      std::string_view                 _fileContent;
+      //owns the content read by derived parsers
+      std::string                      _fileBuffer;
+      std::shared_ptr<ObjectSource>    _source;
       std::map<unsigned int, Object *> _objects;
       Document *                       _document;
       
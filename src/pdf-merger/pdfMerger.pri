@@ -19,6 +19,7 @@ HEADERS += \
 	src/pdf-merger/MergePageDescription.h \
 	src/pdf-merger/Merger.h \
 	src/pdf-merger/Object.h \
+	src/pdf-merger/ObjectSource.h \
 	src/pdf-merger/Page.h \
 	src/pdf-merger/PageElementHandler.h \
 	src/pdf-merger/PageParser.h \
@@ -46,6 +47,7 @@ SOURCES += \
 	src/pdf-merger/LZWDecode.cpp \
 	src/pdf-merger/Merger.cpp \
 	src/pdf-merger/Object.cpp \
+	src/pdf-merger/ObjectSource.cpp \
 	src/pdf-merger/Page.cpp \
 	src/pdf-merger/PageElementHandler.cpp \
 	src/pdf-merger/Parser.cpp \
@@ -0,0 +1,188 @@
+/*
+ * Copyright (C) 2015-2022 Département de l'Instruction Publique (DIP-SEM)
+ *
+ * Copyright (C) 2013 Open Education Foundation
+ *
+ * Copyright (C) 2010-2013 Groupement d'Intérêt Public pour
+ * l'Education Numérique en Afrique (GIP ENA)
+ *
+ * This file is part of OpenBoard.
+ *
+ * OpenBoard is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3 of the License,
+ * with a specific linking exception for the OpenSSL project's
+ * "OpenSSL" library (or with modified versions of it that use the
+ * same license as the "OpenSSL" library).
+ *
+ * OpenBoard is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with OpenBoard. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+
+
+
+
+
+#include "PDFRenderPool.h"
+
+#include <QtConcurrent>
+
+#include "XPDFRenderer.h"
+
+#include "core/memcheck.h"
+
+namespace
+{
+    // jobs not requested again during this time are stale
+    const qint64 sStaleJobTimeout = 1000;
+}
+
+PDFRenderPool* PDFRenderPool::pool()
+{
+    static PDFRenderPool sPool;
+    return &sPool;
+}
+
+PDFRenderPool::PDFRenderPool()
+    : mWorkers(0)
+{
+    mThreadPool.setMaxThreadCount(qMax(1, QThread::idealThreadCount()));
+    mClock.start();
+}
+
+int PDFRenderPool::maxThreadCount() const
+{
+    return mThreadPool.maxThreadCount();
+}
+
+void PDFRenderPool::request(XPDFRenderer* renderer, const PDFTileCache::Key& key, double dpi, const QRect& slice, Priority priority)
+{
+    QList<XPDFRenderer*> staleRenderers;
+
+    {
+        QMutexLocker locker(&mMutex);
+
+        const qint64 now = mClock.elapsed();
+        bool queued = false;
+
+        for (int i = 0; i < mQueue.size() && !queued; ++i)
+        {
+            Job& job = mQueue[i];
+
+            if (job.renderer == renderer && job.key == key)
+            {
+                job.priority = qMin(job.priority, priority);
+                job.requested = now;
+                queued = true;
+            }
+        }
+
+        if (!queued)
+        {
+            mQueue << Job{renderer, key, dpi, slice, priority, now};
+        }
+
+        if (priority == VisibleTile)
+        {
+            staleRenderers = dropStaleJobs();
+        }
+
+        if (mWorkers < mThreadPool.maxThreadCount() && mWorkers < mQueue.size())
+        {
+            ++mWorkers;
+            QtConcurrent::run(&mThreadPool, [this](){
+                work();
+            });
+        }
+    }
+
+    // still displayed pages request their tiles again when painted
+    foreach(XPDFRenderer* staleRenderer, staleRenderers)
+    {
+        QMetaObject::invokeMethod(staleRenderer, "signalUpdateParent", Qt::QueuedConnection);
+    }
+}
+
+void PDFRenderPool::cancel(XPDFRenderer* renderer)
+{
+    QMutexLocker locker(&mMutex);
+
+    for (auto it = mQueue.begin(); it != mQueue.end(); )
+    {
+        if (it->renderer == renderer)
+            it = mQueue.erase(it);
+        else
+            ++it;
+    }
+
+    while (mRunning.value(renderer) > 0)
+    {
+        mJobFinished.wait(&mMutex);
+    }
+
+    mRunning.remove(renderer);
+}
+
+void PDFRenderPool::work()
+{
+    QMutexLocker locker(&mMutex);
+
+    while (!mQueue.isEmpty())
+    {
+        // highest priority, most recently requested first
+        int next = 0;
+
+        for (int i = 1; i < mQueue.size(); ++i)
+        {
+            const Job& job = mQueue.at(i);
+            const Job& best = mQueue.at(next);
+
+            if (job.priority < best.priority || (job.priority == best.priority && job.requested >= best.requested))
+                next = i;
+        }
+
+        const Job job = mQueue.takeAt(next);
+        ++mRunning[job.renderer];
+
+        locker.unlock();
+        job.renderer->renderTile(job.key, job.dpi, job.slice);
+        QMetaObject::invokeMethod(job.renderer, "signalUpdateParent", Qt::QueuedConnection);
+        locker.relock();
+
+        --mRunning[job.renderer];
+        mJobFinished.wakeAll();
+    }
+
+    --mWorkers;
+}
+
+QList<XPDFRenderer*> PDFRenderPool::dropStaleJobs()
+{
+    // called with mMutex locked
+    QList<XPDFRenderer*> renderers;
+    const qint64 staleTime = mClock.elapsed() - sStaleJobTimeout;
+
+    for (auto it = mQueue.begin(); it != mQueue.end(); )
+    {
+        if (it->requested < staleTime)
+        {
+            if (!renderers.contains(it->renderer))
+                renderers << it->renderer;
+
+            it = mQueue.erase(it);
+        }
+        else
+        {
+            ++it;
+        }
+    }
+
+    return renderers;
+}
@@ -0,0 +1,105 @@
+/*
+ * Copyright (C) 2015-2022 Département de l'Instruction Publique (DIP-SEM)
+ *
+ * Copyright (C) 2013 Open Education Foundation
+ *
+ * Copyright (C) 2010-2013 Groupement d'Intérêt Public pour
+ * l'Education Numérique en Afrique (GIP ENA)
+ *
+ * This file is part of OpenBoard.
+ *
+ * OpenBoard is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3 of the License,
+ * with a specific linking exception for the OpenSSL project's
+ * "OpenSSL" library (or with modified versions of it that use the
+ * same license as the "OpenSSL" library).
+ *
+ * OpenBoard is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with OpenBoard. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+
+
+
+
+
+#ifndef PDFRENDERPOOL_H
+#define PDFRENDERPOOL_H
+
+#include <QElapsedTimer>
+#include <QHash>
+#include <QList>
+#include <QMutex>
+#include <QRect>
+#include <QThreadPool>
+#include <QWaitCondition>
+
+#include "PDFTileCache.h"
+
+class XPDFRenderer;
+
+/**
+ * Renders the PDF tiles of all renderers on one thread pool sized to the cores.
+ *
+ * Each job is rendered with a document instance of its renderer owned by the running
+ * worker, as poppler does not support concurrent rendering with one PDFDoc.
+ *
+ * Queued jobs run by priority, the most recently requested first. A job which was not
+ * requested again for a while is dropped when new tiles are requested: the page is not
+ * displayed anymore. Its renderer is asked to update, so that the tiles still displayed
+ * are requested again.
+ */
+class PDFRenderPool
+{
+    public:
+        enum Priority
+        {
+            VisibleTile = 0,
+            NeighbourTile,
+            PreviewTile
+        };
+
+        static PDFRenderPool* pool();
+
+        // called on the GUI thread, which computes the geometry of the tile
+        void request(XPDFRenderer* renderer, const PDFTileCache::Key& key, double dpi, const QRect& slice, Priority priority);
+
+        // drops the queued jobs of a renderer and waits for its running ones
+        void cancel(XPDFRenderer* renderer);
+
+        int maxThreadCount() const;
+
+    private:
+        PDFRenderPool();
+
+        struct Job
+        {
+            XPDFRenderer* renderer;
+            PDFTileCache::Key key;
+            double dpi;
+            QRect slice;
+            Priority priority;
+            qint64 requested;
+        };
+
+        void work();
+        QList<XPDFRenderer*> dropStaleJobs();
+
+        QThreadPool mThreadPool;
+        QElapsedTimer mClock;
+
+        QMutex mMutex;
+        QWaitCondition mJobFinished;
+        QList<Job> mQueue;
+        QHash<XPDFRenderer*, int> mRunning;
+        int mWorkers;
+};
+
+#endif // PDFRENDERPOOL_H
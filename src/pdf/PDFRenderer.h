@@ -34,6 +34,7 @@
 #include <QSizeF>
 #include <QRect>
 #include <QByteArray>
+#include <QImage>
 #include <QUuid>
 #include <QMap>
 #include <QPointer>
@@ -70,6 +71,9 @@ class PDFRenderer : public QObject
 
         virtual void render(QPainter *p, int pageNumber, bool const cacheAllowed, const QRectF &bounds = QRectF()) = 0;
 
+        //! Renders a whole page with the given width, can be called on any thread.
+        virtual QImage renderThumbnail(int pageNumber, int width) = 0;
+
     private:
         QAtomicInt mRefCount;
         QByteArray mFileData;
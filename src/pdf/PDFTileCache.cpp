@@ -0,0 +1,83 @@
+/*
+ * Copyright (C) 2015-2022 Département de l'Instruction Publique (DIP-SEM)
+ *
+ * Copyright (C) 2013 Open Education Foundation
+ *
+ * Copyright (C) 2010-2013 Groupement d'Intérêt Public pour
+ * l'Education Numérique en Afrique (GIP ENA)
+ *
+ * This file is part of OpenBoard.
+ *
+ * OpenBoard is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3 of the License,
+ * with a specific linking exception for the OpenSSL project's
+ * "OpenSSL" library (or with modified versions of it that use the
+ * same license as the "OpenSSL" library).
+ *
+ * OpenBoard is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with OpenBoard. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+
+
+
+
+
+#include "PDFTileCache.h"
+
+#include <QCache>
+#include <QMutex>
+
+#include <limits>
+
+#include "core/memcheck.h"
+
+namespace
+{
+    // the costs are counted in kilobytes, so that large budgets fit in an int
+    QMutex sTilesMutex;
+    QCache<PDFTileCache::Key, QImage> sTiles(128 * 1024);
+
+    int tileCost(const QImage& tile)
+    {
+        return qMax(1, int(qint64(tile.bytesPerLine()) * tile.height() / 1024));
+    }
+}
+
+void PDFTileCache::setBudget(qint64 bytes)
+{
+    QMutexLocker locker(&sTilesMutex);
+    sTiles.setMaxCost(int(qBound<qint64>(1, bytes / 1024, std::numeric_limits<int>::max())));
+}
+
+QImage PDFTileCache::tile(const Key& key)
+{
+    QMutexLocker locker(&sTilesMutex);
+    QImage* tile = sTiles.object(key);
+
+    return tile ? *tile : QImage();
+}
+
+void PDFTileCache::insert(const Key& key, const QImage& tile)
+{
+    QMutexLocker locker(&sTilesMutex);
+    sTiles.insert(key, new QImage(tile), tileCost(tile));
+}
+
+void PDFTileCache::remove(int renderer)
+{
+    QMutexLocker locker(&sTilesMutex);
+
+    foreach(const Key& key, sTiles.keys())
+    {
+        if (key.renderer == renderer)
+            sTiles.remove(key);
+    }
+}
@@ -0,0 +1,90 @@
+/*
+ * Copyright (C) 2015-2022 Département de l'Instruction Publique (DIP-SEM)
+ *
+ * Copyright (C) 2013 Open Education Foundation
+ *
+ * Copyright (C) 2010-2013 Groupement d'Intérêt Public pour
+ * l'Education Numérique en Afrique (GIP ENA)
+ *
+ * This file is part of OpenBoard.
+ *
+ * OpenBoard is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3 of the License,
+ * with a specific linking exception for the OpenSSL project's
+ * "OpenSSL" library (or with modified versions of it that use the
+ * same license as the "OpenSSL" library).
+ *
+ * OpenBoard is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with OpenBoard. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+
+
+
+
+
+#ifndef PDFTILECACHE_H
+#define PDFTILECACHE_H
+
+#include <QHash>
+#include <QImage>
+
+/**
+ * Rendered PDF tiles of all open renderers, bounded by one memory budget.
+ *
+ * A tile is a fixed size part of a page rendered at one of the zoom levels of the
+ * renderer. The least recently drawn tiles are dropped first. The cache may be used
+ * from any thread.
+ */
+class PDFTileCache
+{
+    public:
+        struct Key
+        {
+            int renderer;
+            int pageNumber;
+            int zoomIndex;
+            int x;
+            int y;
+
+            bool operator==(const Key& other) const
+            {
+                return renderer == other.renderer && pageNumber == other.pageNumber && zoomIndex == other.zoomIndex
+                        && x == other.x && y == other.y;
+            }
+        };
+
+        // edge length of a tile in pixels
+        static const int tileSize = 512;
+
+        static void setBudget(qint64 bytes);
+
+        // returns a null image if the tile is not rendered
+        static QImage tile(const Key& key);
+        static void insert(const Key& key, const QImage& tile);
+
+        // drops the tiles of a closed renderer
+        static void remove(int renderer);
+
+    private:
+        PDFTileCache() {}
+};
+
+inline uint qHash(const PDFTileCache::Key& key)
+{
+    uint hash = qHash(key.renderer);
+    hash ^= qHash(key.pageNumber) + 0x9e3779b9 + (hash << 6) + (hash >> 2);
+    hash ^= qHash(key.zoomIndex) + 0x9e3779b9 + (hash << 6) + (hash >> 2);
+    hash ^= qHash(key.x) + 0x9e3779b9 + (hash << 6) + (hash >> 2);
+    hash ^= qHash(key.y) + 0x9e3779b9 + (hash << 6) + (hash >> 2);
+    return hash;
+}
+
+#endif // PDFTILECACHE_H
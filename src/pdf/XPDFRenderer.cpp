@@ -39,6 +39,7 @@
 
 
 QAtomicInt XPDFRenderer::sInstancesCount = 0;
+QAtomicInt XPDFRenderer::sNextRendererId = 0;
 
 namespace constants{
     SplashColor paperColor = {0xFF, 0xFF, 0xFF}; // white
@@ -48,6 +49,8 @@ XPDFRenderer::XPDFRenderer(const QString &filename, bool importingFile)
     : mpSplashBitmapUncached(nullptr)
     , mSplashUncached(nullptr)
     , mDocument(nullptr)
+    , mFileName(filename)
+    , mRendererId(sNextRendererId.fetchAndAddRelaxed(1))
 {
     Q_UNUSED(importingFile);
     if (!globalParams)
@@ -61,18 +64,13 @@ XPDFRenderer::XPDFRenderer(const QString &filename, bool importingFile)
 #endif
         globalParams->setupBaseFonts(QFile::encodeName(UBPlatformUtils::applicationResourcesDirectory() + "/" + "fonts").data());
     }
-#if POPPLER_VERSION_MAJOR > 22 || (POPPLER_VERSION_MAJOR == 22 && POPPLER_VERSION_MINOR >= 3)
-    mDocument = new PDFDoc(std::make_unique<GooString>(filename.toLocal8Bit()));
-#else
-    mDocument = new PDFDoc(new GooString(filename.toLocal8Bit()), 0, 0, 0); // the filename GString is deleted on PDFDoc desctruction
-#endif
+    mDocument = openDocument(filename);
 
     if (isValid())
     {
-        initPDFZoomData();
+        PDFTileCache::setBudget(UBSettings::settings()->pdfTileCacheBudget->get().toLongLong() * 1024 * 1024);
 
         sInstancesCount.ref();
-        connect(&m_cacheThread, SIGNAL(finished()), this, SLOT(OnThreadFinished()));
     }
     else
     {
@@ -82,25 +80,16 @@ XPDFRenderer::XPDFRenderer(const QString &filename, bool importingFile)
 
 XPDFRenderer::~XPDFRenderer()
 {
-    disconnect(&m_cacheThread, SIGNAL(finished()), this, SLOT(OnThreadFinished()));
-    m_cacheThread.cancelPending();
-    m_cacheThread.wait(XPDFThreadMaxTimeoutOnExit::timeout_ms);
-    if (m_cacheThread.isRunning())
-    {
-        // Kill the thread, which might still run for minutes if the user choose a heavy pdf highly zoomed.
-        // Since there is no data written, but only processing, this is safe on a modern OS.
-        m_cacheThread.terminate();
-    }
+    // Tiles are small, running jobs do not take long.
+    PDFRenderPool::pool()->cancel(this);
 
-    foreach (QVector<PdfZoomCacheData> v, m_perPagepdfZoomCache)
+    foreach (PDFDoc *document, mRenderDocuments)
     {
-        for(int i = 0; i < v.size(); i++)
-        {
-            PdfZoomCacheData &cacheData = v[i];
-            cacheData.cleanup();
-        }
+        delete document;
     }
 
+    PDFTileCache::remove(mRendererId);
+
     if(mSplashUncached)
         delete mSplashUncached;
 
@@ -121,18 +110,13 @@ XPDFRenderer::~XPDFRenderer()
     }
 }
 
-void XPDFRenderer::initPDFZoomData()
+PDFDoc* XPDFRenderer::openDocument(const QString &filename)
 {
-    for (int i=1; i <= mDocument->getNumPages(); i++)
-    {
-        m_perPagepdfZoomCache.insert(i, QVector<PdfZoomCacheData>());
-
-        for (int j = 0; j < XPDFRendererZoomFactor::zoomFactorIterations; j++ )
-        {
-            double const zoomValue = XPDFRendererZoomFactor::zoomFactorStart+XPDFRendererZoomFactor::zoomFactorStepSquare*static_cast<double>(j*j);
-            m_perPagepdfZoomCache[i].push_back(zoomValue);
-        }
-    }
+#if POPPLER_VERSION_MAJOR > 22 || (POPPLER_VERSION_MAJOR == 22 && POPPLER_VERSION_MINOR >= 3)
+    return new PDFDoc(std::make_unique<GooString>(filename.toLocal8Bit()));
+#else
+    return new PDFDoc(new GooString(filename.toLocal8Bit()), 0, 0, 0); // the filename GString is deleted on PDFDoc desctruction
+#endif
 }
 
 bool XPDFRenderer::isValid() const
@@ -264,180 +248,295 @@ QImage* XPDFRenderer::createPDFImageUncached(int pageNumber, qreal xscale, qreal
     return new QImage(mpSplashBitmapUncached->getDataPtr(), mpSplashBitmapUncached->getWidth(), mpSplashBitmapUncached->getHeight(), mpSplashBitmapUncached->getWidth() * 3, QImage::Format_RGB888);
 }
 
-void XPDFRenderer::OnThreadFinished()
-{
-    emit signalUpdateParent();
-    if (m_cacheThread.isJobPending())
-        m_cacheThread.start();
-}
-
 void XPDFRenderer::render(QPainter *p, int pageNumber, bool const cacheAllowed, const QRectF &bounds)
 {
-    //qDebug() << "render enter";
-    Q_UNUSED(bounds);
     if (isValid())
     {
-        if (m_perPagepdfZoomCache.contains(pageNumber) && m_perPagepdfZoomCache[pageNumber].size() > 0 && cacheAllowed)
+        if (cacheAllowed)
         {
+            renderTiles(p, pageNumber, bounds);
+        } else {
             qreal xscale = p->worldTransform().m11();
             qreal yscale = p->worldTransform().m22();
-            Q_ASSERT(qFuzzyCompare(xscale, yscale)); // Zoom equal in all axes expected.
-            Q_ASSERT(xscale > 0.0); // Potential Div0 later if this assert fail.
 
-            qreal zoomRequested = xscale;
-            int zoomIndex = 0;
+            QImage *pdfImage = createPDFImageUncached(pageNumber, xscale, yscale, bounds);
+            QTransform savedTransform = p->worldTransform();
+            p->resetTransform();
+            p->drawImage(QPointF(savedTransform.dx() + mSliceX, savedTransform.dy() + mSliceY), *pdfImage);
+            p->setWorldTransform(savedTransform);
+            delete pdfImage;
+        }
+    }
+}
+
+double XPDFRenderer::zoomRatio(int zoomIndex)
+{
+    return XPDFRendererZoomFactor::zoomFactorStart + XPDFRendererZoomFactor::zoomFactorStepSquare * static_cast<double>(zoomIndex * zoomIndex);
+}
 
-            // Choose a zoom which is superior or equivalent than the user choice (= no loss, upscaling).
-            bool foundIndex = false;
-            for (; zoomIndex < m_perPagepdfZoomCache[pageNumber].size() && !foundIndex;)
-            {
-                if (zoomRequested <= (m_perPagepdfZoomCache[pageNumber][zoomIndex].ratio+0.1)) {
-                    foundIndex = true;
-                } else {
-                    zoomIndex++;
-                }
-            }
+int XPDFRenderer::zoomIndexFor(qreal scale) const
+{
+    // Choose a zoom which is superior or equivalent than the user choice (= no loss, upscaling).
+    int zoomIndex = 0;
 
-            if (!foundIndex) // Use the previous one.
-                zoomIndex--;
+    while (zoomIndex < XPDFRendererZoomFactor::zoomFactorIterations - 1 && scale > zoomRatio(zoomIndex) + 0.1)
+        zoomIndex++;
 
-            QImage pdfImage = createPDFImageCached(pageNumber, m_perPagepdfZoomCache[pageNumber][zoomIndex]);
-            qreal ratioExpected = m_perPagepdfZoomCache[pageNumber][zoomIndex].ratio;
-            qreal ratioObtained = ratioExpected;
-            int const initialZoomIndex = zoomIndex;
+    return zoomIndex;
+}
 
-            if (pdfImage == QImage() && m_perPagepdfZoomCache[pageNumber][zoomIndex].hasToBeProcessed)
+QSize XPDFRenderer::pagePixelSize(int pageNumber, int zoomIndex) const
+{
+    const QSizeF size = pageSizeF(pageNumber) * zoomRatio(zoomIndex);
+
+    return QSize(qCeil(size.width()), qCeil(size.height()));
+}
+
+QList<PDFTileCache::Key> XPDFRenderer::tilesFor(int pageNumber, int zoomIndex, const QRectF &rect) const
+{
+    QList<PDFTileCache::Key> tiles;
+
+    const QSize pixelSize = pagePixelSize(pageNumber, zoomIndex);
+    const double ratio = zoomRatio(zoomIndex);
+
+    if (pixelSize.isEmpty() || rect.isEmpty())
+        return tiles;
+
+    const int tileSize = PDFTileCache::tileSize;
+    const int firstX = qBound(0, qFloor(rect.left() * ratio / tileSize), (pixelSize.width() - 1) / tileSize);
+    const int lastX = qBound(0, qCeil(rect.right() * ratio / tileSize) - 1, (pixelSize.width() - 1) / tileSize);
+    const int firstY = qBound(0, qFloor(rect.top() * ratio / tileSize), (pixelSize.height() - 1) / tileSize);
+    const int lastY = qBound(0, qCeil(rect.bottom() * ratio / tileSize) - 1, (pixelSize.height() - 1) / tileSize);
+
+    for (int y = firstY; y <= lastY; y++)
+    {
+        for (int x = firstX; x <= lastX; x++)
+        {
+            tiles << PDFTileCache::Key{mRendererId, pageNumber, zoomIndex, x, y};
+        }
+    }
+
+    return tiles;
+}
+
+QRect XPDFRenderer::tilePixelRect(const PDFTileCache::Key &key) const
+{
+    const int tileSize = PDFTileCache::tileSize;
+    const QRect tileRect(key.x * tileSize, key.y * tileSize, tileSize, tileSize);
+
+    return tileRect.intersected(QRect(QPoint(0, 0), pagePixelSize(key.pageNumber, key.zoomIndex)));
+}
+
+void XPDFRenderer::renderTiles(QPainter *p, int pageNumber, const QRectF &bounds)
+{
+    const QRectF pageRect(QPointF(0, 0), pageSizeF(pageNumber));
+    const QRectF exposedRect = bounds.isNull() ? pageRect : bounds.intersected(pageRect);
+
+    qreal xscale = p->worldTransform().m11();
+    Q_ASSERT(xscale > 0.0); // Potential Div0 later if this assert fail.
+
+    const int zoomIndex = zoomIndexFor(xscale);
+    const double ratio = zoomRatio(zoomIndex);
+
+    bool drawnAny = false;
+
+    foreach(const PDFTileCache::Key &key, tilesFor(pageNumber, zoomIndex, exposedRect))
+    {
+        QImage tile = PDFTileCache::tile(key);
+
+        if (!tile.isNull())
+        {
+            drawTile(p, key, tile);
+            drawnAny = true;
+            continue;
+        }
+
+        requestTile(key, PDFRenderPool::VisibleTile);
+
+        // Temporarily fallback on other zoom levels, for a fuzzy or downsampled preview.
+        // The actual result will be updated after the processing.
+        const QRect pixelRect = tilePixelRect(key);
+        const QRectF tileRect(pixelRect.x() / ratio, pixelRect.y() / ratio, pixelRect.width() / ratio, pixelRect.height() / ratio);
+        const QRectF missingRect = tileRect.intersected(exposedRect);
+
+        if (drawFallbackTiles(p, pageNumber, zoomIndex, missingRect))
+        {
+            drawnAny = true;
+        }
+        else
+        {
+            p->fillRect(missingRect, Qt::white);
+        }
+    }
+
+    if (!drawnAny && !exposedRect.isEmpty())
+    {
+        // Nothing rendered yet for this part of the page, display some progress.
+        p->drawText(exposedRect, Qt::AlignCenter, tr("Processing..."));
+    }
+
+    // Then the tiles around, for scrolling.
+    const qreal margin = PDFTileCache::tileSize / ratio;
+
+    foreach(const PDFTileCache::Key &key, tilesFor(pageNumber, zoomIndex, exposedRect.adjusted(-margin, -margin, margin, margin)))
+    {
+        if (PDFTileCache::tile(key).isNull())
+            requestTile(key, PDFRenderPool::NeighbourTile);
+    }
+
+    // Then a preview of the whole page, shown meanwhile when zooming.
+    if (zoomIndex > 0)
+    {
+        foreach(const PDFTileCache::Key &key, tilesFor(pageNumber, 0, pageRect))
+        {
+            if (PDFTileCache::tile(key).isNull())
+                requestTile(key, PDFRenderPool::PreviewTile);
+        }
+    }
+}
+
+void XPDFRenderer::drawTile(QPainter *p, const PDFTileCache::Key &key, const QImage &tile)
+{
+    QTransform savedTransform = p->worldTransform();
+
+    // The tile is rendered with the quality of its zoom level, scale it to the world transform.
+    double const ratioDifferenceBetweenWorldAndImage = 1.0 / zoomRatio(key.zoomIndex);
+    p->setWorldTransform(QTransform(savedTransform).scale(ratioDifferenceBetweenWorldAndImage, ratioDifferenceBetweenWorldAndImage));
+    p->drawImage(tilePixelRect(key).topLeft(), tile);
+
+    p->setWorldTransform(savedTransform);
+}
+
+bool XPDFRenderer::drawFallbackTiles(QPainter *p, int pageNumber, int zoomIndex, const QRectF &rect)
+{
+    // nearest zoom levels first, finer before coarser
+    for (int distance = 1; distance < XPDFRendererZoomFactor::zoomFactorIterations; distance++)
+    {
+        for (int fallbackIndex : {zoomIndex + distance, zoomIndex - distance})
+        {
+            if (fallbackIndex < 0 || fallbackIndex >= XPDFRendererZoomFactor::zoomFactorIterations)
+                continue;
+
+            QList<QImage> fallbackTiles;
+            const QList<PDFTileCache::Key> keys = tilesFor(pageNumber, fallbackIndex, rect);
+
+            foreach(const PDFTileCache::Key &key, keys)
             {
-                // Try to temporarily fallback on a valid image, for a fuzzy or downsampled preview.
-                // The actual result will be updated after the processing.
-                bool isCurrent = true;
-                while (zoomIndex < m_perPagepdfZoomCache[pageNumber].size()-1 && (m_perPagepdfZoomCache[pageNumber][zoomIndex].cachedImage == QImage() || (m_perPagepdfZoomCache[pageNumber][zoomIndex].cachedPageNumber != pageNumber && !isCurrent)))
-                {
-                    zoomIndex = zoomIndex+1;
-                    isCurrent = false;
-                }
-                while (zoomIndex > 0 && (m_perPagepdfZoomCache[pageNumber][zoomIndex].cachedImage == QImage() || m_perPagepdfZoomCache[pageNumber][zoomIndex].cachedPageNumber != pageNumber))
-                    zoomIndex = zoomIndex-1;
-                ratioObtained = m_perPagepdfZoomCache[pageNumber][zoomIndex].ratio;
+                QImage tile = PDFTileCache::tile(key);
+
+                if (tile.isNull())
+                    break;
+
+                fallbackTiles << tile;
             }
 
-            if (m_perPagepdfZoomCache[pageNumber][zoomIndex].cachedImage == QImage() || m_perPagepdfZoomCache[pageNumber][zoomIndex].cachedPageNumber != pageNumber)
+            if (keys.isEmpty() || fallbackTiles.size() != keys.size())
+                continue;
+
+            p->save();
+            p->setClipRect(rect, Qt::IntersectClip);
+
+            for (int i = 0; i < keys.size(); i++)
             {
-                // No alternate image found. Build an alternate image in order to display some progress.
-                // Also make sure we fallback to the initial ratio request.
-                zoomIndex = initialZoomIndex;
-                qreal ratioDiff = m_perPagepdfZoomCache[pageNumber][zoomIndex].ratio;
-                pdfImage = QImage(bounds.width()*ratioDiff, bounds.height()*ratioDiff, QImage::Format_RGB888);
-                pdfImage.fill("white");
-
-                QPainter painter(&pdfImage);
-                QString const text = tr("Processing...");
-                QFont font = painter.font();
-                if (font.pixelSize() != -1)
-                    font.setPixelSize(ratioDiff*font.pixelSize());
-                else
-                    font.setPointSizeF(ratioDiff*font.pointSizeF());
-                painter.setFont(font);
-                QFontMetrics textMetric(font, &pdfImage);
-                QSize textSize = textMetric.size(0, text);
-                painter.drawText((bounds.width()*ratioDiff-textSize.width())/2, (bounds.height()*ratioDiff-textSize.height())/2, text);
-            } else {
-                pdfImage = m_perPagepdfZoomCache[pageNumber][zoomIndex].cachedImage;
+                drawTile(p, keys.at(i), fallbackTiles.at(i));
             }
 
-            QTransform savedTransform = p->worldTransform();
+            p->restore();
+            return true;
+        }
+    }
 
-            double const ratioDifferenceBetweenWorldAndImage = 1.0/m_perPagepdfZoomCache[pageNumber][zoomIndex].ratio;
-            // The 'pdfImage' is maybe rendered with a different quality than requested. We adjust the 'transform' to zoom it
-            // in or out of the required ratio.
-            QTransform newTransform = savedTransform.scale(ratioDifferenceBetweenWorldAndImage, ratioDifferenceBetweenWorldAndImage);
-            p->setWorldTransform(newTransform);
-            /* qDebug() << "drawImage size=" << p->viewport() << "bounds" << bounds <<
-                        "pdfImage" << pdfImage.size() << "savedTransform" << savedTransform.m11() <<
-                        "ratioDiff" << ratioDifferenceBetweenWorldAndImage << "zoomRequested" << zoomRequested <<
-                        "zoomIndex" << zoomIndex; */
-            p->drawImage(QPointF( mSliceX,  mSliceY), pdfImage);
+    return false;
+}
 
-            p->setWorldTransform(savedTransform);
-        } else {
-            qreal xscale = p->worldTransform().m11();
-            qreal yscale = p->worldTransform().m22();
+void XPDFRenderer::requestTile(const PDFTileCache::Key &key, PDFRenderPool::Priority priority)
+{
+    // The geometry is computed with the document of the GUI thread.
+    PDFRenderPool::pool()->request(this, key, this->dpiForRendering * zoomRatio(key.zoomIndex), tilePixelRect(key), priority);
+}
 
-            QImage *pdfImage = createPDFImageUncached(pageNumber, xscale, yscale, bounds);
-            QTransform savedTransform = p->worldTransform();
-            p->resetTransform();
-            //qDebug() << "drawImage size=" << p->viewport() << "bounds" << bounds << "pdfImage" << pdfImage->size() << "savedTransform" << savedTransform.m11();
-            p->drawImage(QPointF(savedTransform.dx() + mSliceX, savedTransform.dy() + mSliceY), *pdfImage);
-            p->setWorldTransform(savedTransform);
-            delete pdfImage;
-        }
+PDFDoc* XPDFRenderer::acquireDocument()
+{
+    {
+        QMutexLocker lock(&mRenderDocumentsMutex);
+
+        if (!mRenderDocuments.isEmpty())
+            return mRenderDocuments.takeLast();
     }
-    //qDebug() << "render leave";
+
+    return openDocument(mFileName);
 }
 
-QImage& XPDFRenderer::createPDFImageCached(int pageNumber, PdfZoomCacheData &cacheData)
+void XPDFRenderer::releaseDocument(PDFDoc *document)
 {
-    if (isValid())
+    QMutexLocker lock(&mRenderDocumentsMutex);
+    mRenderDocuments << document;
+}
+
+void XPDFRenderer::renderTile(const PDFTileCache::Key &key, double dpi, const QRect &slice)
+{
+    PDFDoc *document = acquireDocument();
+
+    if (document->isOk())
     {
-        if (cacheData.requireUpdateImage(pageNumber) && !cacheData.hasToBeProcessed)
-        {
-            mSliceX = 0.;
-            mSliceY = 0.;
-
-            CacheThread::JobData jobData;
-            jobData.cacheData = &cacheData;
-            jobData.document = mDocument;
-            jobData.dpiForRendering = this->dpiForRendering;
-            jobData.pageNumber = pageNumber;
-            jobData.cacheData->hasToBeProcessed = true;
-            // Make sure we reset that image, because the data uses 'splash' buffer, which will be deallocated and
-            // reallocated when the job is started.
-            jobData.cacheData->cachedImage = QImage();
-            m_cacheThread.pushJob(jobData);
-
-            // Start the job multithreaded. The item will be refreshed when the signal 'finished' is emitted.
-            m_cacheThread.start();
-        }
-    } else {
-        cacheData.cachedImage = QImage();
+        SplashOutputDev splash(splashModeRGB8, 1, false, constants::paperColor);
+        splash.startDoc(document);
+
+        int rotation = 0; // in degrees (get it from the worldTransform if we want to support rotation)
+        bool useMediaBox = false;
+        bool crop = true;
+        bool printing = false;
+
+        // Only the tile is rasterized, whatever the size of the page.
+        document->displayPageSlice(&splash, key.pageNumber, dpi, dpi, rotation, useMediaBox, crop, printing,
+                                   slice.x(), slice.y(), slice.width(), slice.height());
+
+        SplashBitmap* bitmap = splash.getBitmap();
+
+        // The bitmap data belongs to 'splash', keep a copy.
+        QImage tile = QImage(bitmap->getDataPtr(), bitmap->getWidth(), bitmap->getHeight(), bitmap->getRowSize(), QImage::Format_RGB888).copy();
+        PDFTileCache::insert(key, tile);
     }
 
-    return cacheData.cachedImage;
+    releaseDocument(document);
 }
 
-void XPDFRenderer::CacheThread::run()
+QImage XPDFRenderer::renderThumbnail(int pageNumber, int width)
 {
-    m_jobMutex.lock();
+    QImage thumbnail;
 
-    CacheThread::JobData jobData = m_nextJob.first();
-    m_nextJob.pop_front();
-    /* qDebug() << "XPDFRenderer::CacheThread starting page" << jobData.pageNumber
-             << "ratio" << jobData.cacheData->ratio; */
+    if (!isValid())
+        return thumbnail;
 
-    jobData.cacheData->prepareNewSplash(jobData.pageNumber, constants::paperColor);
-    jobData.cacheData->splash->startDoc(jobData.document);
+    PDFDoc *document = acquireDocument();
 
-    m_jobMutex.unlock();
+    if (document->isOk() && pageNumber >= 1 && pageNumber <= document->getNumPages())
+    {
+        int rotate = document->getPageRotate(pageNumber);
+        double pointWidth = (rotate == 90 || rotate == 270) ? document->getPageCropHeight(pageNumber) : document->getPageCropWidth(pageNumber);
+
+        if (pointWidth > 0)
+        {
+            double const dpi = 72.0 * width / pointWidth;
 
-    int rotation = 0; // in degrees (get it from the worldTransform if we want to support rotation)
-    bool useMediaBox = false;
-    bool crop = true;
-    bool printing = false;
+            SplashOutputDev splash(splashModeRGB8, 1, false, constants::paperColor);
+            splash.startDoc(document);
 
-    jobData.document->displayPage(jobData.cacheData->splash, jobData.pageNumber, jobData.dpiForRendering * jobData.cacheData->ratio,
-                                  jobData.dpiForRendering * jobData.cacheData->ratio,
-                           rotation, useMediaBox, crop, printing);
+            int rotation = 0; // in degrees (get it from the worldTransform if we want to support rotation)
+            bool useMediaBox = false;
+            bool crop = true;
+            bool printing = false;
 
-    m_jobMutex.lock();
-    jobData.cacheData->splashBitmap = jobData.cacheData->splash->getBitmap();
-    // Note this uses the 'cacheData.splash->getBitmap()->getDataPtr()' as data buffer.
-    jobData.cacheData->cachedImage = QImage(jobData.cacheData->splashBitmap->getDataPtr(), jobData.cacheData->splashBitmap->getWidth(), jobData.cacheData->splashBitmap->getHeight(),
-                           jobData.cacheData->splashBitmap->getWidth() * 3 /* bytesPerLine, 24 bits for RGB888, = 3 bytes */,
-                           QImage::Format_RGB888);
+            document->displayPage(&splash, pageNumber, dpi, dpi, rotation, useMediaBox, crop, printing);
+
+            SplashBitmap* bitmap = splash.getBitmap();
+
+            // The bitmap data belongs to 'splash', keep a copy.
+            thumbnail = QImage(bitmap->getDataPtr(), bitmap->getWidth(), bitmap->getHeight(), bitmap->getRowSize(), QImage::Format_RGB888).copy();
+        }
+    }
 
-    /* qDebug() << "XPDFRenderer::CacheThread completed page" << jobData.pageNumber
-             << "ratio" << jobData.cacheData->ratio << "final size is" << jobData.cacheData->cachedImage.size(); */
+    releaseDocument(document);
 
-    jobData.cacheData->hasToBeProcessed = false;
-    m_jobMutex.unlock();
+    return thumbnail;
 }
@@ -31,9 +31,10 @@
 #define XPDFRENDERER_H
 
 #include <QImage>
-#include <QThread>
 #include <QMutexLocker>
 #include "PDFRenderer.h"
+#include "PDFRenderPool.h"
+#include "PDFTileCache.h"
 #include <splash/SplashBitmap.h>
 
 #include "globals/UBGlobals.h"
@@ -53,11 +54,6 @@ namespace XPDFRendererZoomFactor
     const double zoomFactorIterations = 7;
 }
 
-namespace XPDFThreadMaxTimeoutOnExit
-{
-    const double timeout_ms = 3000;
-}
-
 class XPDFRenderer : public PDFRenderer
 {
     Q_OBJECT
@@ -66,7 +62,6 @@ class XPDFRenderer : public PDFRenderer
         XPDFRenderer(const QString &filename, bool importingFile = false);
         virtual ~XPDFRenderer();
 
-        void initPDFZoomData();
         virtual bool isValid() const override;
         virtual int pageCount() const override;
         virtual QSizeF pageSizeF(int pageNumber) const override;
@@ -74,6 +69,7 @@ class XPDFRenderer : public PDFRenderer
         virtual QSizeF pointSizeF(int pageNumber) const override;
         virtual QString title() const override;
         virtual void render(QPainter *p, int pageNumber, const bool cacheAllowed, const QRectF &bounds = QRectF()) override;
+        virtual QImage renderThumbnail(int pageNumber, int width) override;
 
     signals:
         void signalUpdateParent();
@@ -81,76 +77,28 @@ class XPDFRenderer : public PDFRenderer
     private:
         void init();
 
-        struct PdfZoomCacheData {
-            PdfZoomCacheData() : splashBitmap(nullptr), cachedPageNumber(-1), splash(nullptr), ratio(1.0), hasToBeProcessed(false) {};
-            PdfZoomCacheData(double const a_ratio) : splashBitmap(nullptr), cachedPageNumber(-1), splash(nullptr), ratio(a_ratio), hasToBeProcessed(false) {};
-            ~PdfZoomCacheData() {};
-            SplashBitmap* splashBitmap;
-            //! Note: The 'cachedImage' uses a buffer from 'splash'. Make sure it is invalidated BEFORE 'splash' deallocation.
-            QImage cachedImage;
-            int cachedPageNumber;
-            SplashOutputDev* splash;
-            double ratio;
-            bool hasToBeProcessed;
-            QList<QObject *> updateListAfterProcessing;
-
-            bool requireUpdateImage(int const pageNumber) const {
-                return (pageNumber != cachedPageNumber) || (splash == nullptr);
-            }
-
-            void prepareNewSplash(int const pageNumber, SplashColor &paperColor)
-            {
-                if(splash != nullptr)
-                {
-                    cachedImage = QImage();
-                    delete splash;
-                }
-                splash = new SplashOutputDev(splashModeRGB8, 1, false, paperColor);
-                cachedPageNumber = pageNumber;
-            }
-
-            void cleanup()
-            {
-                if(splash != nullptr){
-                    cachedImage = QImage();
-                    delete splash;
-                    splash = nullptr;
-                }
-            }
-        };
-
-        //! Spawned when a pdf processing is required, when no matching image is found in cache.
-        class CacheThread : public QThread
-        {
-        public:
-            struct JobData {
-                PdfZoomCacheData* cacheData;
-                PDFDoc *document;
-                int pageNumber;
-                double dpiForRendering;
-            };
-
-            CacheThread() {}
-            ~CacheThread() {}
-            void pushJob(JobData &jobData) {               
-                QMutexLocker lock(&m_jobMutex);
-                m_nextJob.push_back(jobData);
-            }
-
-            virtual void run() override;
-            bool isJobPending() { QMutexLocker lock(&m_jobMutex); return m_nextJob.size() > 0; }
-            void cancelPending() { QMutexLocker lock(&m_jobMutex); m_nextJob.clear(); }
-        private:
-            QList<JobData> m_nextJob;
-            QMutex m_jobMutex;
-        };
-
-        CacheThread m_cacheThread;
-
-        QImage &createPDFImageCached(int pageNumber, PdfZoomCacheData &cacheData);
-        QImage* createPDFImageUncached(int pageNumber, qreal xscale, qreal yscale, const QRectF &bounds);
+        friend class PDFRenderPool;
+
+        static PDFDoc* openDocument(const QString &filename);
+
+        //! Called on a render pool thread, with a document instance not used by other threads.
+        void renderTile(const PDFTileCache::Key &key, double dpi, const QRect &slice);
+        PDFDoc* acquireDocument();
+        void releaseDocument(PDFDoc *document);
 
-        QMap<int, QVector<PdfZoomCacheData>> m_perPagepdfZoomCache;
+        static double zoomRatio(int zoomIndex);
+        int zoomIndexFor(qreal scale) const;
+
+        QSize pagePixelSize(int pageNumber, int zoomIndex) const;
+        QList<PDFTileCache::Key> tilesFor(int pageNumber, int zoomIndex, const QRectF &rect) const;
+        QRect tilePixelRect(const PDFTileCache::Key &key) const;
+
+        void renderTiles(QPainter *p, int pageNumber, const QRectF &bounds);
+        void drawTile(QPainter *p, const PDFTileCache::Key &key, const QImage &tile);
+        bool drawFallbackTiles(QPainter *p, int pageNumber, int zoomIndex, const QRectF &rect);
+        void requestTile(const PDFTileCache::Key &key, PDFRenderPool::Priority priority);
+
+        QImage* createPDFImageUncached(int pageNumber, qreal xscale, qreal yscale, const QRectF &bounds);
 
         // Used when no cache allowed (e.g. rendering to a file).
         SplashBitmap* mpSplashBitmapUncached;
@@ -158,12 +106,15 @@ class XPDFRenderer : public PDFRenderer
         SplashOutputDev* mSplashUncached;
 
         PDFDoc *mDocument;
+        QString mFileName;
+        // Used by the render pool threads, at most one per thread.
+        QList<PDFDoc*> mRenderDocuments;
+        QMutex mRenderDocumentsMutex;
         static QAtomicInt sInstancesCount;
+        static QAtomicInt sNextRendererId;
+        int mRendererId;
         qreal mSliceX;
         qreal mSliceY;
-
-private slots:
-        void OnThreadFinished();
 };
 
 #endif // XPDFRENDERER_H
@@ -1,8 +1,12 @@
 HEADERS      += src/pdf/GraphicsPDFItem.h \
                 src/pdf/PDFRenderer.h \
+                src/pdf/PDFRenderPool.h \
+                src/pdf/PDFTileCache.h \
                 src/pdf/XPDFRenderer.h
                 
 SOURCES      += src/pdf/GraphicsPDFItem.cpp \
                 src/pdf/PDFRenderer.cpp \
+                src/pdf/PDFRenderPool.cpp \
+                src/pdf/PDFTileCache.cpp \
                 src/pdf/XPDFRenderer.cpp
                           